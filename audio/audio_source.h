@@ -0,0 +1,39 @@
+#ifndef AUDIO_SOURCE_H
+#define AUDIO_SOURCE_H
+
+// The AudioSource class is the interface every producer of mono 16-bit audio
+// implements, so the detection pipeline does not care whether samples come
+// from a live microphone or from a recording on disk.
+class AudioSource {
+public:
+    virtual ~AudioSource() = default;
+
+    // Prepares the source. Returns true if successful, false otherwise.
+    virtual bool init() = 0;
+
+    // Starts delivering audio.
+    virtual void start() = 0;
+
+    // Stops delivering audio.
+    virtual void stop() = 0;
+
+    // Reads bufferSize samples into buffer, waiting for them if necessary.
+    // Returns the number of samples read, which is smaller only when the
+    // source stops or runs out of audio.
+    virtual int read(short* buffer, int bufferSize) = 0;
+
+    // Reads up to maxSamples samples that are ready right now, without waiting.
+    // Returns the number of samples read.
+    virtual int readAvailable(short* buffer, int maxSamples) = 0;
+
+    // Returns the number of samples that can be read without waiting.
+    virtual int available() const = 0;
+
+    // Checks if the source is currently delivering audio.
+    virtual bool isRunning() const = 0;
+
+    // Returns the sample rate of the delivered audio in Hz.
+    virtual int sampleRate() const = 0;
+};
+
+#endif  // AUDIO_SOURCE_H
@@ -0,0 +1,242 @@
+#define _USE_MATH_DEFINES
+#include <cmath>
+#include "fft.h"
+#include <algorithm>
+#include <stdexcept>
+
+namespace {
+
+// Complex product written out, so it compiles to plain multiply-adds instead
+// of the library call that handles infinities and NaNs
+template<typename T>
+inline std::complex<T> multiply(const std::complex<T>& a, const std::complex<T>& b) {
+    return std::complex<T>(a.real() * b.real() - a.imag() * b.imag(),
+                           a.real() * b.imag() + a.imag() * b.real());
+}
+
+// Bit-reversal permutation of half points, for the packed half-size transform
+std::vector<size_t> bitReversalTable(size_t half) {
+    size_t bits = 0;
+    while ((size_t(1) << bits) < half) {
+        bits++;
+    }
+    std::vector<size_t> table(half);
+    for (size_t i = 0; i < half; i++) {
+        size_t reversed = 0;
+        for (size_t b = 0; b < bits; b++) {
+            if (i & (size_t(1) << b)) {
+                reversed |= size_t(1) << (bits - 1 - b);
+            }
+        }
+        table[i] = reversed;
+    }
+    return table;
+}
+
+// Twiddle factors e^(-2*pi*i*k/size) for k < size / 2. The packed
+// half-size transform uses every second entry of the same table.
+std::vector<std::complex<double>> twiddleTable(size_t size) {
+    std::vector<std::complex<double>> table(size / 2);
+    for (size_t k = 0; k < table.size(); k++) {
+        double angle = -2.0 * M_PI * k / size;
+        table[k] = std::complex<double>(cos(angle), sin(angle));
+    }
+    return table;
+}
+
+template<typename T>
+void referenceDftImpl(const T* input, size_t size, std::complex<T>* output) {
+    // Simple implementation of the Discrete Fourier Transform (DFT)
+    for (size_t k = 0; k < size / 2; k++) {
+        std::complex<double> sum(0, 0);
+        for (size_t n = 0; n < size; n++) {
+            double angle = -2.0 * M_PI * k * n / size;
+            sum += static_cast<double>(input[n]) * std::complex<double>(cos(angle), sin(angle));
+        }
+        output[k] = std::complex<T>(static_cast<T>(sum.real()), static_cast<T>(sum.imag()));
+    }
+}
+
+// One radix-2 butterfly for every signal of a BatchFftPlanF tile. The rows
+// never overlap; saying so lets the compiler vectorize the loop without the
+// runtime alias checks its cheaper optimization levels refuse to emit.
+template<size_t Width>
+inline void batchButterfly(float wr, float wi, float* __restrict ur, float* __restrict ui,
+                           float* __restrict vr, float* __restrict vi) {
+    for (size_t b = 0; b < Width; b++) {
+        float tr = wr * vr[b] - wi * vi[b];
+        float ti = wr * vi[b] + wi * vr[b];
+        float xr = ur[b], xi = ui[b];
+        ur[b] = xr + tr;
+        ui[b] = xi + ti;
+        vr[b] = xr - tr;
+        vi[b] = xi - ti;
+    }
+}
+
+} // namespace
+
+template<typename T>
+BasicFftPlan<T>::BasicFftPlan(size_t size) : size_(size), half_(size / 2) {
+    if (!isSupportedSize(size)) {
+        throw std::invalid_argument("FftPlan size must be a power of two and at least 4");
+    }
+
+    bitReverse_ = bitReversalTable(half_);
+
+    std::vector<std::complex<double>> twiddles = twiddleTable(size_);
+    twiddles_.resize(half_);
+    for (size_t k = 0; k < half_; k++) {
+        twiddles_[k] = std::complex<T>(static_cast<T>(twiddles[k].real()), static_cast<T>(twiddles[k].imag()));
+    }
+
+    packed_.resize(half_);
+}
+
+template<typename T>
+bool BasicFftPlan<T>::isSupportedSize(size_t size) {
+    return size >= 4 && (size & (size - 1)) == 0;
+}
+
+template<typename T>
+void BasicFftPlan<T>::forwardReal(const T* input, std::complex<T>* output) {
+    // Pack even samples into the real part and odd samples into the imaginary
+    // part, writing them directly in bit-reversed order
+    for (size_t n = 0; n < half_; n++) {
+        packed_[bitReverse_[n]] = std::complex<T>(input[2 * n], input[2 * n + 1]);
+    }
+
+    transformPacked();
+
+    // Split the packed spectrum into the spectra of the even and odd samples
+    // and combine them into the real-input spectrum
+    for (size_t k = 0; k < half_; k++) {
+        std::complex<T> z = packed_[k];
+        std::complex<T> zMirror = std::conj(packed_[k == 0 ? 0 : half_ - k]);
+        std::complex<T> even = (z + zMirror) * T(0.5);
+        std::complex<T> difference = z - zMirror;
+        std::complex<T> odd(difference.imag() * T(0.5), difference.real() * T(-0.5)); // (z - zMirror) * -i/2
+        output[k] = even + multiply(twiddles_[k], odd);
+    }
+}
+
+template<typename T>
+void BasicFftPlan<T>::transformPacked() {
+    // Iterative radix-2 decimation-in-time butterflies; input is already in
+    // bit-reversed order
+    for (size_t len = 2; len <= half_; len <<= 1) {
+        size_t halfLen = len / 2;
+        size_t twiddleStride = 2 * (half_ / len);
+        for (size_t start = 0; start < half_; start += len) {
+            for (size_t j = 0; j < halfLen; j++) {
+                std::complex<T> t = multiply(twiddles_[j * twiddleStride], packed_[start + j + halfLen]);
+                std::complex<T> u = packed_[start + j];
+                packed_[start + j] = u + t;
+                packed_[start + j + halfLen] = u - t;
+            }
+        }
+    }
+}
+
+BatchFftPlanF::BatchFftPlanF(size_t size, size_t maxBatch)
+    : size_(size), half_(size / 2), maxBatch_(maxBatch) {
+    if (!FftPlanF::isSupportedSize(size)) {
+        throw std::invalid_argument("FftPlan size must be a power of two and at least 4");
+    }
+
+    bitReverse_ = bitReversalTable(half_);
+
+    // Same twiddles as FftPlanF, stored as separate real and imaginary arrays
+    std::vector<std::complex<double>> twiddles = twiddleTable(size_);
+    twiddleReal_.resize(half_);
+    twiddleImag_.resize(half_);
+    for (size_t k = 0; k < half_; k++) {
+        twiddleReal_[k] = static_cast<float>(twiddles[k].real());
+        twiddleImag_[k] = static_cast<float>(twiddles[k].imag());
+    }
+
+    packedReal_.resize(half_ * TILE);
+    packedImag_.resize(half_ * TILE);
+}
+
+void BatchFftPlanF::forwardReal(const float* input, size_t batch, float* outReal, float* outImag) {
+    if (batch > maxBatch_) {
+        throw std::invalid_argument("BatchFftPlanF batch exceeds the planned capacity");
+    }
+
+    // Signals are transformed a few at a time so the working set of a tile
+    // stays in L1 while every butterfly is still a vector-wide loop
+    for (size_t first = 0; first < batch; first += TILE) {
+        size_t width = std::min(TILE, batch - first);
+        transformTile(input + first * size_, width, batch, outReal + first, outImag + first);
+    }
+}
+
+void BatchFftPlanF::transformTile(const float* input, size_t width, size_t outStride, float* outReal, float* outImag) {
+    // Tiles are always TILE signals wide, so the loops below have a constant
+    // trip count; lanes past width hold zeros and are not written out
+    const size_t B = TILE;
+    float* re = packedReal_.data();
+    float* im = packedImag_.data();
+    if (width < TILE) {
+        std::fill(packedReal_.begin(), packedReal_.end(), 0.0f);
+        std::fill(packedImag_.begin(), packedImag_.end(), 0.0f);
+    }
+
+    // Pack even/odd samples as real/imaginary parts in bit-reversed order,
+    // transposing the signals into [point][signal] on the way
+    for (size_t b = 0; b < width; b++) {
+        const float* signal = input + b * size_;
+        for (size_t n = 0; n < half_; n++) {
+            re[bitReverse_[n] * B + b] = signal[2 * n];
+            im[bitReverse_[n] * B + b] = signal[2 * n + 1];
+        }
+    }
+
+    // Radix-2 butterflies, the innermost loop runs over the signals
+    for (size_t len = 2; len <= half_; len <<= 1) {
+        size_t halfLen = len / 2;
+        size_t twiddleStride = 2 * (half_ / len);
+        for (size_t start = 0; start < half_; start += len) {
+            for (size_t j = 0; j < halfLen; j++) {
+                batchButterfly<TILE>(twiddleReal_[j * twiddleStride], twiddleImag_[j * twiddleStride],
+                               re + (start + j) * B, im + (start + j) * B,
+                               re + (start + j + halfLen) * B, im + (start + j + halfLen) * B);
+            }
+        }
+    }
+
+    // Split into the real-input spectrum, as in BasicFftPlan::forwardReal
+    for (size_t k = 0; k < half_; k++) {
+        size_t mirror = k == 0 ? 0 : half_ - k;
+        float wr = twiddleReal_[k], wi = twiddleImag_[k];
+        const float* zr = re + k * B;
+        const float* zi = im + k * B;
+        const float* mr = re + mirror * B;
+        const float* mi = im + mirror * B;
+        float* yr = outReal + k * outStride;
+        float* yi = outImag + k * outStride;
+        for (size_t b = 0; b < width; b++) {
+            float conjImag = -mi[b];
+            float evenReal = (zr[b] + mr[b]) * 0.5f;
+            float evenImag = (zi[b] + conjImag) * 0.5f;
+            float diffReal = zr[b] - mr[b];
+            float diffImag = zi[b] - conjImag;
+            float oddReal = diffImag * 0.5f;
+            float oddImag = diffReal * -0.5f;
+            yr[b] = evenReal + (wr * oddReal - wi * oddImag);
+            yi[b] = evenImag + (wr * oddImag + wi * oddReal);
+        }
+    }
+}
+
+void referenceDft(const double* input, size_t size, std::complex<double>* output) {
+    referenceDftImpl(input, size, output);
+}
+
+void referenceDft(const float* input, size_t size, std::complex<float>* output) {
+    referenceDftImpl(input, size, output);
+}
+
+template class BasicFftPlan<double>;
+template class BasicFftPlan<float>;
@@ -0,0 +1,98 @@
+#ifndef FFT_H
+#define FFT_H
+
+#include <complex>
+#include <cstddef>
+#include <vector>
+
+// The BasicFftPlan class holds everything a radix-2 FFT of one fixed size needs:
+// the bit-reversal permutation and the twiddle factors. Both tables are
+// computed once in the constructor, so transforms never call cos/sin.
+//
+// The plan is specialised for real input: an N-point real signal is packed
+// into an N/2-point complex FFT and then split into the N/2 positive
+// frequency bins (DC .. Nyquist-1), which is all the magnitude spectrum needs.
+//
+// The plan exists in double (FftPlan) and float (FftPlanF) precision.
+template<typename T>
+class BasicFftPlan {
+public:
+    // Creates a plan for transforms of the given size.
+    // The size must be a power of two and at least 4 (see isSupportedSize).
+    explicit BasicFftPlan(size_t size);
+
+    // Returns the number of real input samples this plan transforms.
+    size_t size() const { return size_; }
+
+    // Computes the first size()/2 bins of the DFT of a real signal.
+    // Parameters:
+    // - input: size() real samples.
+    // - output: Receives size()/2 complex bins (DC .. Nyquist-1).
+    void forwardReal(const T* input, std::complex<T>* output);
+
+    // Checks whether a plan can be built for the given size.
+    static bool isSupportedSize(size_t size);
+
+private:
+    size_t size_;                                  // Number of real input samples (N).
+    size_t half_;                                  // Size of the packed complex FFT (N/2).
+    std::vector<size_t> bitReverse_;               // Bit-reversal permutation for N/2 points.
+    std::vector<std::complex<T>> twiddles_;        // exp(-2*pi*i*k/N) for k < N/2.
+    std::vector<std::complex<T>> packed_;          // Scratch buffer for the packed complex FFT.
+
+    // In-place iterative radix-2 FFT of half_ points on packed_.
+    void transformPacked();
+};
+
+extern template class BasicFftPlan<double>;
+extern template class BasicFftPlan<float>;
+
+using FftPlan = BasicFftPlan<double>;
+using FftPlanF = BasicFftPlan<float>;
+
+// The BatchFftPlanF class transforms several real float signals of the same
+// size at once. Signals are interleaved inside the plan ([sample][signal]) in
+// small tiles, so every butterfly is a loop over the tile that the compiler
+// vectorizes.
+// Each signal gets exactly the operations FftPlanF applies to it, in the same
+// order, so the bins are bit-identical to transforming the signals one by one.
+class BatchFftPlanF {
+public:
+    // Creates a plan for up to maxBatch signals of the given size
+    // (a power of two, at least 4).
+    BatchFftPlanF(size_t size, size_t maxBatch);
+
+    size_t size() const { return size_; }
+    size_t maxBatch() const { return maxBatch_; }
+
+    // Computes the first size()/2 bins of every signal.
+    // Parameters:
+    // - input: batch signals of size() samples each, one after another.
+    // - batch: Number of signals, at most maxBatch().
+    // - outReal, outImag: Receive size()/2 * batch values, bin k of signal b at k * batch + b.
+    void forwardReal(const float* input, size_t batch, float* outReal, float* outImag);
+
+private:
+    // Signals transformed together; 16 floats fill two AVX or four SSE/NEON registers.
+    static constexpr size_t TILE = 16;
+
+    // Transforms width <= TILE signals, writing bin k of signal b at k * outStride + b.
+    void transformTile(const float* input, size_t width, size_t outStride, float* outReal, float* outImag);
+
+    size_t size_;                     // Number of real input samples (N).
+    size_t half_;                     // Size of the packed complex FFT (N/2).
+    size_t maxBatch_;                 // Largest batch accepted by forwardReal.
+    std::vector<size_t> bitReverse_;  // Bit-reversal permutation for N/2 points.
+    std::vector<float> twiddleReal_;  // Real parts of exp(-2*pi*i*k/N), k < N/2.
+    std::vector<float> twiddleImag_;  // Imaginary parts of the same twiddles.
+    std::vector<float> packedReal_;   // Packed complex FFT of one tile, [point][signal].
+    std::vector<float> packedImag_;
+};
+
+// Reference O(N^2) DFT of a real signal, writing the first size/2 bins into output.
+// Works for any size; used for sizes the FFT plan does not support and to
+// validate the FFT output.
+void referenceDft(const double* input, size_t size, std::complex<double>* output);
+void referenceDft(const float* input, size_t size, std::complex<float>* output);
+
+#endif  // FFT_H
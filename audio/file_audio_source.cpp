@@ -0,0 +1,299 @@
+#include "file_audio_source.h"
+#include <cstring>
+#include <cstdint>
+#include <thread>
+#include <algorithm>
+#include "../logging/logger.h"
+
+#ifdef _WIN32
+    #define NOMINMAX
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+namespace {
+
+// Reads little-endian integers from the WAV header.
+uint16_t readLe16(const unsigned char* p) {
+    return static_cast<uint16_t>(p[0] | (p[1] << 8));
+}
+
+uint32_t readLe32(const unsigned char* p) {
+    return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+           (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+const uint16_t WAVE_FORMAT_PCM = 1;
+const uint16_t WAVE_FORMAT_EXTENSIBLE = 0xFFFE;
+
+// KSDATAFORMAT_SUBTYPE_PCM as stored in a WAVE_FORMAT_EXTENSIBLE header
+const unsigned char PCM_SUBFORMAT[16] = {0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x10, 0x00,
+                                         0x80, 0x00, 0x00, 0xAA, 0x00, 0x38, 0x9B, 0x71};
+
+} // namespace
+
+FileAudioSource::FileAudioSource(const std::string& path, Pacing pacing)
+    : path_(path), pacing_(pacing), sampleRate_(DEFAULT_SAMPLE_RATE), running_(false),
+      mapping_(nullptr), mappingSize_(0), samples_(nullptr), sampleCount_(0), position_(0),
+      startPosition_(0)
+#ifdef _WIN32
+      , fileHandle_(nullptr), mappingHandle_(nullptr)
+#endif
+{
+}
+
+FileAudioSource::~FileAudioSource() {
+    stop();
+    unmapFile();
+}
+
+// Maps the file and locates the samples, either after a WAV header or, for
+// raw PCM, at the start of the file.
+bool FileAudioSource::init() {
+    if (mapping_) {
+        return true; // Already initialized.
+    }
+
+    if (!mapFile()) {
+        LOG_ERROR("Failed to map audio file: " << path_);
+        return false;
+    }
+
+    if (mappingSize_ >= 12 && std::memcmp(mapping_, "RIFF", 4) == 0 && std::memcmp(mapping_ + 8, "WAVE", 4) == 0) {
+        if (!parseWav()) {
+            unmapFile();
+            return false;
+        }
+    } else {
+        // Headerless raw int16 PCM
+        samples_ = reinterpret_cast<const short*>(mapping_);
+        sampleCount_ = mappingSize_ / sizeof(short);
+        sampleRate_ = DEFAULT_SAMPLE_RATE;
+    }
+
+    position_ = 0;
+    LOG_INFO("Audio file opened: " << path_ << " (" << sampleCount_ << " samples, " << sampleRate_ << " Hz)");
+    return true;
+}
+
+bool FileAudioSource::parseWav() {
+    bool haveFormat = false;
+    size_t offset = 12; // Skip "RIFF", the RIFF size and "WAVE"
+
+    // Walk the chunk list looking for "fmt " and "data"
+    while (offset + 8 <= mappingSize_) {
+        const unsigned char* chunk = mapping_ + offset;
+        uint32_t chunkSize = readLe32(chunk + 4);
+        size_t body = offset + 8;
+
+        if (std::memcmp(chunk, "fmt ", 4) == 0 && body + 16 <= mappingSize_) {
+            uint16_t format = readLe16(mapping_ + body);
+            uint16_t channels = readLe16(mapping_ + body + 2);
+            uint32_t rate = readLe32(mapping_ + body + 4);
+            uint16_t bits = readLe16(mapping_ + body + 14);
+
+            // WAVE_FORMAT_EXTENSIBLE names the real format by the GUID at the
+            // end of the 40-byte chunk; only the PCM subformat is integer samples
+            if (format == WAVE_FORMAT_EXTENSIBLE) {
+                bool isPcm = chunkSize >= 40 && body + 40 <= mappingSize_ &&
+                             std::memcmp(mapping_ + body + 24, PCM_SUBFORMAT, sizeof(PCM_SUBFORMAT)) == 0;
+                format = isPcm ? WAVE_FORMAT_PCM : 0;
+            }
+            if (format != WAVE_FORMAT_PCM || channels != 1 || bits != 16) {
+                LOG_ERROR("Unsupported WAV format in " << path_ << " (only mono 16-bit PCM is supported)");
+                return false;
+            }
+            sampleRate_ = static_cast<int>(rate);
+            haveFormat = true;
+        } else if (std::memcmp(chunk, "data", 4) == 0) {
+            if (!haveFormat) {
+                LOG_ERROR("WAV file has no format chunk before its data: " << path_);
+                return false;
+            }
+            if (body % alignof(short) != 0) {
+                LOG_ERROR("WAV data is not aligned for zero-copy access: " << path_);
+                return false;
+            }
+            // Truncated files are played up to the end of the mapping
+            size_t dataSize = std::min<size_t>(chunkSize, mappingSize_ - body);
+            samples_ = reinterpret_cast<const short*>(mapping_ + body);
+            sampleCount_ = dataSize / sizeof(short);
+            return true;
+        }
+
+        // Chunks are padded to an even size
+        offset = body + chunkSize + (chunkSize & 1);
+    }
+
+    LOG_ERROR("WAV file has no data chunk: " << path_);
+    return false;
+}
+
+bool FileAudioSource::mapFile() {
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path_.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                              OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+        CloseHandle(file);
+        return false;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping) {
+        CloseHandle(file);
+        return false;
+    }
+
+    void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!view) {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+
+    fileHandle_ = file;
+    mappingHandle_ = mapping;
+    mapping_ = static_cast<const unsigned char*>(view);
+    mappingSize_ = static_cast<size_t>(size.QuadPart);
+#else
+    int fd = open(path_.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        close(fd);
+        return false;
+    }
+
+    void* view = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd); // The mapping keeps the file alive
+    if (view == MAP_FAILED) {
+        return false;
+    }
+    madvise(view, static_cast<size_t>(st.st_size), MADV_SEQUENTIAL);
+
+    mapping_ = static_cast<const unsigned char*>(view);
+    mappingSize_ = static_cast<size_t>(st.st_size);
+#endif
+    return true;
+}
+
+void FileAudioSource::unmapFile() {
+    if (!mapping_) {
+        return;
+    }
+#ifdef _WIN32
+    UnmapViewOfFile(mapping_);
+    CloseHandle(static_cast<HANDLE>(mappingHandle_));
+    CloseHandle(static_cast<HANDLE>(fileHandle_));
+    mappingHandle_ = nullptr;
+    fileHandle_ = nullptr;
+#else
+    munmap(const_cast<unsigned char*>(mapping_), mappingSize_);
+#endif
+    mapping_ = nullptr;
+    mappingSize_ = 0;
+    samples_ = nullptr;
+    sampleCount_ = 0;
+    position_ = 0;
+}
+
+void FileAudioSource::start() {
+    if (!mapping_ || running_ || position_ >= sampleCount_) {
+        return; // Nothing to play.
+    }
+
+    // Real-time pacing is measured from here
+    startTime_ = std::chrono::steady_clock::now();
+    startPosition_ = position_;
+    running_ = true;
+}
+
+void FileAudioSource::stop() {
+    running_ = false;
+}
+
+void FileAudioSource::rewind() {
+    position_ = 0;
+    if (running_) {
+        startTime_ = std::chrono::steady_clock::now();
+        startPosition_ = 0;
+    }
+}
+
+size_t FileAudioSource::dueSamples() const {
+    if (!running_) {
+        return 0;
+    }
+
+    if (pacing_ == Pacing::AsFastAsPossible) {
+        return sampleCount_ - position_;
+    }
+
+    // A sample is due once its playback time has passed
+    auto elapsed = std::chrono::steady_clock::now() - startTime_;
+    double seconds = std::chrono::duration<double>(elapsed).count();
+    size_t due = startPosition_ + static_cast<size_t>(seconds * sampleRate_);
+    due = std::min(due, sampleCount_);
+    return due > position_ ? due - position_ : 0;
+}
+
+int FileAudioSource::readSpan(const short*& data, int maxSamples) {
+    if (maxSamples <= 0) {
+        return 0;
+    }
+
+    size_t count = std::min(dueSamples(), static_cast<size_t>(maxSamples));
+    data = samples_ + position_;
+    position_ += count;
+
+    // The source stops on its own at the end of the recording
+    if (position_ >= sampleCount_) {
+        running_ = false;
+    }
+    return static_cast<int>(count);
+}
+
+int FileAudioSource::readAvailable(short* buffer, int maxSamples) {
+    const short* data = nullptr;
+    int count = readSpan(data, maxSamples);
+    if (count > 0) {
+        std::memcpy(buffer, data, count * sizeof(short));
+    }
+    return count;
+}
+
+int FileAudioSource::read(short* buffer, int bufferSize) {
+    int total = 0;
+    while (total < bufferSize && running_) {
+        total += readAvailable(buffer + total, bufferSize - total);
+        if (total < bufferSize && running_) {
+            // Wait for the next samples to become due
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+    return total;
+}
+
+int FileAudioSource::available() const {
+    return static_cast<int>(std::min<size_t>(dueSamples(), INT32_MAX));
+}
+
+bool FileAudioSource::isRunning() const {
+    return running_;
+}
+
+int FileAudioSource::sampleRate() const {
+    return sampleRate_;
+}
@@ -0,0 +1,108 @@
+#ifndef FILE_AUDIO_SOURCE_H
+#define FILE_AUDIO_SOURCE_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <string>
+#include "audio_source.h"
+
+// The FileAudioSource class plays back a recording from disk as if it were a
+// microphone. The file is memory-mapped and samples are served straight from
+// the mapping, so readSpan() hands out pointers without copying.
+//
+// Supported formats are mono 16-bit PCM WAV files and headerless raw
+// little-endian int16 PCM (assumed to be 16 kHz).
+class FileAudioSource : public AudioSource {
+public:
+    // How quickly the recording is delivered.
+    enum class Pacing {
+        RealTime,        // Samples become available at the file's sample rate, like a live device.
+        AsFastAsPossible // Every remaining sample is available immediately, for throughput runs.
+    };
+
+    // Constructor: Remembers the file to play back. Nothing is opened until init().
+    FileAudioSource(const std::string& path, Pacing pacing = Pacing::RealTime);
+
+    // Destructor: Unmaps and closes the file.
+    ~FileAudioSource() override;
+
+    FileAudioSource(const FileAudioSource&) = delete;
+    FileAudioSource& operator=(const FileAudioSource&) = delete;
+
+    // Maps the file and parses its header. Returns true if successful, false otherwise.
+    bool init() override;
+
+    // Starts playback from the current position.
+    void start() override;
+
+    // Stops playback.
+    void stop() override;
+
+    // Copies bufferSize samples into buffer. In real-time mode waits until they
+    // are due. Returns fewer samples only at the end of the file.
+    int read(short* buffer, int bufferSize) override;
+
+    // Copies up to maxSamples samples that are already due into buffer.
+    int readAvailable(short* buffer, int maxSamples) override;
+
+    // Returns the number of samples that are due but not yet read.
+    int available() const override;
+
+    // Checks if playback is running. Becomes false once the whole file has been read.
+    bool isRunning() const override;
+
+    // Returns the sample rate of the file in Hz.
+    int sampleRate() const override;
+
+    // Returns up to maxSamples due samples without copying them and advances
+    // past them. The pointer stays valid until the source is destroyed.
+    // Parameters:
+    // - data: Receives a pointer into the mapped file.
+    // - maxSamples: Maximum number of samples to return.
+    // Returns the number of samples data points to.
+    int readSpan(const short*& data, int maxSamples);
+
+    // Moves the playback position back to the first sample.
+    void rewind();
+
+    // Returns the total number of samples in the file.
+    size_t totalSamples() const { return sampleCount_; }
+
+private:
+    std::string path_;          // Path of the recording.
+    Pacing pacing_;             // Delivery mode.
+    int sampleRate_;            // Sample rate of the recording in Hz.
+    std::atomic<bool> running_; // Whether playback is running; stop() may clear it while another thread reads.
+
+    const unsigned char* mapping_; // Start of the mapped file.
+    size_t mappingSize_;           // Size of the mapping in bytes.
+    const short* samples_;         // First sample inside the mapping.
+    size_t sampleCount_;           // Number of samples in the file.
+    size_t position_;              // Index of the next sample to deliver.
+
+    std::chrono::steady_clock::time_point startTime_; // Wall-clock time of sample startPosition_.
+    size_t startPosition_;                            // Position at the last start().
+
+#ifdef _WIN32
+    void* fileHandle_;    // Win32 file handle.
+    void* mappingHandle_; // Win32 file-mapping handle.
+#endif
+
+    // Parses a RIFF/WAVE header, locating the PCM data. Returns false if the
+    // file is a WAV file in an unsupported format.
+    bool parseWav();
+
+    // Maps the whole file read-only. Returns false on failure.
+    bool mapFile();
+
+    // Releases the mapping and file handles.
+    void unmapFile();
+
+    // Returns the number of samples that are due and not yet delivered.
+    size_t dueSamples() const;
+
+    static constexpr int DEFAULT_SAMPLE_RATE = 16000; // Sample rate assumed for raw PCM files.
+};
+
+#endif  // FILE_AUDIO_SOURCE_H
@@ -0,0 +1,260 @@
+#define _USE_MATH_DEFINES
+#include <cmath>
+#include "formant_engine.h"
+#include "simd_kernels.h"
+#include <algorithm>
+
+std::unique_ptr<FormantEngine> createFormantEngine(FormantMethod method) {
+    switch (method) {
+        case FormantMethod::Lpc:
+            return std::make_unique<LpcFormantEngine>();
+        case FormantMethod::SpectralPeaks:
+        default:
+            return std::make_unique<SpectralPeakFormantEngine>();
+    }
+}
+
+const char* formantMethodName(FormantMethod method) {
+    return method == FormantMethod::Lpc ? "lpc" : "fft";
+}
+
+void SpectralPeakFormantEngine::prepare(size_t frameSize, int /*sampleRate*/) {
+    if (frameSize == frameSize_) {
+        return;
+    }
+    frameSize_ = frameSize;
+
+    fftData_.resize(frameSize / 2);
+    spectrum_.resize(frameSize / 2);
+    peaks_.clear();
+    peaks_.reserve(frameSize / 2);
+
+    if (FftPlan::isSupportedSize(frameSize)) {
+        fftPlan_ = std::make_unique<FftPlanF>(frameSize);
+    } else {
+        fftPlan_.reset();
+    }
+}
+
+bool SpectralPeakFormantEngine::estimate(const float* frame, size_t size, int sampleRate, FormantEstimate& estimate) {
+    prepare(size, sampleRate);
+    if (spectrum_.size() < 5) return false;
+
+    // Odd sizes cannot use the radix-2 plan, fall back to the plain DFT
+    if (fftPlan_) {
+        fftPlan_->forwardReal(frame, fftData_.data());
+    } else {
+        referenceDft(frame, size, fftData_.data());
+    }
+
+    // fftData already holds only the positive-frequency half
+    simdKernels().magnitude(fftData_.data(), spectrum_.data(), spectrum_.size());
+
+    return pickSpectralFormants(spectrum_.data(), spectrum_.size(), sampleRate, peaks_, estimate);
+}
+
+bool pickSpectralFormants(const float* spectrum, size_t bins, int sampleRate,
+                          std::vector<std::pair<double, double>>& peaks, FormantEstimate& estimate) {
+    if (bins < 5) return false;
+
+    double freqStep = (double)sampleRate / (2.0 * bins);
+
+    // Find all peaks in the spectrum that are above a certain threshold
+    peaks.clear();
+    double maxAmplitude = *std::max_element(spectrum, spectrum + bins);
+    double threshold = maxAmplitude * 0.05; // Lower the threshold to 5%
+
+    for (size_t i = 2; i < bins - 2; i++) {
+        if (spectrum[i] > spectrum[i-1] && spectrum[i] > spectrum[i+1] &&
+            spectrum[i] > spectrum[i-2] && spectrum[i] > spectrum[i+2] &&
+            spectrum[i] > threshold) {
+            double freq = i * freqStep;
+            if (freq >= 150 && freq <= 4000) { // Expand the frequency range
+                peaks.push_back({freq, spectrum[i]});
+            }
+        }
+    }
+
+    if (peaks.empty()) return false;
+
+    // Sort the peaks by amplitude in descending order
+    std::sort(peaks.begin(), peaks.end(),
+              [](const auto& a, const auto& b) { return a.second > b.second; });
+
+    // Take up to 4 strongest peaks for analysis
+    int numPeaks = std::min(4, (int)peaks.size());
+
+    // Identify F1 and F2 formants
+    double f1 = 0, f2 = 0;
+    double f1_amp = 0, f2_amp = 0;
+
+    for (int i = 0; i < numPeaks; i++) {
+        double freq = peaks[i].first;
+        double amp = peaks[i].second;
+
+        // F1 - search in the range of 200-1000 Hz
+        if (freq >= 200 && freq <= 1000 && amp > f1_amp) {
+            f1 = freq;
+            f1_amp = amp;
+        }
+
+        // F2 - search in the range of 800-3500 Hz
+        if (freq >= 800 && freq <= 3500 && amp > f2_amp) {
+            f2 = freq;
+            f2_amp = amp;
+        }
+    }
+
+    if (f1 == 0 || f2 == 0) return false;
+
+    estimate.f1 = f1;
+    estimate.f2 = f2;
+    estimate.f1Amplitude = f1_amp;
+    estimate.f2Amplitude = f2_amp;
+    estimate.maxAmplitude = maxAmplitude;
+    return true;
+}
+
+LpcFormantEngine::LpcFormantEngine(double gridStep) : gridStep_(gridStep > 0.0 ? gridStep : 25.0) {
+}
+
+void LpcFormantEngine::prepare(size_t frameSize, int sampleRate) {
+    if (frameSize == frameSize_ && sampleRate == sampleRate_) {
+        return;
+    }
+    frameSize_ = frameSize;
+    sampleRate_ = sampleRate;
+
+    // Rule of thumb: two poles per kHz of bandwidth plus two for the glottal
+    // source and radiation
+    order_ = std::min<size_t>(static_cast<size_t>(std::max(sampleRate, 4000)) / 1000 + 2,
+                              frameSize > 1 ? frameSize - 1 : 1);
+
+    emphasized_.resize(frameSize);
+    autocorrelation_.resize(order_ + 1);
+    coefficients_.resize(order_ + 1);
+    reflection_.resize(order_ + 1);
+
+    // Formants of interest lie between 150 and 4000 Hz
+    double maxFrequency = std::min(4000.0, sampleRate / 2.0 - gridStep_);
+    gridFrequencies_.clear();
+    for (double f = 150.0; f <= maxFrequency; f += gridStep_) {
+        gridFrequencies_.push_back(f);
+    }
+
+    // cos/sin of every grid frequency and lag, so the envelope is a plain dot product
+    gridCos_.resize(gridFrequencies_.size() * order_);
+    gridSin_.resize(gridFrequencies_.size() * order_);
+    for (size_t g = 0; g < gridFrequencies_.size(); g++) {
+        double w = 2.0 * M_PI * gridFrequencies_[g] / sampleRate;
+        for (size_t k = 1; k <= order_; k++) {
+            gridCos_[g * order_ + k - 1] = cos(w * k);
+            gridSin_[g * order_ + k - 1] = sin(w * k);
+        }
+    }
+    envelope_.resize(gridFrequencies_.size());
+}
+
+double LpcFormantEngine::levinsonDurbin() {
+    std::fill(coefficients_.begin(), coefficients_.end(), 0.0);
+    coefficients_[0] = 1.0;
+    double error = autocorrelation_[0];
+
+    for (size_t i = 1; i <= order_; i++) {
+        double acc = autocorrelation_[i];
+        for (size_t j = 1; j < i; j++) {
+            acc += coefficients_[j] * autocorrelation_[i - j];
+        }
+        double k = -acc / error;
+
+        // a[j] += k * a[i - j], using the previous coefficients
+        std::copy(coefficients_.begin(), coefficients_.begin() + i, reflection_.begin());
+        for (size_t j = 1; j < i; j++) {
+            coefficients_[j] = reflection_[j] + k * reflection_[i - j];
+        }
+        coefficients_[i] = k;
+
+        error *= 1.0 - k * k;
+        if (error <= 0.0) {
+            return 0.0;
+        }
+    }
+    return error;
+}
+
+bool LpcFormantEngine::estimate(const float* frame, size_t size, int sampleRate, FormantEstimate& estimate) {
+    prepare(size, sampleRate);
+    if (size <= order_ || envelope_.size() < 3) return false;
+
+    // Pre-emphasis flattens the spectral tilt so the model spends poles on formants
+    emphasized_[0] = frame[0];
+    for (size_t i = 1; i < size; i++) {
+        emphasized_[i] = static_cast<double>(frame[i]) - 0.97 * frame[i - 1];
+    }
+
+    for (size_t k = 0; k <= order_; k++) {
+        double sum = 0.0;
+        for (size_t i = k; i < size; i++) {
+            sum += emphasized_[i] * emphasized_[i - k];
+        }
+        autocorrelation_[k] = sum;
+    }
+    if (autocorrelation_[0] <= 0.0) return false;
+
+    // A tiny noise floor keeps the recursion stable on near-periodic frames
+    autocorrelation_[0] *= 1.0 + 1e-9;
+
+    double error = levinsonDurbin();
+    if (error <= 0.0) return false;
+    double gain = std::sqrt(error);
+
+    // Envelope gain / |A(e^jw)| on the grid
+    double maxAmplitude = 0.0;
+    for (size_t g = 0; g < envelope_.size(); g++) {
+        const double* c = &gridCos_[g * order_];
+        const double* s = &gridSin_[g * order_];
+        double re = 1.0, im = 0.0;
+        for (size_t k = 0; k < order_; k++) {
+            re += coefficients_[k + 1] * c[k];
+            im -= coefficients_[k + 1] * s[k];
+        }
+        envelope_[g] = gain / std::sqrt(re * re + im * im + 1e-30);
+        maxAmplitude = std::max(maxAmplitude, envelope_[g]);
+    }
+
+    // F1 is the first envelope peak in 200-1000 Hz, F2 the next one in 800-3500 Hz
+    double f1 = 0, f2 = 0;
+    double f1_amp = 0, f2_amp = 0;
+    for (size_t g = 1; g + 1 < envelope_.size(); g++) {
+        double left = envelope_[g - 1], center = envelope_[g], right = envelope_[g + 1];
+        if (!(center > left && center >= right)) {
+            continue;
+        }
+
+        // Parabolic interpolation between grid points
+        double curvature = left - 2.0 * center + right;
+        double offset = curvature != 0.0 ? 0.5 * (left - right) / curvature : 0.0;
+        double freq = gridFrequencies_[g] + offset * gridStep_;
+        double amp = center - 0.25 * (left - right) * offset;
+
+        if (f1 == 0) {
+            if (freq >= 200 && freq <= 1000) {
+                f1 = freq;
+                f1_amp = amp;
+            }
+        } else if (freq >= 800 && freq <= 3500) {
+            f2 = freq;
+            f2_amp = amp;
+            break;
+        }
+    }
+
+    if (f1 == 0 || f2 == 0) return false;
+
+    estimate.f1 = f1;
+    estimate.f2 = f2;
+    estimate.f1Amplitude = f1_amp;
+    estimate.f2Amplitude = f2_amp;
+    estimate.maxAmplitude = maxAmplitude;
+    return true;
+}
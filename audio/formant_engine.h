@@ -0,0 +1,125 @@
+#ifndef FORMANT_ENGINE_H
+#define FORMANT_ENGINE_H
+
+#include <complex>
+#include <cstddef>
+#include <memory>
+#include <utility>
+#include <vector>
+#include "fft.h"
+
+// First two formants of one frame, with the spectral amplitude at each.
+// Amplitudes are only comparable to maxAmplitude of the same estimate.
+struct FormantEstimate {
+    double f1 = 0.0;           // First formant frequency in Hz
+    double f2 = 0.0;           // Second formant frequency in Hz
+    double f1Amplitude = 0.0;  // Amplitude at F1
+    double f2Amplitude = 0.0;  // Amplitude at F2
+    double maxAmplitude = 0.0; // Largest amplitude in the analyzed spectrum
+};
+
+// Available formant estimation methods.
+enum class FormantMethod {
+    SpectralPeaks, // Strongest peaks of the FFT magnitude spectrum
+    Lpc            // Peaks of the linear prediction envelope
+};
+
+// The FormantEngine interface finds F1 and F2 in a windowed frame. Engines
+// own their per-frame workspace and allocate only in prepare().
+class FormantEngine {
+public:
+    virtual ~FormantEngine() = default;
+
+    // Short name for logs and benchmarks.
+    virtual const char* name() const = 0;
+
+    // Sizes the workspace for frames of the given length and sample rate.
+    virtual void prepare(size_t frameSize, int sampleRate) = 0;
+
+    // Estimates the formants of a windowed frame of the prepared size.
+    // Parameters:
+    // - frame: Windowed samples (float32, as produced by the SIMD windowing kernel).
+    // - size: Number of samples, must match prepare().
+    // - sampleRate: Sample rate of the frame, must match prepare().
+    // - estimate: Receives the formants.
+    // Returns:
+    // - true if both F1 and F2 were found, false otherwise.
+    virtual bool estimate(const float* frame, size_t size, int sampleRate, FormantEstimate& estimate) = 0;
+};
+
+// Creates an engine for the given method.
+std::unique_ptr<FormantEngine> createFormantEngine(FormantMethod method);
+
+// Returns the method name used on the command line ("fft" or "lpc").
+const char* formantMethodName(FormantMethod method);
+
+// Picks F1 and F2 from a magnitude spectrum the way SpectralPeakFormantEngine
+// does. Shared with VowelDetectorBank so batched streams classify exactly like
+// a single detector.
+// Parameters:
+// - spectrum: Magnitudes of bins DC .. Nyquist-1.
+// - bins: Number of bins.
+// - sampleRate: Sample rate of the analyzed frame.
+// - peaks: Scratch list, reserve bins entries to avoid allocation.
+// - estimate: Receives the formants.
+// Returns:
+// - true if both F1 and F2 were found, false otherwise.
+bool pickSpectralFormants(const float* spectrum, size_t bins, int sampleRate,
+                          std::vector<std::pair<double, double>>& peaks, FormantEstimate& estimate);
+
+// The SpectralPeakFormantEngine class takes the four strongest local maxima
+// of the FFT magnitude spectrum and picks F1 and F2 among them.
+class SpectralPeakFormantEngine : public FormantEngine {
+public:
+    const char* name() const override { return "fft"; }
+    void prepare(size_t frameSize, int sampleRate) override;
+    bool estimate(const float* frame, size_t size, int sampleRate, FormantEstimate& estimate) override;
+
+private:
+    size_t frameSize_ = 0;                         // Prepared frame size
+    std::vector<std::complex<float>> fftData_;     // Positive-frequency FFT bins
+    std::vector<float> spectrum_;                  // Magnitude spectrum
+    std::vector<std::pair<double, double>> peaks_; // Spectral peaks (frequency, amplitude)
+    std::unique_ptr<FftPlanF> fftPlan_;            // FFT tables, null for sizes the plan does not support
+};
+
+// The LpcFormantEngine class fits an all-pole model to the frame
+// (autocorrelation and Levinson-Durbin recursion) and searches the smooth
+// LPC envelope on a coarse frequency grid. The envelope has one peak per
+// resonance instead of one per harmonic, so F1 and F2 are simply its first
+// two peaks, and no FFT of the frame is needed.
+// It is not cheaper than peak picking, though: the recursion and the grid
+// search cost about twice the FFT engine per frame. formant_bench prints both
+// costs and accuracies for the machine it runs on.
+class LpcFormantEngine : public FormantEngine {
+public:
+    // Parameters:
+    // - gridStep: Spacing in Hz of the envelope search grid; peaks are refined between points.
+    explicit LpcFormantEngine(double gridStep = 25.0);
+
+    const char* name() const override { return "lpc"; }
+    void prepare(size_t frameSize, int sampleRate) override;
+    bool estimate(const float* frame, size_t size, int sampleRate, FormantEstimate& estimate) override;
+
+    // Prediction order used for the prepared sample rate.
+    size_t order() const { return order_; }
+
+private:
+    // Fills coefficients_ from autocorrelation_, returns the prediction error.
+    double levinsonDurbin();
+
+    double gridStep_;                          // Envelope grid spacing in Hz
+    size_t frameSize_ = 0;                     // Prepared frame size
+    int sampleRate_ = 0;                       // Prepared sample rate
+    size_t order_ = 0;                         // Prediction order
+    std::vector<double> emphasized_;           // Pre-emphasized frame
+    std::vector<double> autocorrelation_;      // Autocorrelation lags 0..order
+    std::vector<double> coefficients_;         // Predictor polynomial a[0..order], a[0] = 1
+    std::vector<double> reflection_;           // Scratch for the recursion
+    std::vector<double> gridFrequencies_;      // Envelope grid in Hz
+    std::vector<double> gridCos_;              // cos(w*k) for every grid point and lag 1..order
+    std::vector<double> gridSin_;              // sin(w*k) for every grid point and lag 1..order
+    std::vector<double> envelope_;             // LPC envelope on the grid
+};
+
+#endif  // FORMANT_ENGINE_H
@@ -0,0 +1,99 @@
+#include "latency_histogram.h"
+#include <cmath>
+#include <iomanip>
+
+LatencyHistogram::LatencyHistogram() {
+    reset();
+}
+
+void LatencyHistogram::reset() {
+    for (auto& bucket : buckets_) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+    count_.store(0, std::memory_order_relaxed);
+    totalMicros_.store(0, std::memory_order_relaxed);
+    maxMicros_.store(0, std::memory_order_relaxed);
+}
+
+size_t LatencyHistogram::bucketOf(uint64_t micros) {
+    if (micros < SUB_BUCKETS) {
+        return static_cast<size_t>(micros);
+    }
+
+    // Position of the highest set bit (3 or more here) picks the power of
+    // two, the next three bits the bucket within it
+    size_t exponent = 0;
+    for (uint64_t v = micros; v > 1; v >>= 1) {
+        exponent++;
+    }
+    size_t sub = static_cast<size_t>(micros >> (exponent - 3)) & (SUB_BUCKETS - 1);
+    size_t bucket = (exponent - 2) * SUB_BUCKETS + sub;
+    return bucket < BUCKET_COUNT ? bucket : BUCKET_COUNT - 1;
+}
+
+uint64_t LatencyHistogram::bucketEnd(size_t bucket) {
+    if (bucket < SUB_BUCKETS) {
+        return bucket + 1;
+    }
+    size_t exponent = bucket / SUB_BUCKETS + 2;
+    uint64_t sub = bucket % SUB_BUCKETS;
+    return (SUB_BUCKETS + sub + 1) << (exponent - 3);
+}
+
+void LatencyHistogram::record(std::chrono::nanoseconds duration) {
+    uint64_t micros = duration.count() > 0 ? static_cast<uint64_t>(duration.count() / 1000) : 0;
+    buckets_[bucketOf(micros)].fetch_add(1, std::memory_order_relaxed);
+    count_.fetch_add(1, std::memory_order_relaxed);
+    totalMicros_.fetch_add(micros, std::memory_order_relaxed);
+
+    uint64_t seen = maxMicros_.load(std::memory_order_relaxed);
+    while (micros > seen && !maxMicros_.compare_exchange_weak(seen, micros, std::memory_order_relaxed)) {
+    }
+}
+
+double LatencyHistogram::meanMicroseconds() const {
+    uint64_t n = count();
+    return n ? static_cast<double>(totalMicros_.load(std::memory_order_relaxed)) / n : 0.0;
+}
+
+double LatencyHistogram::maxMicroseconds() const {
+    return static_cast<double>(maxMicros_.load(std::memory_order_relaxed));
+}
+
+double LatencyHistogram::percentileMicroseconds(double fraction) const {
+    uint64_t n = count();
+    if (n == 0) {
+        return 0.0;
+    }
+
+    // Walk the buckets until the requested share of the samples is covered
+    uint64_t target = static_cast<uint64_t>(std::ceil(fraction * n));
+    if (target == 0) {
+        target = 1;
+    }
+    uint64_t seen = 0;
+    for (size_t b = 0; b < BUCKET_COUNT; b++) {
+        seen += buckets_[b].load(std::memory_order_relaxed);
+        if (seen >= target) {
+            // Never report more than the largest value actually seen
+            double end = static_cast<double>(bucketEnd(b));
+            return end < maxMicroseconds() ? end : maxMicroseconds();
+        }
+    }
+    return maxMicroseconds();
+}
+
+void LatencyHistogram::print(std::ostream& out, const char* name) const {
+    std::ios::fmtflags flags = out.flags();
+    std::streamsize precision = out.precision();
+    out << std::fixed << std::setprecision(2)
+        << std::left << std::setw(14) << name << std::right
+        << " n=" << std::setw(7) << count()
+        << "  mean " << std::setw(8) << meanMicroseconds() / 1000.0
+        << "  p50 " << std::setw(8) << percentileMicroseconds(0.50) / 1000.0
+        << "  p90 " << std::setw(8) << percentileMicroseconds(0.90) / 1000.0
+        << "  p99 " << std::setw(8) << percentileMicroseconds(0.99) / 1000.0
+        << "  max " << std::setw(8) << maxMicroseconds() / 1000.0 << " ms" << std::endl;
+    out.flags(flags);
+    out.precision(precision);
+}
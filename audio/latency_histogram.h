@@ -0,0 +1,54 @@
+#ifndef LATENCY_HISTOGRAM_H
+#define LATENCY_HISTOGRAM_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+
+// The LatencyHistogram class collects durations into log-linear buckets:
+// exact below 8 us, then eight buckets per power of two, so every bucket is
+// within 12.5% of the values it holds, up to about two minutes. Recording is a
+// few relaxed atomic increments, so any thread (including the capture
+// callback) may record while another one reads.
+class LatencyHistogram {
+public:
+    LatencyHistogram();
+
+    // Adds one duration; negative durations count as zero.
+    void record(std::chrono::nanoseconds duration);
+
+    // Forgets everything recorded so far.
+    void reset();
+
+    uint64_t count() const { return count_.load(std::memory_order_relaxed); }
+
+    // Mean and maximum of the recorded durations, in microseconds.
+    double meanMicroseconds() const;
+    double maxMicroseconds() const;
+
+    // Upper bound of the bucket holding the given fraction (0..1) of the
+    // recorded durations, in microseconds; 0 if nothing was recorded.
+    double percentileMicroseconds(double fraction) const;
+
+    // Writes "<name>: n=..., mean/p50/p90/p99/max ... ms" on one line.
+    void print(std::ostream& out, const char* name) const;
+
+private:
+    // Bucket of a duration in microseconds.
+    static size_t bucketOf(uint64_t micros);
+
+    // Smallest duration in microseconds that no longer fits a bucket.
+    static uint64_t bucketEnd(size_t bucket);
+
+    static constexpr size_t SUB_BUCKETS = 8;                 // Buckets per power of two.
+    static constexpr size_t BUCKET_COUNT = SUB_BUCKETS * 25; // 1 us up to 2^27 us (134 s).
+
+    std::atomic<uint64_t> buckets_[BUCKET_COUNT];
+    std::atomic<uint64_t> count_;
+    std::atomic<uint64_t> totalMicros_;
+    std::atomic<uint64_t> maxMicros_;
+};
+
+#endif  // LATENCY_HISTOGRAM_H
@@ -1,9 +1,14 @@
 #include "mic_input.h"
-#include <iostream>
 #include <cstring>
+#include <thread>
+#include <chrono>
+#include "../logging/logger.h"
 
 // Constructor for the MicInput class. Initializes member variables to default values.
-MicInput::MicInput() : stream_(nullptr), initialized_(false), running_(false) {
+MicInput::MicInput()
+    : stream_(nullptr), initialized_(false), running_(false), sampleRate_(PREFERRED_SAMPLE_RATE),
+      samples_(RING_CAPACITY), blocks_(BLOCK_CAPACITY), capturedSamples_(0),
+      overflowCount_(0), underrunCount_(0) {
 }
 
 // Destructor for the MicInput class. Ensures that the microphone stream is stopped and resources are released.
@@ -27,7 +32,7 @@ bool MicInput::init() {
     // Initialize the PortAudio library.
     PaError err = Pa_Initialize();
     if (err != paNoError) {
-        std::cerr << "PortAudio init error: " << Pa_GetErrorText(err) << std::endl;
+        LOG_ERROR("PortAudio init error: " << Pa_GetErrorText(err));
         return false; // Return false if initialization fails.
     }
     initialized_ = true;
@@ -35,12 +40,12 @@ bool MicInput::init() {
     // Retrieve information about the default input device.
     PaDeviceIndex defaultDevice = Pa_GetDefaultInputDevice();
     if (defaultDevice == paNoDevice) {
-        std::cerr << "No default input device found" << std::endl;
+        LOG_ERROR("No default input device found");
         return false; // Return false if no input device is available.
     }
 
     const PaDeviceInfo* deviceInfo = Pa_GetDeviceInfo(defaultDevice);
-    std::cout << "Input device used: " << deviceInfo->name << std::endl;
+    LOG_INFO("Input device used: " << deviceInfo->name);
 
     // Configure the parameters for the input stream.
     PaStreamParameters inputParameters;
@@ -50,22 +55,31 @@ bool MicInput::init() {
     inputParameters.suggestedLatency = deviceInfo->defaultLowInputLatency; // Use the default low latency for the device.
     inputParameters.hostApiSpecificStreamInfo = nullptr; // No additional host API-specific information.
 
+    // Capture at 16 kHz if the device supports it, otherwise at its native rate;
+    // the multirate front end converts the stream afterwards.
+    sampleRate_ = PREFERRED_SAMPLE_RATE;
+    if (Pa_IsFormatSupported(&inputParameters, nullptr, PREFERRED_SAMPLE_RATE) != paFormatIsSupported) {
+        sampleRate_ = static_cast<int>(deviceInfo->defaultSampleRate);
+        LOG_INFO("Device does not support " << PREFERRED_SAMPLE_RATE
+                 << " Hz, capturing at " << sampleRate_ << " Hz");
+    }
+
     // Open the input stream with the specified parameters.
     err = Pa_OpenStream(&stream_,
                        &inputParameters,
                        nullptr,  // No output stream is needed.
-                       SAMPLE_RATE, // Set the sample rate for the stream.
+                       sampleRate_, // Set the sample rate for the stream.
                        FRAMES_PER_BUFFER, // Set the number of frames per buffer.
                        paClipOff, // Disable clipping.
-                       nullptr,  // No callback function is used.
-                       nullptr); // No user data is passed to the callback.
+                       &MicInput::captureCallback, // Samples are pushed into the ring buffer by the callback.
+                       this);    // The callback receives this MicInput instance.
 
     if (err != paNoError) {
-        std::cerr << "PortAudio open stream error: " << Pa_GetErrorText(err) << std::endl;
+        LOG_ERROR("PortAudio open stream error: " << Pa_GetErrorText(err));
         return false; // Return false if the stream could not be opened.
     }
 
-    std::cout << "Microphone initialized successfully (Sample Rate: " << SAMPLE_RATE << " Hz)" << std::endl;
+    LOG_INFO("Microphone initialized successfully (Sample Rate: " << sampleRate_ << " Hz)");
     return true; // Return true if initialization is successful.
 }
 
@@ -78,51 +92,129 @@ void MicInput::start() {
     // Start the PortAudio stream.
     PaError err = Pa_StartStream(stream_);
     if (err != paNoError) {
-        std::cerr << "PortAudio start stream error: " << Pa_GetErrorText(err) << std::endl;
+        LOG_ERROR("PortAudio start stream error: " << Pa_GetErrorText(err));
         return; // Return if the stream could not be started.
     }
 
     running_ = true; // Set the running flag to true.
-    std::cout << "Recording from microphone started" << std::endl;
+    LOG_INFO("Recording from microphone started");
 }
 
 // Stops the microphone input stream if it is running.
 void MicInput::stop() {
-    if (!stream_ || !running_) {
+    // Clearing the flag first ends a blocking read() on another thread, and
+    // only one of two concurrent stop() calls gets to stop the stream
+    if (!stream_ || !running_.exchange(false)) {
         return; // Do nothing if the stream is not initialized or not running.
     }
 
     // Stop the PortAudio stream.
     PaError err = Pa_StopStream(stream_);
     if (err != paNoError) {
-        std::cerr << "PortAudio stop stream error: " << Pa_GetErrorText(err) << std::endl;
+        LOG_WARN("PortAudio stop stream error: " << Pa_GetErrorText(err));
+    }
+
+    LOG_INFO("Microphone recording stopped");
+}
+
+// PortAudio callback. Runs on the audio thread, so it only copies samples into
+// the lock-free ring buffers and never blocks, allocates or prints.
+int MicInput::captureCallback(const void* input, void* output, unsigned long frameCount,
+                              const PaStreamCallbackTimeInfo* timeInfo,
+                              PaStreamCallbackFlags statusFlags, void* userData) {
+    (void)output;
+    MicInput* self = static_cast<MicInput*>(userData);
+    if (!input) {
+        return paContinue;
     }
 
-    running_ = false; // Set the running flag to false.
-    std::cout << "Microphone recording stopped" << std::endl;
+    if (statusFlags & paInputOverflow) {
+        self->overflowCount_.fetch_add(1, std::memory_order_relaxed); // Samples were lost before the callback ran.
+    }
+
+    // Push the block; whatever does not fit is dropped and counted
+    size_t written = self->samples_.push(static_cast<const short*>(input), frameCount);
+    if (written < frameCount) {
+        self->overflowCount_.fetch_add(frameCount - written, std::memory_order_relaxed);
+    }
+
+    if (written > 0) {
+        CaptureBlock block;
+        block.firstSample = self->capturedSamples_;
+        block.frameCount = static_cast<uint32_t>(written);
+        block.captureTime = timeInfo ? timeInfo->inputBufferAdcTime : 0.0;
+
+        // The ADC time lies in the past by the device's input latency; carry
+        // it over to the steady clock the rest of the program measures with.
+        // Some host APIs leave the times at zero; then the callback time is used.
+        auto now = std::chrono::steady_clock::now().time_since_epoch();
+        double age = block.captureTime > 0.0 ? timeInfo->currentTime - block.captureTime : 0.0;
+        block.steadyTime = std::chrono::duration_cast<std::chrono::nanoseconds>(now).count()
+                         - static_cast<int64_t>(age > 0.0 && age < 1.0 ? age * 1e9 : 0.0);
+        self->blocks_.push(block); // Timestamps are best effort, a full queue just skips one.
+    }
+    self->capturedSamples_ += written;
+
+    return paContinue;
 }
 
-// Reads audio data from the microphone into the provided buffer.
+// Reads audio data from the microphone into the provided buffer, waiting until
+// enough samples have been captured.
 int MicInput::read(short* buffer, int bufferSize) {
     if (!stream_ || !running_) {
         return 0; // Return 0 if the stream is not initialized or not running.
     }
 
-    // Read audio data from the PortAudio stream into the buffer.
-    PaError err = Pa_ReadStream(stream_, buffer, bufferSize);
-    
-    if (err == paNoError) {
-        return bufferSize; // Return the size of the buffer if the read operation is successful.
-    } else if (err == paInputOverflowed) {
-        std::cerr << "Input overflow detected" << std::endl;
-        return bufferSize;  // Return the buffer size even if an overflow occurred (data is still valid).
-    } else {
-        std::cerr << "PortAudio read error: " << Pa_GetErrorText(err) << std::endl;
-        return 0; // Return 0 if a read error occurred.
+    int total = 0;
+    while (total < bufferSize && running_) {
+        total += static_cast<int>(samples_.pop(buffer + total, bufferSize - total));
+        if (total < bufferSize) {
+            // Less than one callback period of audio, sleep instead of spinning
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+    return total;
+}
+
+// Reads the samples that are already in the ring buffer without waiting.
+int MicInput::readAvailable(short* buffer, int maxSamples) {
+    if (!stream_ || !running_ || maxSamples <= 0) {
+        return 0;
+    }
+
+    int samplesRead = static_cast<int>(samples_.pop(buffer, maxSamples));
+    if (samplesRead == 0) {
+        underrunCount_.fetch_add(1, std::memory_order_relaxed);
     }
+    return samplesRead;
+}
+
+// Returns the number of captured samples waiting to be read.
+int MicInput::available() const {
+    return static_cast<int>(samples_.size());
+}
+
+// Retrieves the timestamp of the oldest captured block not yet retrieved.
+bool MicInput::popCaptureBlock(CaptureBlock& block) {
+    return blocks_.pop(block);
+}
+
+// Returns the number of samples dropped on the capture side.
+uint64_t MicInput::overflowCount() const {
+    return overflowCount_.load(std::memory_order_relaxed);
+}
+
+// Returns the number of non-blocking reads that found no audio.
+uint64_t MicInput::underrunCount() const {
+    return underrunCount_.load(std::memory_order_relaxed);
 }
 
 // Checks if the microphone input stream is currently running.
 bool MicInput::isRunning() const {
     return running_; // Return the value of the running flag.
+}
+
+// Returns the capture sample rate.
+int MicInput::sampleRate() const {
+    return sampleRate_;
 }
\ No newline at end of file
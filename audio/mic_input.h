@@ -2,40 +2,96 @@
 #define MIC_INPUT_H
 
 #include <portaudio.h>
+#include <atomic>
+#include <cstdint>
 #include <vector>
+#include "audio_source.h"
+#include "spsc_ring_buffer.h"
 
-class MicInput {
+// Timestamp of one block of samples delivered by the PortAudio callback.
+struct CaptureBlock {
+    uint64_t firstSample;   // Index of the block's first sample since the stream started.
+    uint32_t frameCount;    // Number of samples in the block.
+    double captureTime;     // PortAudio ADC time of the first sample, in seconds (stream clock).
+    int64_t steadyTime;     // The same instant on std::chrono::steady_clock, in nanoseconds.
+};
+
+// The MicInput class captures mono 16-bit audio from the default input device,
+// at 16 kHz when the device allows it and at the device's native rate otherwise.
+// PortAudio delivers samples on its own callback thread, which pushes them into
+// a lock-free ring buffer; consumers drain that buffer without blocking the
+// capture side.
+class MicInput : public AudioSource {
 public:
     MicInput();
-    ~MicInput();
+    ~MicInput() override;
 
     // Initializes the microphone input. Returns true if successful, false otherwise.
-    bool init();
+    bool init() override;
 
     // Starts the audio stream for capturing microphone input.
-    void start();
+    void start() override;
 
     // Stops the audio stream and releases resources.
-    void stop();
+    void stop() override;
 
     // Reads audio data from the microphone into the provided buffer.
+    // Waits until bufferSize samples have been captured.
     // Parameters:
     // - buffer: Pointer to the buffer where audio data will be stored.
     // - bufferSize: The size of the buffer in samples.
     // Returns the number of samples read.
-    int read(short* buffer, int bufferSize);
+    int read(short* buffer, int bufferSize) override;
+
+    // Reads whatever audio has already been captured, without waiting.
+    // Parameters:
+    // - buffer: Pointer to the buffer where audio data will be stored.
+    // - maxSamples: The size of the buffer in samples.
+    // Returns the number of samples read (0 if nothing was available).
+    int readAvailable(short* buffer, int maxSamples) override;
+
+    // Returns the number of captured samples waiting to be read.
+    int available() const override;
+
+    // Retrieves the timestamp of the oldest captured block not yet retrieved.
+    // Returns false if there is none.
+    bool popCaptureBlock(CaptureBlock& block);
+
+    // Number of samples dropped because the ring buffer was full, plus one for
+    // every input overflow reported by PortAudio.
+    uint64_t overflowCount() const;
+
+    // Number of non-blocking reads that found no captured audio.
+    uint64_t underrunCount() const;
 
     // Checks if the audio stream is currently running.
     // Returns true if the stream is active, false otherwise.
-    bool isRunning() const;
+    bool isRunning() const override;
+
+    // Returns the capture sample rate in Hz.
+    int sampleRate() const override;
 
 private:
     PaStream* stream_;       // Pointer to the PortAudio stream object.
     bool initialized_;       // Indicates whether the microphone input has been initialized.
-    bool running_;           // Indicates whether the audio stream is currently running.
-    
-    static constexpr int SAMPLE_RATE = 16000;  // Recommended sample rate for Vosk is 16kHz.
+    std::atomic<bool> running_; // Whether the stream is running; stop() may clear it while another thread reads.
+    int sampleRate_;         // Rate the stream was opened with.
+
+    SpscRingBuffer<short> samples_;        // Captured samples, written by the callback thread.
+    SpscRingBuffer<CaptureBlock> blocks_;  // Timestamps of captured blocks.
+    uint64_t capturedSamples_;             // Samples seen by the callback, owned by the callback thread.
+    std::atomic<uint64_t> overflowCount_;  // Samples dropped on the capture side.
+    std::atomic<uint64_t> underrunCount_;  // Reads that found the buffer empty.
+
+    // PortAudio callback, runs on the audio thread.
+    static int captureCallback(const void* input, void* output, unsigned long frameCount,
+                               const PaStreamCallbackTimeInfo* timeInfo,
+                               PaStreamCallbackFlags statusFlags, void* userData);
+
+    static constexpr int PREFERRED_SAMPLE_RATE = 16000;  // Recommended sample rate for Vosk is 16kHz.
     static constexpr int FRAMES_PER_BUFFER = 512; // Number of frames per buffer for audio processing.
+    static constexpr int RING_CAPACITY = 65536;   // About one second of audio at 48 kHz buffered between capture and processing.
+    static constexpr int BLOCK_CAPACITY = 64;     // Timestamps kept for blocks not yet consumed.
 };
 
-#endif  // MIC_INPUT_H
\ No newline at end of file
+#endif  // MIC_INPUT_H
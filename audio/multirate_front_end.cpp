@@ -0,0 +1,20 @@
+#include "multirate_front_end.h"
+
+MultirateFrontEnd::MultirateFrontEnd(int inputRate, ResamplerQuality quality, size_t maxBlockSize)
+    : toSpeech_(inputRate, SPEECH_RATE, quality, maxBlockSize),
+      toAnalysis_(SPEECH_RATE, ANALYSIS_RATE, quality, toSpeech_.maxOutputSize(maxBlockSize)),
+      speech_(toSpeech_.maxOutputSize(maxBlockSize)),
+      analysis_(toAnalysis_.maxOutputSize(speech_.size())),
+      speechSize_(0), analysisSize_(0) {
+}
+
+void MultirateFrontEnd::process(const short* input, size_t size) {
+    // Grow the outputs only for blocks larger than the one planned for
+    if (toSpeech_.maxOutputSize(size) > speech_.size()) {
+        speech_.resize(toSpeech_.maxOutputSize(size));
+        analysis_.resize(toAnalysis_.maxOutputSize(speech_.size()));
+    }
+
+    speechSize_ = toSpeech_.process(input, size, speech_.data());
+    analysisSize_ = toAnalysis_.process(speech_.data(), speechSize_, analysis_.data());
+}
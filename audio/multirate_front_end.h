@@ -0,0 +1,46 @@
+#ifndef MULTIRATE_FRONT_END_H
+#define MULTIRATE_FRONT_END_H
+
+#include <cstddef>
+#include <vector>
+#include "resampler.h"
+
+// The MultirateFrontEnd class turns captured audio at the device's native
+// rate into the two streams the pipeline needs:
+// - speech: 16 kHz, the rate the Vosk model expects;
+// - analysis: 8 kHz, enough for formants below 4 kHz at half the FFT size.
+// The analysis stream is decimated from the speech stream, so both stay in
+// step: every two speech samples yield one analysis sample.
+class MultirateFrontEnd {
+public:
+    static constexpr int SPEECH_RATE = 16000;
+    static constexpr int ANALYSIS_RATE = 8000;
+
+    // Parameters:
+    // - inputRate: Native sample rate of the audio source.
+    // - quality: Resampler quality/cost trade-off.
+    // - maxBlockSize: Largest input block passed to process().
+    MultirateFrontEnd(int inputRate, ResamplerQuality quality = ResamplerQuality::Balanced,
+                      size_t maxBlockSize = 4096);
+
+    // Converts a block of captured audio. The results are available through
+    // speech() and analysis() until the next call.
+    void process(const short* input, size_t size);
+
+    const short* speech() const { return speech_.data(); }
+    size_t speechSize() const { return speechSize_; }
+    const short* analysis() const { return analysis_.data(); }
+    size_t analysisSize() const { return analysisSize_; }
+
+    int inputRate() const { return toSpeech_.inputRate(); }
+
+private:
+    PolyphaseResampler toSpeech_;   // Native rate -> 16 kHz
+    PolyphaseResampler toAnalysis_; // 16 kHz -> 8 kHz
+    std::vector<short> speech_;
+    std::vector<short> analysis_;
+    size_t speechSize_;
+    size_t analysisSize_;
+};
+
+#endif  // MULTIRATE_FRONT_END_H
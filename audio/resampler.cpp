@@ -0,0 +1,147 @@
+#define _USE_MATH_DEFINES
+#include <cmath>
+#include "resampler.h"
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+
+namespace {
+
+struct QualitySettings {
+    size_t tapsPerPhase;
+    double rolloff;     // Cutoff as a fraction of the lower Nyquist frequency
+    double kaiserBeta;  // Stopband attenuation of the Kaiser window
+};
+
+QualitySettings settingsFor(ResamplerQuality quality) {
+    switch (quality) {
+        case ResamplerQuality::Fast: return {8, 0.80, 5.0};
+        case ResamplerQuality::High: return {32, 0.94, 9.0};
+        case ResamplerQuality::Balanced:
+        default: return {16, 0.90, 7.0};
+    }
+}
+
+// Zeroth-order modified Bessel function, for the Kaiser window
+double besselI0(double x) {
+    double sum = 1.0, term = 1.0;
+    for (int k = 1; k < 50; k++) {
+        term *= (x / (2.0 * k)) * (x / (2.0 * k));
+        sum += term;
+        if (term < sum * 1e-12) {
+            break;
+        }
+    }
+    return sum;
+}
+
+short toSample(float value) {
+    value = std::max(-32768.0f, std::min(32767.0f, value));
+    return static_cast<short>(std::lrint(value));
+}
+
+} // namespace
+
+bool parseResamplerQuality(const char* text, ResamplerQuality& quality) {
+    if (std::strcmp(text, "fast") == 0) {
+        quality = ResamplerQuality::Fast;
+    } else if (std::strcmp(text, "balanced") == 0) {
+        quality = ResamplerQuality::Balanced;
+    } else if (std::strcmp(text, "high") == 0) {
+        quality = ResamplerQuality::High;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+PolyphaseResampler::PolyphaseResampler(int inputRate, int outputRate, ResamplerQuality quality, size_t maxBlockSize)
+    : inputRate_(inputRate), outputRate_(outputRate), historyCount_(0), position_(0), phase_(0),
+      dotProduct_(simdKernels().dotProduct) {
+    int divisor = std::gcd(std::max(inputRate, 1), std::max(outputRate, 1));
+    up_ = static_cast<size_t>(std::max(outputRate, 1) / divisor);
+    down_ = static_cast<size_t>(std::max(inputRate, 1) / divisor);
+
+    // When decimating, the filter has to span the same time at the input rate
+    // as it would at the output rate, so it grows with the decimation ratio
+    QualitySettings settings = settingsFor(quality);
+    taps_ = settings.tapsPerPhase * ((down_ + up_ - 1) / up_);
+
+    if (!isPassThrough()) {
+        // Low-pass prototype at the upsampled rate, cut below the lower of the two Nyquist frequencies
+        size_t length = up_ * taps_;
+        double cutoff = settings.rolloff * 0.5 / static_cast<double>(std::max(up_, down_));
+        double center = (length - 1) / 2.0;
+        double windowNorm = besselI0(settings.kaiserBeta);
+
+        std::vector<double> prototype(length);
+        double total = 0.0;
+        for (size_t i = 0; i < length; i++) {
+            double t = i - center;
+            double x = 2.0 * cutoff * t;
+            double sinc = (t == 0.0) ? 1.0 : sin(M_PI * x) / (M_PI * x);
+            double r = 2.0 * t / (length - 1);
+            double window = besselI0(settings.kaiserBeta * std::sqrt(std::max(0.0, 1.0 - r * r))) / windowNorm;
+            prototype[i] = 2.0 * cutoff * sinc * window;
+            total += prototype[i];
+        }
+
+        // Split into phases, time-reversed so each output is a dot product with
+        // the contiguous history; scaled for unity gain after upsampling
+        double gain = static_cast<double>(up_) / total;
+        bank_.resize(length);
+        for (size_t p = 0; p < up_; p++) {
+            for (size_t j = 0; j < taps_; j++) {
+                bank_[p * taps_ + j] = static_cast<float>(prototype[p + (taps_ - 1 - j) * up_] * gain);
+            }
+        }
+    }
+
+    history_.resize(taps_ - 1 + maxBlockSize);
+    reset();
+}
+
+void PolyphaseResampler::reset() {
+    // Start with a history of silence
+    std::fill(history_.begin(), history_.begin() + (taps_ - 1), 0.0f);
+    historyCount_ = taps_ - 1;
+    position_ = taps_ - 1;
+    phase_ = 0;
+}
+
+size_t PolyphaseResampler::maxOutputSize(size_t inputSize) const {
+    return inputSize * up_ / down_ + 2;
+}
+
+size_t PolyphaseResampler::process(const short* input, size_t size, short* output) {
+    if (isPassThrough()) {
+        std::copy(input, input + size, output);
+        return size;
+    }
+
+    if (historyCount_ + size > history_.size()) {
+        history_.resize(historyCount_ + size); // Only for blocks larger than maxBlockSize
+    }
+    for (size_t i = 0; i < size; i++) {
+        history_[historyCount_ + i] = input[i];
+    }
+    historyCount_ += size;
+
+    size_t produced = 0;
+    while (position_ < historyCount_) {
+        const float* taps = &bank_[phase_ * taps_];
+        const float* samples = &history_[position_ + 1 - taps_];
+        output[produced++] = toSample(dotProduct_(taps, samples, taps_));
+
+        phase_ += down_;
+        position_ += phase_ / up_;
+        phase_ %= up_;
+    }
+
+    // Keep only the history the next output still needs
+    size_t discard = std::min(position_ + 1 - taps_, historyCount_);
+    std::memmove(history_.data(), history_.data() + discard, (historyCount_ - discard) * sizeof(float));
+    historyCount_ -= discard;
+    position_ -= discard;
+    return produced;
+}
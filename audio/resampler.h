@@ -0,0 +1,73 @@
+#ifndef RESAMPLER_H
+#define RESAMPLER_H
+
+#include <cstddef>
+#include <vector>
+#include "simd_kernels.h"
+
+// Trade-off between filter quality and CPU time. The stopband attenuation
+// below was measured with sine sweeps from 0.6 times the output rate up to the
+// input Nyquist frequency, for 48->16, 44.1->16 and 16->8 kHz. Tones between
+// the output Nyquist frequency and that point fall in the transition band and
+// alias back much less attenuated (about -15 dB just above Nyquist).
+enum class ResamplerQuality {
+    Fast,     // 8 taps per phase at the lower rate, wide transition band; 43-55 dB stopband
+    Balanced, // 16 taps per phase at the lower rate; 71-74 dB stopband
+    High      // 32 taps per phase at the lower rate, narrow transition band; 89-92 dB stopband
+};
+
+// Parses "fast", "balanced" or "high". Returns false for anything else.
+bool parseResamplerQuality(const char* text, ResamplerQuality& quality);
+
+// The PolyphaseResampler class converts a stream of 16-bit samples from one
+// rate to another by a rational factor L/M. The windowed-sinc low-pass filter
+// is split into L phases, so every output sample is a single short dot
+// product over the input history; nothing is computed for the zeros of the
+// upsampled signal or for the outputs the downsampler would discard.
+//
+// Output lags the input by half the filter length (tapsPerPhase() / 2 input samples).
+class PolyphaseResampler {
+public:
+    // Parameters:
+    // - inputRate, outputRate: Sample rates in Hz.
+    // - quality: Filter length and sharpness.
+    // - maxBlockSize: Largest input block expected; the history buffer is
+    //   sized for it so process() does not allocate.
+    PolyphaseResampler(int inputRate, int outputRate,
+                       ResamplerQuality quality = ResamplerQuality::Balanced,
+                       size_t maxBlockSize = 4096);
+
+    // Resamples a block of input.
+    // Parameters:
+    // - input: Input samples.
+    // - size: Number of input samples.
+    // - output: Receives the output samples; must hold maxOutputSize(size) samples.
+    // Returns the number of output samples written.
+    size_t process(const short* input, size_t size, short* output);
+
+    // Upper bound on the output produced for an input block of the given size.
+    size_t maxOutputSize(size_t inputSize) const;
+
+    // Clears the history, as if the stream started again.
+    void reset();
+
+    int inputRate() const { return inputRate_; }
+    int outputRate() const { return outputRate_; }
+    bool isPassThrough() const { return up_ == 1 && down_ == 1; }
+    size_t tapsPerPhase() const { return taps_; }
+
+private:
+    int inputRate_;
+    int outputRate_;
+    size_t up_;                   // Interpolation factor L
+    size_t down_;                 // Decimation factor M
+    size_t taps_;                 // Filter taps per phase
+    std::vector<float> bank_;     // L phases of taps_ coefficients each, time-reversed
+    std::vector<float> history_;  // Last taps_ - 1 input samples followed by the current block
+    size_t historyCount_;         // Valid samples in history_
+    size_t position_;             // History index of the newest input sample of the next output
+    size_t phase_;                // Filter phase of the next output
+    float (*dotProduct_)(const float*, const float*, size_t); // SIMD kernel chosen at construction
+};
+
+#endif  // RESAMPLER_H
@@ -0,0 +1,287 @@
+#include "simd_kernels.h"
+#include <atomic>
+#include <cmath>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define SIMD_X86 1
+#include <immintrin.h>
+#elif defined(__aarch64__) || defined(_M_ARM64) || defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define SIMD_NEON 1
+#include <arm_neon.h>
+#endif
+
+// GCC and Clang compile each x86 kernel for its own instruction set, so the
+// rest of the program keeps the baseline target; MSVC accepts the intrinsics as is
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define SIMD_TARGET(isa)
+#else
+#define SIMD_TARGET(isa) __attribute__((target(isa)))
+#endif
+
+namespace {
+
+// Scalar reference kernels
+
+float windowEnergyScalar(const short* input, const float* window, float* output, size_t size) {
+    float energy = 0.0f;
+    for (size_t i = 0; i < size; i++) {
+        output[i] = static_cast<float>(input[i]) * window[i];
+        energy += output[i] * output[i];
+    }
+    return energy;
+}
+
+void magnitudeScalar(const std::complex<float>* bins, float* output, size_t size) {
+    for (size_t i = 0; i < size; i++) {
+        float re = bins[i].real(), im = bins[i].imag();
+        output[i] = std::sqrt(re * re + im * im);
+    }
+}
+
+float dotProductScalar(const float* a, const float* b, size_t size) {
+    float sum = 0.0f;
+    for (size_t i = 0; i < size; i++) {
+        sum += a[i] * b[i];
+    }
+    return sum;
+}
+
+#if defined(SIMD_X86)
+
+SIMD_TARGET("sse2") float horizontalSum(__m128 v) {
+    float lanes[4];
+    _mm_storeu_ps(lanes, v);
+    return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+}
+
+SIMD_TARGET("sse2") float windowEnergySse2(const short* input, const float* window, float* output, size_t size) {
+    __m128 energy = _mm_setzero_ps();
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        // Sign-extend eight int16 samples to two vectors of int32
+        __m128i samples = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i));
+        __m128i low = _mm_srai_epi32(_mm_unpacklo_epi16(samples, samples), 16);
+        __m128i high = _mm_srai_epi32(_mm_unpackhi_epi16(samples, samples), 16);
+        __m128 w0 = _mm_mul_ps(_mm_cvtepi32_ps(low), _mm_loadu_ps(window + i));
+        __m128 w1 = _mm_mul_ps(_mm_cvtepi32_ps(high), _mm_loadu_ps(window + i + 4));
+        _mm_storeu_ps(output + i, w0);
+        _mm_storeu_ps(output + i + 4, w1);
+        energy = _mm_add_ps(energy, _mm_add_ps(_mm_mul_ps(w0, w0), _mm_mul_ps(w1, w1)));
+    }
+    return horizontalSum(energy) + windowEnergyScalar(input + i, window + i, output + i, size - i);
+}
+
+SIMD_TARGET("sse2") void magnitudeSse2(const std::complex<float>* bins, float* output, size_t size) {
+    const float* data = reinterpret_cast<const float*>(bins);
+    size_t i = 0;
+    for (; i + 4 <= size; i += 4) {
+        __m128 a = _mm_loadu_ps(data + 2 * i);     // r0 i0 r1 i1
+        __m128 b = _mm_loadu_ps(data + 2 * i + 4); // r2 i2 r3 i3
+        __m128 re = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+        __m128 im = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+        _mm_storeu_ps(output + i, _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(re, re), _mm_mul_ps(im, im))));
+    }
+    magnitudeScalar(bins + i, output + i, size - i);
+}
+
+SIMD_TARGET("sse2") float dotProductSse2(const float* a, const float* b, size_t size) {
+    __m128 acc0 = _mm_setzero_ps();
+    __m128 acc1 = _mm_setzero_ps();
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+        acc1 = _mm_add_ps(acc1, _mm_mul_ps(_mm_loadu_ps(a + i + 4), _mm_loadu_ps(b + i + 4)));
+    }
+    return horizontalSum(_mm_add_ps(acc0, acc1)) + dotProductScalar(a + i, b + i, size - i);
+}
+
+SIMD_TARGET("avx2") float horizontalSum(__m256 v) {
+    __m128 sum = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+    float lanes[4];
+    _mm_storeu_ps(lanes, sum);
+    return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+}
+
+SIMD_TARGET("avx2") float windowEnergyAvx2(const short* input, const float* window, float* output, size_t size) {
+    __m256 energy = _mm256_setzero_ps();
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        __m128i samples = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i));
+        __m256 values = _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(samples));
+        __m256 windowed = _mm256_mul_ps(values, _mm256_loadu_ps(window + i));
+        _mm256_storeu_ps(output + i, windowed);
+        energy = _mm256_add_ps(energy, _mm256_mul_ps(windowed, windowed));
+    }
+    return horizontalSum(energy) + windowEnergyScalar(input + i, window + i, output + i, size - i);
+}
+
+SIMD_TARGET("avx2") void magnitudeAvx2(const std::complex<float>* bins, float* output, size_t size) {
+    const float* data = reinterpret_cast<const float*>(bins);
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        __m256 a = _mm256_loadu_ps(data + 2 * i);     // r0 i0 r1 i1 | r2 i2 r3 i3
+        __m256 b = _mm256_loadu_ps(data + 2 * i + 8); // r4 i4 r5 i5 | r6 i6 r7 i7
+        // Shuffles stay within 128-bit lanes: r0 r1 r4 r5 | r2 r3 r6 r7
+        __m256 re = _mm256_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+        __m256 im = _mm256_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+        __m256 magnitude = _mm256_sqrt_ps(_mm256_add_ps(_mm256_mul_ps(re, re), _mm256_mul_ps(im, im)));
+        // Restore bin order by swapping the middle 64-bit pairs
+        magnitude = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(magnitude), _MM_SHUFFLE(3, 1, 2, 0)));
+        _mm256_storeu_ps(output + i, magnitude);
+    }
+    magnitudeScalar(bins + i, output + i, size - i);
+}
+
+SIMD_TARGET("avx2") float dotProductAvx2(const float* a, const float* b, size_t size) {
+    __m256 acc0 = _mm256_setzero_ps();
+    __m256 acc1 = _mm256_setzero_ps();
+    size_t i = 0;
+    for (; i + 16 <= size; i += 16) {
+        acc0 = _mm256_add_ps(acc0, _mm256_mul_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i)));
+        acc1 = _mm256_add_ps(acc1, _mm256_mul_ps(_mm256_loadu_ps(a + i + 8), _mm256_loadu_ps(b + i + 8)));
+    }
+    return horizontalSum(_mm256_add_ps(acc0, acc1)) + dotProductSse2(a + i, b + i, size - i);
+}
+
+#endif  // SIMD_X86
+
+#if defined(SIMD_NEON)
+
+float horizontalSum(float32x4_t v) {
+    float32x2_t pair = vadd_f32(vget_low_f32(v), vget_high_f32(v));
+    return vget_lane_f32(vpadd_f32(pair, pair), 0);
+}
+
+float windowEnergyNeon(const short* input, const float* window, float* output, size_t size) {
+    float32x4_t energy = vdupq_n_f32(0.0f);
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        int16x8_t samples = vld1q_s16(input + i);
+        float32x4_t w0 = vmulq_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(samples))), vld1q_f32(window + i));
+        float32x4_t w1 = vmulq_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(samples))), vld1q_f32(window + i + 4));
+        vst1q_f32(output + i, w0);
+        vst1q_f32(output + i + 4, w1);
+        energy = vmlaq_f32(vmlaq_f32(energy, w0, w0), w1, w1);
+    }
+    return horizontalSum(energy) + windowEnergyScalar(input + i, window + i, output + i, size - i);
+}
+
+void magnitudeNeon(const std::complex<float>* bins, float* output, size_t size) {
+    size_t i = 0;
+#if defined(__aarch64__) || defined(_M_ARM64)
+    const float* data = reinterpret_cast<const float*>(bins);
+    for (; i + 4 <= size; i += 4) {
+        float32x4x2_t pairs = vld2q_f32(data + 2 * i); // De-interleaves real and imaginary parts
+        float32x4_t power = vmlaq_f32(vmulq_f32(pairs.val[0], pairs.val[0]), pairs.val[1], pairs.val[1]);
+        vst1q_f32(output + i, vsqrtq_f32(power));
+    }
+#endif
+    magnitudeScalar(bins + i, output + i, size - i);
+}
+
+float dotProductNeon(const float* a, const float* b, size_t size) {
+    float32x4_t acc0 = vdupq_n_f32(0.0f);
+    float32x4_t acc1 = vdupq_n_f32(0.0f);
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        acc0 = vmlaq_f32(acc0, vld1q_f32(a + i), vld1q_f32(b + i));
+        acc1 = vmlaq_f32(acc1, vld1q_f32(a + i + 4), vld1q_f32(b + i + 4));
+    }
+    return horizontalSum(vaddq_f32(acc0, acc1)) + dotProductScalar(a + i, b + i, size - i);
+}
+
+#endif  // SIMD_NEON
+
+const SimdKernels SCALAR_KERNELS = {SimdLevel::Scalar, "scalar", windowEnergyScalar, magnitudeScalar, dotProductScalar};
+#if defined(SIMD_X86)
+const SimdKernels SSE2_KERNELS = {SimdLevel::Sse2, "sse2", windowEnergySse2, magnitudeSse2, dotProductSse2};
+const SimdKernels AVX2_KERNELS = {SimdLevel::Avx2, "avx2", windowEnergyAvx2, magnitudeAvx2, dotProductAvx2};
+#endif
+#if defined(SIMD_NEON)
+const SimdKernels NEON_KERNELS = {SimdLevel::Neon, "neon", windowEnergyNeon, magnitudeNeon, dotProductNeon};
+#endif
+
+const SimdKernels* kernelsFor(SimdLevel level) {
+    switch (level) {
+#if defined(SIMD_X86)
+        case SimdLevel::Sse2: return &SSE2_KERNELS;
+        case SimdLevel::Avx2: return &AVX2_KERNELS;
+#endif
+#if defined(SIMD_NEON)
+        case SimdLevel::Neon: return &NEON_KERNELS;
+#endif
+        default: return &SCALAR_KERNELS;
+    }
+}
+
+std::atomic<const SimdKernels*> selectedKernels{nullptr};
+
+} // namespace
+
+SimdLevel detectSimdLevel() {
+#if defined(SIMD_X86)
+#if defined(_MSC_VER) && !defined(__clang__)
+    int info[4];
+    __cpuid(info, 0);
+    int maxLeaf = info[0];
+    __cpuid(info, 1);
+    bool sse2 = (info[3] & (1 << 26)) != 0;
+    bool osSavesAvx = (info[2] & (1 << 27)) != 0 && (info[2] & (1 << 28)) != 0 && (_xgetbv(0) & 6) == 6;
+    bool avx2 = false;
+    if (maxLeaf >= 7 && osSavesAvx) {
+        __cpuidex(info, 7, 0);
+        avx2 = (info[1] & (1 << 5)) != 0;
+    }
+#else
+    __builtin_cpu_init();
+    bool sse2 = __builtin_cpu_supports("sse2");
+    bool avx2 = __builtin_cpu_supports("avx2");
+#endif
+    if (avx2) return SimdLevel::Avx2;
+    if (sse2) return SimdLevel::Sse2;
+    return SimdLevel::Scalar;
+#elif defined(SIMD_NEON)
+    return SimdLevel::Neon;
+#else
+    return SimdLevel::Scalar;
+#endif
+}
+
+const SimdKernels& simdKernels() {
+    const SimdKernels* kernels = selectedKernels.load(std::memory_order_acquire);
+    if (!kernels) {
+        kernels = kernelsFor(detectSimdLevel());
+        selectedKernels.store(kernels, std::memory_order_release);
+    }
+    return *kernels;
+}
+
+const SimdKernels& scalarKernels() {
+    return SCALAR_KERNELS;
+}
+
+bool selectSimdKernels(SimdLevel level) {
+    const SimdKernels* kernels = kernelsFor(level);
+    if (kernels->level != level) {
+        return false; // Not compiled for this architecture
+    }
+    SimdLevel supported = detectSimdLevel();
+    bool available = level == SimdLevel::Scalar || level == supported ||
+                     (level == SimdLevel::Sse2 && supported == SimdLevel::Avx2);
+    if (!available) {
+        return false;
+    }
+    selectedKernels.store(kernels, std::memory_order_release);
+    return true;
+}
+
+const char* simdLevelName(SimdLevel level) {
+    switch (level) {
+        case SimdLevel::Sse2: return "sse2";
+        case SimdLevel::Avx2: return "avx2";
+        case SimdLevel::Neon: return "neon";
+        case SimdLevel::Scalar:
+        default: return "scalar";
+    }
+}
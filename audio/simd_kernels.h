@@ -0,0 +1,49 @@
+#ifndef SIMD_KERNELS_H
+#define SIMD_KERNELS_H
+
+#include <complex>
+#include <cstddef>
+
+// Instruction sets the kernels are written for.
+enum class SimdLevel {
+    Scalar, // Plain C++, the reference implementation
+    Sse2,
+    Avx2,
+    Neon
+};
+
+// The inner loops of the audio path, in float32. One table exists per
+// instruction set; simdKernels() returns the best one the CPU supports,
+// detected once at runtime. All kernels accept any size and unaligned data.
+struct SimdKernels {
+    SimdLevel level;
+    const char* name;
+
+    // Converts int16 samples to float, multiplies them by a window and
+    // returns the energy (sum of squares) of the windowed result.
+    float (*windowEnergy)(const short* input, const float* window, float* output, size_t size);
+
+    // Magnitude of every complex bin.
+    void (*magnitude)(const std::complex<float>* bins, float* output, size_t size);
+
+    // Sum of a[i] * b[i].
+    float (*dotProduct)(const float* a, const float* b, size_t size);
+};
+
+// Kernels for the best instruction set of this CPU.
+const SimdKernels& simdKernels();
+
+// Scalar kernels, the reference the SIMD versions are checked against.
+const SimdKernels& scalarKernels();
+
+// Best instruction set supported by this CPU and build.
+SimdLevel detectSimdLevel();
+
+// Forces simdKernels() to a given level, e.g. to compare implementations.
+// Returns false (and changes nothing) if the level is not supported here.
+bool selectSimdKernels(SimdLevel level);
+
+// Returns "scalar", "sse2", "avx2" or "neon".
+const char* simdLevelName(SimdLevel level);
+
+#endif  // SIMD_KERNELS_H
@@ -0,0 +1,84 @@
+#ifndef SPSC_RING_BUFFER_H
+#define SPSC_RING_BUFFER_H
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+// The SpscRingBuffer class is a lock-free ring buffer for exactly one producer
+// thread and one consumer thread. Neither side ever blocks or allocates after
+// construction, so it is safe to push from a real-time audio callback.
+// The capacity is rounded up to a power of two.
+template <typename T>
+class SpscRingBuffer {
+public:
+    explicit SpscRingBuffer(size_t capacity) {
+        size_t rounded = 1;
+        while (rounded < capacity) {
+            rounded <<= 1;
+        }
+        buffer_.resize(rounded);
+        mask_ = rounded - 1;
+    }
+
+    // Copies up to count items into the buffer (producer side).
+    // Returns the number of items actually written; the rest did not fit.
+    size_t push(const T* items, size_t count) {
+        size_t head = head_.load(std::memory_order_relaxed);
+        size_t tail = tail_.load(std::memory_order_acquire);
+        size_t space = buffer_.size() - (head - tail);
+        if (count > space) {
+            count = space;
+        }
+        for (size_t i = 0; i < count; i++) {
+            buffer_[(head + i) & mask_] = items[i];
+        }
+        head_.store(head + count, std::memory_order_release);
+        return count;
+    }
+
+    // Pushes a single item (producer side). Returns false if the buffer is full.
+    bool push(const T& item) {
+        return push(&item, 1) == 1;
+    }
+
+    // Copies up to count items out of the buffer (consumer side).
+    // Returns the number of items actually read.
+    size_t pop(T* items, size_t count) {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        size_t head = head_.load(std::memory_order_acquire);
+        size_t available = head - tail;
+        if (count > available) {
+            count = available;
+        }
+        for (size_t i = 0; i < count; i++) {
+            items[i] = buffer_[(tail + i) & mask_];
+        }
+        tail_.store(tail + count, std::memory_order_release);
+        return count;
+    }
+
+    // Pops a single item (consumer side). Returns false if the buffer is empty.
+    bool pop(T& item) {
+        return pop(&item, 1) == 1;
+    }
+
+    // Returns the number of items currently stored.
+    // Exact for the consumer, a lower bound of the free space for the producer.
+    size_t size() const {
+        return head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_acquire);
+    }
+
+    // Returns the maximum number of items the buffer can hold.
+    size_t capacity() const {
+        return buffer_.size();
+    }
+
+private:
+    std::vector<T> buffer_;                         // Storage, size is a power of two.
+    size_t mask_;                                   // capacity - 1, used to wrap indices.
+    alignas(64) std::atomic<size_t> head_{0};       // Total items written, owned by the producer.
+    alignas(64) std::atomic<size_t> tail_{0};       // Total items read, owned by the consumer.
+};
+
+#endif  // SPSC_RING_BUFFER_H
@@ -0,0 +1,259 @@
+#ifndef STAGE_QUEUE_H
+#define STAGE_QUEUE_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+// What a producer does when the queue in front of the next stage is full.
+enum class DropPolicy {
+    Block,      // Wait for the consumer to make room (backpressure).
+    DropOldest, // Discard the oldest queued item; the newest data wins.
+    DropNewest  // Discard the item being pushed; the queued data wins.
+};
+
+// Size and full-queue behaviour of one StageQueue.
+struct StageQueueConfig {
+    size_t capacity;
+    DropPolicy policy;
+};
+
+// Parses a policy name: block, drop-oldest or drop-newest.
+// Returns false if the name is unknown.
+inline bool parseDropPolicy(const std::string& name, DropPolicy& policy) {
+    if (name == "block") {
+        policy = DropPolicy::Block;
+    } else if (name == "drop-oldest") {
+        policy = DropPolicy::DropOldest;
+    } else if (name == "drop-newest") {
+        policy = DropPolicy::DropNewest;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// The StageQueue class connects two pipeline stages running on threads of
+// their own. It is a bounded lock-free queue for any number of producers and
+// consumers (D. Vyukov's sequence-numbered ring, like the logger's queue):
+// a slot's sequence equals its position while it is free for a producer and
+// position + 1 once it holds an item.
+//
+// Items are exchanged with std::swap, so a producer gets back whatever the
+// slot held before; with every slot filled from a prototype, buffers inside
+// the items circulate between the stages and nothing allocates after
+// construction. The capacity is rounded up to a power of two.
+//
+// push() and tryPop() never take a lock. The waiting variants park on a
+// condition variable, which the other side only touches when someone waits.
+template <typename T>
+class StageQueue {
+public:
+    explicit StageQueue(StageQueueConfig config, const T& prototype = T())
+        : slots_(roundUp(config.capacity)), mask_(slots_.size() - 1), policy_(config.policy) {
+        for (size_t i = 0; i < slots_.size(); i++) {
+            slots_[i].sequence.store(i, std::memory_order_relaxed);
+            slots_[i].item = prototype;
+        }
+    }
+
+    StageQueue(const StageQueue&) = delete;
+    StageQueue& operator=(const StageQueue&) = delete;
+
+    // Queues item, applying the drop policy if the queue is full; item
+    // receives the slot's previous contents. Block waits until there is room
+    // or the queue is closed.
+    // Returns false if the item was not queued (dropped or closed).
+    bool push(T& item) {
+        if (closed_.load(std::memory_order_acquire)) {
+            return false;
+        }
+        pushed_.fetch_add(1, std::memory_order_relaxed);
+        while (!tryPush(item)) {
+            if (policy_ == DropPolicy::DropNewest) {
+                dropped_.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+            if (policy_ == DropPolicy::DropOldest) {
+                if (tryTake(droppedItem())) {
+                    dropped_.fetch_add(1, std::memory_order_relaxed);
+                }
+                continue;
+            }
+            // Block: the consumer wakes us when it takes an item
+            std::unique_lock<std::mutex> lock(mutex_);
+            waiters_.fetch_add(1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            changed_.wait(lock, [&] { return hasRoom() || closed_.load(std::memory_order_acquire); });
+            waiters_.fetch_sub(1, std::memory_order_relaxed);
+            if (closed_.load(std::memory_order_acquire)) {
+                return false;
+            }
+        }
+        notify();
+        return true;
+    }
+
+    // Takes the oldest item without waiting; item's old contents go into the slot.
+    // Returns false if the queue is empty.
+    bool tryPop(T& item) {
+        if (!tryTake(item)) {
+            return false;
+        }
+        notify();
+        return true;
+    }
+
+    // Takes the oldest item, waiting until one arrives, the deadline passes
+    // or the queue is closed. Items queued before close() are still returned.
+    bool pop(T& item, std::chrono::steady_clock::time_point deadline) {
+        while (!tryPop(item)) {
+            std::unique_lock<std::mutex> lock(mutex_);
+            waiters_.fetch_add(1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            bool ready = changed_.wait_until(lock, deadline, [&] {
+                return hasItem() || closed_.load(std::memory_order_acquire);
+            });
+            waiters_.fetch_sub(1, std::memory_order_relaxed);
+            if (!ready || (!hasItem() && closed_.load(std::memory_order_acquire))) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Waits without a deadline.
+    bool pop(T& item) {
+        return pop(item, std::chrono::steady_clock::time_point::max());
+    }
+
+    // Wakes every waiting producer and consumer; further pushes fail.
+    void close() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            closed_.store(true, std::memory_order_release);
+        }
+        changed_.notify_all();
+    }
+
+    bool isClosed() const { return closed_.load(std::memory_order_acquire); }
+
+    // Number of items queued right now (approximate while others are pushing or popping).
+    size_t size() const {
+        size_t tail = tail_.load(std::memory_order_acquire);
+        size_t head = head_.load(std::memory_order_acquire);
+        return tail > head ? tail - head : 0;
+    }
+
+    size_t capacity() const { return slots_.size(); }
+    DropPolicy policy() const { return policy_; }
+
+    // Items offered to push() and items discarded by the drop policy.
+    uint64_t pushedCount() const { return pushed_.load(std::memory_order_relaxed); }
+    uint64_t droppedCount() const { return dropped_.load(std::memory_order_relaxed); }
+
+private:
+    struct Slot {
+        std::atomic<size_t> sequence{0};
+        T item;
+    };
+
+    bool tryPush(T& item) {
+        size_t position = tail_.load(std::memory_order_relaxed);
+        for (;;) {
+            Slot& slot = slots_[position & mask_];
+            size_t sequence = slot.sequence.load(std::memory_order_acquire);
+            intptr_t lag = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+            if (lag == 0) {
+                if (tail_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    std::swap(slot.item, item);
+                    slot.sequence.store(position + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (lag < 0) {
+                return false; // Full: the slot still holds an item from one lap ago
+            } else {
+                position = tail_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    bool tryTake(T& item) {
+        size_t position = head_.load(std::memory_order_relaxed);
+        for (;;) {
+            Slot& slot = slots_[position & mask_];
+            size_t sequence = slot.sequence.load(std::memory_order_acquire);
+            intptr_t lag = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position + 1);
+            if (lag == 0) {
+                if (head_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    std::swap(item, slot.item);
+                    slot.sequence.store(position + slots_.size(), std::memory_order_release);
+                    return true;
+                }
+            } else if (lag < 0) {
+                return false; // Empty: nobody has filled the slot yet
+            } else {
+                position = head_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    static size_t roundUp(size_t capacity) {
+        size_t rounded = 1;
+        while (rounded < capacity) {
+            rounded <<= 1;
+        }
+        return rounded;
+    }
+
+    // Whether the next push or pop would find its slot ready
+    bool hasRoom() const {
+        size_t position = tail_.load(std::memory_order_acquire);
+        return slots_[position & mask_].sequence.load(std::memory_order_acquire) == position;
+    }
+
+    bool hasItem() const {
+        size_t position = head_.load(std::memory_order_acquire);
+        return slots_[position & mask_].sequence.load(std::memory_order_acquire) == position + 1;
+    }
+
+    // Wakes waiters after a push or a pop. The fences on both sides order the
+    // slot update before reading waiters_, and raising waiters_ before
+    // checking the slot, so a waiter either sees the change or is notified.
+    void notify() {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (waiters_.load(std::memory_order_relaxed) > 0) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            changed_.notify_all();
+        }
+    }
+
+    // Where DropOldest puts the item it discards. Thread-local so several
+    // producers can drop at once; it keeps the discarded buffers for reuse.
+    static T& droppedItem() {
+        thread_local T spare;
+        return spare;
+    }
+
+    std::vector<Slot> slots_;
+    size_t mask_;
+    DropPolicy policy_;
+    alignas(64) std::atomic<size_t> tail_{0}; // Next position for a producer
+    alignas(64) std::atomic<size_t> head_{0}; // Next position for a consumer
+
+    std::atomic<uint64_t> pushed_{0};
+    std::atomic<uint64_t> dropped_{0};
+    std::atomic<bool> closed_{false};
+
+    std::mutex mutex_;                  // Only for waiting
+    std::condition_variable changed_;   // Signaled after pushes, pops and close()
+    std::atomic<int> waiters_{0};       // Threads waiting on changed_
+};
+
+#endif  // STAGE_QUEUE_H
@@ -0,0 +1,51 @@
+#include "viseme_scheduler.h"
+#include <algorithm>
+
+VisemeScheduler::VisemeScheduler(int64_t playbackDelay, size_t capacity)
+    : playbackDelay_(playbackDelay), capacity_(capacity), maxLatency_(0), totalLatency_(0),
+      scheduledCount_(0), lateCount_(0) {
+}
+
+void VisemeScheduler::schedule(const std::vector<TimedVowel>& vowels, int64_t captureSample) {
+    int64_t playhead = captureSample - playbackDelay_;
+
+    for (const auto& vowel : vowels) {
+        // Too late to be shown in sync, drop it rather than show it out of place
+        if (vowel.endSample <= playhead) {
+            lateCount_++;
+            continue;
+        }
+
+        int64_t latency = std::max<int64_t>(captureSample - vowel.startSample, 0);
+        maxLatency_ = std::max(maxLatency_, latency);
+        totalLatency_ += latency;
+        scheduledCount_++;
+
+        // Keep the queue ordered by start; new vowels almost always go at the back
+        auto position = std::upper_bound(pending_.begin(), pending_.end(), vowel,
+            [](const TimedVowel& a, const TimedVowel& b) { return a.startSample < b.startSample; });
+        pending_.insert(position, vowel);
+
+        if (pending_.size() > capacity_) {
+            pending_.pop_front();
+        }
+    }
+}
+
+Vowel VisemeScheduler::vowelAt(int64_t captureSample) {
+    int64_t playhead = captureSample - playbackDelay_;
+
+    // Discard vowels that are already over
+    while (!pending_.empty() && pending_.front().endSample <= playhead) {
+        pending_.pop_front();
+    }
+
+    if (!pending_.empty() && pending_.front().startSample <= playhead) {
+        return pending_.front().vowel;
+    }
+    return Vowel::None;
+}
+
+void VisemeScheduler::clear() {
+    pending_.clear();
+}
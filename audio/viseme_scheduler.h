@@ -0,0 +1,55 @@
+#ifndef VISEME_SCHEDULER_H
+#define VISEME_SCHEDULER_H
+
+#include <cstdint>
+#include <deque>
+#include <vector>
+#include "../recognizer/vosk_recognizer.h"
+
+// The VisemeScheduler class plays time-stamped vowels back against the capture
+// clock. Instead of showing recognizer output the moment it arrives (late and
+// in bursts), each vowel is shown while a playhead that trails the capture
+// position by a fixed delay is inside the vowel's interval. Vowels that arrive
+// after their interval has already passed the playhead are dropped, so the
+// lip-sync latency is bounded by the delay.
+class VisemeScheduler {
+public:
+    // Parameters:
+    // - playbackDelay: Distance in samples between the capture position and the playhead.
+    // - capacity: Maximum number of vowels waiting to be played.
+    explicit VisemeScheduler(int64_t playbackDelay = 4800, size_t capacity = 64);
+
+    // Adds vowels with capture-clock timing.
+    // Parameters:
+    // - vowels: Vowels with start and end positions in capture samples.
+    // - captureSample: Current capture position, used to measure arrival latency.
+    void schedule(const std::vector<TimedVowel>& vowels, int64_t captureSample);
+
+    // Returns the vowel under the playhead for the given capture position, or
+    // Vowel::None if none. Vowels the playhead has passed are discarded.
+    Vowel vowelAt(int64_t captureSample);
+
+    // Removes every scheduled vowel.
+    void clear();
+
+    // Latency statistics, in samples, of vowels accepted by schedule():
+    // how long after its start each vowel reached the scheduler.
+    int64_t maxArrivalLatency() const { return maxLatency_; }
+    double averageArrivalLatency() const { return scheduledCount_ ? double(totalLatency_) / scheduledCount_ : 0.0; }
+    uint64_t scheduledCount() const { return scheduledCount_; }
+
+    // Number of vowels dropped because they arrived after the playhead passed them.
+    uint64_t lateCount() const { return lateCount_; }
+
+private:
+    int64_t playbackDelay_;         // Playhead delay behind the capture position.
+    size_t capacity_;               // Maximum number of pending vowels.
+    std::deque<TimedVowel> pending_; // Vowels ordered by start sample.
+
+    int64_t maxLatency_;            // Largest arrival latency seen.
+    int64_t totalLatency_;          // Sum of arrival latencies.
+    uint64_t scheduledCount_;       // Vowels accepted.
+    uint64_t lateCount_;            // Vowels dropped for arriving too late.
+};
+
+#endif  // VISEME_SCHEDULER_H
@@ -0,0 +1,81 @@
+#include "voice_activity_gate.h"
+#include <algorithm>
+
+VoiceActivityGate::VoiceActivityGate(int preRollSamples, int hangoverBlocks, int maxBlockSize)
+    : hangoverBlocks_(hangoverBlocks), hangoverLeft_(0), open_(false),
+      preRoll_(std::max(preRollSamples, 0)), preRollHead_(0), preRollCount_(0), outputStart_(0),
+      samplesIn_(0), samplesForwarded_(0) {
+    // Worst case output is the whole pre-roll followed by one block
+    output_.reserve(preRoll_.size() + std::max(maxBlockSize, 0));
+}
+
+int VoiceActivityGate::process(const short* audio, int size, bool voiced, bool directDetection) {
+    output_.clear();
+    if (!audio || size <= 0) {
+        return 0;
+    }
+    uint64_t blockStart = samplesIn_;
+    samplesIn_ += size;
+
+    // Only speech the detector could not classify by itself needs the decoder
+    bool needsDecoder = voiced && !directDetection;
+
+    if (needsDecoder) {
+        if (!open_) {
+            // Release the pre-roll so the decoder hears the start of the word
+            for (size_t i = 0; i < preRollCount_; i++) {
+                output_.push_back(preRoll_[(preRollHead_ + i) % preRoll_.size()]);
+            }
+            preRollHead_ = 0;
+            preRollCount_ = 0;
+            open_ = true;
+        }
+        hangoverLeft_ = hangoverBlocks_;
+    } else if (open_) {
+        if (hangoverLeft_ > 0) {
+            hangoverLeft_--;
+        } else {
+            open_ = false;
+        }
+    }
+
+    if (!open_) {
+        holdBack(audio, size);
+        return 0;
+    }
+
+    output_.insert(output_.end(), audio, audio + size);
+    outputStart_ = blockStart + size - output_.size();
+    samplesForwarded_ += output_.size();
+    return static_cast<int>(output_.size());
+}
+
+void VoiceActivityGate::holdBack(const short* audio, int size) {
+    if (preRoll_.empty()) {
+        return;
+    }
+
+    // Only the tail of a block longer than the pre-roll matters
+    size_t count = static_cast<size_t>(size);
+    if (count > preRoll_.size()) {
+        audio += count - preRoll_.size();
+        count = preRoll_.size();
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        preRoll_[(preRollHead_ + preRollCount_) % preRoll_.size()] = audio[i];
+        if (preRollCount_ < preRoll_.size()) {
+            preRollCount_++;
+        } else {
+            preRollHead_ = (preRollHead_ + 1) % preRoll_.size();
+        }
+    }
+}
+
+void VoiceActivityGate::reset() {
+    open_ = false;
+    hangoverLeft_ = 0;
+    preRollHead_ = 0;
+    preRollCount_ = 0;
+    output_.clear();
+}
@@ -0,0 +1,69 @@
+#ifndef VOICE_ACTIVITY_GATE_H
+#define VOICE_ACTIVITY_GATE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// The VoiceActivityGate class decides which audio blocks are worth sending to
+// the speech recognizer. It is driven by the VowelDetector's per-block
+// decisions: blocks that are silent, or where the detector already found a
+// vowel on its own, are held back. When speech that needs the recognizer
+// starts, the most recent held-back audio (the pre-roll) is released first so
+// the decoder sees the onset, and the gate stays open for a few blocks after
+// speech ends (the hangover) so the decoder sees the trailing silence it needs
+// to finish an utterance.
+class VoiceActivityGate {
+public:
+    // Parameters:
+    // - preRollSamples: Audio kept while the gate is closed and released when it opens.
+    // - hangoverBlocks: Blocks the gate stays open after the last block that needed decoding.
+    // - maxBlockSize: Largest block passed to process().
+    VoiceActivityGate(int preRollSamples = 4096, int hangoverBlocks = 3, int maxBlockSize = 2048);
+
+    // Processes one block and decides whether it should be decoded.
+    // Parameters:
+    // - audio: The block's samples.
+    // - size: Number of samples in the block.
+    // - voiced: True if the detector did not classify the block as silence.
+    // - directDetection: True if the detector already recognized a vowel in the block.
+    // Returns the number of samples available through output() that should be
+    // sent to the recognizer (0 if the block was held back).
+    int process(const short* audio, int size, bool voiced, bool directDetection);
+
+    // Samples released by the last process() call, oldest first.
+    const short* output() const { return output_.data(); }
+
+    // Position of output()[0] in the stream of samples passed to process().
+    uint64_t outputStartSample() const { return outputStart_; }
+
+    // Checks whether the gate is currently passing audio.
+    bool isOpen() const { return open_; }
+
+    // Counters for reporting how much audio the recognizer did not have to decode.
+    uint64_t samplesIn() const { return samplesIn_; }
+    uint64_t samplesForwarded() const { return samplesForwarded_; }
+    uint64_t samplesSkipped() const { return samplesIn_ > samplesForwarded_ ? samplesIn_ - samplesForwarded_ : 0; }
+
+    // Clears the pre-roll and closes the gate.
+    void reset();
+
+private:
+    int hangoverBlocks_;            // Blocks to keep the gate open after speech.
+    int hangoverLeft_;              // Blocks of hangover remaining.
+    bool open_;                     // Indicates whether audio is being passed.
+
+    std::vector<short> preRoll_;    // Circular buffer of recent held-back audio.
+    size_t preRollHead_;            // Index of the oldest sample in preRoll_.
+    size_t preRollCount_;           // Number of valid samples in preRoll_.
+    std::vector<short> output_;     // Samples released by the last process() call.
+    uint64_t outputStart_;          // Input-stream position of output_[0].
+
+    uint64_t samplesIn_;            // Samples seen by process().
+    uint64_t samplesForwarded_;     // Samples released to the recognizer.
+
+    // Appends a held-back block to the pre-roll, overwriting the oldest audio.
+    void holdBack(const short* audio, int size);
+};
+
+#endif  // VOICE_ACTIVITY_GATE_H
@@ -0,0 +1,105 @@
+#ifndef VOWEL_H
+#define VOWEL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Russian vowels recognized by the pipeline. The order is also the priority
+// used when several vowels are equally likely.
+enum class Vowel : uint8_t {
+    None = 0, // No vowel (silence or unrecognized)
+    A,        // "а"
+    Ya,       // "я"
+    E,        // "э"
+    Ye,       // "е"
+    I,        // "и"
+    Y,        // "ы"
+    O,        // "о"
+    Yo,       // "ё"
+    U,        // "у"
+    Yu,       // "ю"
+    Count
+};
+
+// Mouth shapes. Vowels that look alike on the lips share a group; each group
+// has one image.
+enum class VisemeGroup : uint8_t {
+    Silence = 0, // Closed mouth
+    Open,        // "а", "я"
+    Mid,         // "э", "е"
+    Spread,      // "и"
+    Central,     // "ы"
+    Round,       // "о", "ё"
+    Narrow,      // "у", "ю"
+    Count
+};
+
+constexpr size_t VOWEL_COUNT = static_cast<size_t>(Vowel::Count);
+constexpr size_t VISEME_GROUP_COUNT = static_cast<size_t>(VisemeGroup::Count);
+
+// Viseme group of every vowel, indexed by Vowel.
+constexpr VisemeGroup VISEME_OF_VOWEL[VOWEL_COUNT] = {
+    VisemeGroup::Silence, // None
+    VisemeGroup::Open,    // а
+    VisemeGroup::Open,    // я
+    VisemeGroup::Mid,     // э
+    VisemeGroup::Mid,     // е
+    VisemeGroup::Spread,  // и
+    VisemeGroup::Central, // ы
+    VisemeGroup::Round,   // о
+    VisemeGroup::Round,   // ё
+    VisemeGroup::Narrow,  // у
+    VisemeGroup::Narrow,  // ю
+};
+
+// UTF-8 spelling of every vowel, indexed by Vowel. Used for logging.
+constexpr const char* VOWEL_NAMES[VOWEL_COUNT] = {
+    "", "а", "я", "э", "е", "и", "ы", "о", "ё", "у", "ю"
+};
+
+// ASCII identifier of every vowel, indexed by Vowel. Used in files and
+// machine-readable output.
+constexpr const char* VOWEL_IDS[VOWEL_COUNT] = {
+    "", "a", "ya", "e", "ye", "i", "y", "o", "yo", "u", "yu"
+};
+
+// ASCII identifier of every viseme group, indexed by VisemeGroup.
+constexpr const char* VISEME_GROUP_IDS[VISEME_GROUP_COUNT] = {
+    "silence", "open", "mid", "spread", "central", "round", "narrow"
+};
+
+// Returns the mouth shape for a vowel.
+constexpr VisemeGroup visemeGroup(Vowel vowel) {
+    return VISEME_OF_VOWEL[static_cast<size_t>(vowel)];
+}
+
+// Returns the UTF-8 spelling of a vowel ("" for Vowel::None).
+constexpr const char* vowelName(Vowel vowel) {
+    return VOWEL_NAMES[static_cast<size_t>(vowel)];
+}
+
+// Returns the ASCII identifier of a vowel ("" for Vowel::None).
+constexpr const char* vowelId(Vowel vowel) {
+    return VOWEL_IDS[static_cast<size_t>(vowel)];
+}
+
+// Returns the ASCII identifier of a viseme group.
+constexpr const char* visemeGroupId(VisemeGroup group) {
+    return VISEME_GROUP_IDS[static_cast<size_t>(group)];
+}
+
+// Joins the UTF-8 spellings of the vowels with spaces. Used for logging.
+inline std::string vowelNames(const std::vector<Vowel>& vowels) {
+    std::string names;
+    for (Vowel vowel : vowels) {
+        if (!names.empty()) {
+            names += ' ';
+        }
+        names += vowelName(vowel);
+    }
+    return names;
+}
+
+#endif  // VOWEL_H
@@ -2,47 +2,118 @@
 #define VOWEL_DETECTOR_H
 
 #include <vector>
-#include <string>
-#include <complex>
+#include <cstdint>
+#include <memory>
+#include "formant_engine.h"
+#include "simd_kernels.h"
+#include "vowel_table.h"
+#include "vowel.h"
 
+// The VowelDetector class classifies vowels directly from the audio spectrum
+// using the first two formants. The formants are found by a FormantEngine
+// that can be swapped at runtime (FFT peak picking or LPC). All per-frame buffers live in a workspace owned
+// by the detector, so once it has seen a block size no further heap
+// allocations are made while processing blocks of that size.
+//
+// Audio can be analyzed either block by block with detectVowel(), which looks
+// at the central half of each block, or as a stream with process(), which
+// keeps a sliding history and analyzes an overlapping frame every hop.
 class VowelDetector {
 public:
-    VowelDetector();
-    std::string detectVowel(const std::vector<short>& audioData, int sampleRate = 16000);
+    // Creates a detector with its workspace and formant engine preallocated for
+    // blocks of the given size at the given analysis rate.
+    // Streaming frames are half a block long and start every hopSize samples.
+    explicit VowelDetector(size_t blockSize = 2048, size_t hopSize = 256,
+                           FormantMethod method = FormantMethod::SpectralPeaks, int sampleRate = 16000);
+    // Classifies the central half of a block of at least the constructor's block size.
+    Vowel detectVowel(const std::vector<short>& audioData, int sampleRate = 16000);
+    // Same as above for a block that is not stored in a vector, e.g. a span of a mapped file.
+    Vowel detectVowel(const short* audioData, size_t size, int sampleRate = 16000);
+
+    // Feeds a chunk of any size into the streaming history and analyzes one
+    // frame for every hop completed inside it.
+    // Returns the decision after the most recent frame (unchanged if no frame was due).
+    Vowel process(const short* audioData, size_t size, int sampleRate = 16000);
+    // Forgets the streaming history, e.g. after a gap in the input.
+    void resetStream();
+    size_t hopSize() const { return hop; }
+    // Number of streaming frames analyzed so far.
+    uint64_t framesAnalyzed() const { return streamFrames; }
+
+    // Classifies a single frame without voting over recent frames.
+    // Returns Vowel::None for quiet frames and frames without clear formants.
+    Vowel classifyFrame(const short* frame, size_t size, int sampleRate = 16000);
+
+    // Switches the formant engine; the workspace is re-prepared on the next frame.
+    void setFormantMethod(FormantMethod method);
+    void setFormantEngine(std::unique_ptr<FormantEngine> engine);
+    const char* formantEngineName() const { return formantEngine->name(); }
+    // Replaces the vowel profiles used for classification.
+    void setVowelTable(const VowelTable& table);
+    const VowelTable& vowelProfiles() const { return vowelTable; }
+
+    // Formants of the last frame that had both F1 and F2.
+    const FormantEstimate& lastFormants() const { return formants; }
+
+    // Classification constants, shared with VowelDetectorBank. The energy
+    // thresholds are per sample of the windowed frame, so they hold for any
+    // frame size; they were tuned as 50000 and 10000 over 1024-sample frames.
+    static constexpr double MIN_ENERGY_PER_SAMPLE = 50000.0 / 1024; // Minimum energy level required to detect a vowel
+    static constexpr double SILENCE_PER_SAMPLE = 10000.0 / 1024;    // Level below which the signal is considered silence
+    static constexpr double MIN_SCORE_RATIO = 0.02;         // Minimum vowel score relative to the spectrum maximum
+    static constexpr size_t RECENT_DETECTIONS = 4;          // Frames voted over by getConsistentVowel()
+
+    // Checks whether a windowed frame of size samples with the given energy is loud enough to be speech.
+    static bool isVoicedEnergy(double energy, size_t size);
+
+    // Energy of the windowed frame analyzed by the last detectVowel() or process() frame.
+    double lastFrameEnergy() const { return lastEnergy; }
+    // Checks whether the last analyzed frame was loud enough to be speech.
+    bool lastFrameVoiced() const { return lastVoiced; }
     
 private:
-    std::vector<double> applyWindow(const std::vector<short>& data);
-    std::vector<std::complex<double>> fft(const std::vector<double>& data);
-    std::vector<double> getMagnitudeSpectrum(const std::vector<std::complex<double>>& fftData);
-    std::string classifyVowel(const std::vector<double>& spectrum, int sampleRate);
+    // Windows, transforms and classifies one frame, then votes over recent frames.
+    Vowel analyzeFrame(const short* frame, size_t size, int sampleRate);
+    // Sizes the workspace and Hamming table for frames of frameSize samples.
+    // Only does work when the frame size changes.
+    void prepareWorkspace(size_t frameSize);
+    // Windows the frame into the workspace and returns its energy in the same pass,
+    // using the SIMD kernel selected for this CPU.
+    double applyWindow(const short* data, size_t size);
+    Vowel classifyVowel(const FormantEstimate& formants);
     
-    struct FormantRanges {
-        double f1_min, f1_max;  // First formant frequency range
-        double f2_min, f2_max;  // Second formant frequency range
-    };
-
-    // Formant frequency ranges for different vowels
-    FormantRanges vowel_a = {700, 850, 1100, 1300};   // "a"
-    FormantRanges vowel_ya = {650, 800, 1300, 1500};  // "ya"
-    FormantRanges vowel_e = {500, 650, 1400, 1800};   // "e"
-    FormantRanges vowel_ye = {450, 600, 1600, 2000};  // "ye"
-    FormantRanges vowel_i = {250, 400, 2000, 2800};   // "i"
-    FormantRanges vowel_y = {350, 500, 1200, 1600};   // "y"
-    FormantRanges vowel_o = {450, 650, 850, 1200};    // "o"
-    FormantRanges vowel_yo = {450, 600, 1000, 1300};  // "yo"
-    FormantRanges vowel_u = {300, 450, 600, 1000};    // "u"
-    FormantRanges vowel_yu = {300, 400, 900, 1200};   // "yu"
-
-    double minEnergyThreshold = 50000.0; // Minimum energy level required to detect a vowel
-
-    double silenceThreshold = 10000.0; // Threshold below which the signal is considered silence
+    // Per-frame workspace, sized by prepareWorkspace() and reused for every block
+    size_t frameSize = 0;                         // Size of the centered analysis frame
+    std::vector<float> hammingWindow;             // Cached Hamming coefficients for frameSize
+    std::vector<float> windowedData;              // Windowed frame
+    std::unique_ptr<FormantEngine> formantEngine; // Finds F1/F2 in the windowed frame
+    FormantEstimate formants;                     // Formants of the last classified frame
+    VowelTable vowelTable;                        // Vowel profiles scored against F1/F2
+
+    // Streaming state. The history is written twice (at i and i + streamFrameSize)
+    // so the latest streamFrameSize samples are always contiguous.
+    size_t blockSize;                // Smallest block detectVowel() accepts
+    size_t hop;                      // Samples between the starts of consecutive streaming frames
+    size_t streamFrameSize;          // Length of a streaming frame
+    std::vector<short> history;      // Mirrored ring of the latest samples, 2 * streamFrameSize long
+    size_t historyPos = 0;           // Position of the oldest sample in the ring
+    size_t historyFill = 0;          // Valid samples in the ring
+    size_t sinceLastFrame = 0;       // Samples received since the last streaming frame
+    Vowel streamVowel = Vowel::None; // Decision of the last streaming frame
+    uint64_t streamFrames = 0;       // Streaming frames analyzed
+
+    double lastEnergy = 0.0;   // Energy of the last analyzed frame
+    bool lastVoiced = false;   // Whether the last analyzed frame passed the energy and silence checks
+
     int minConsistentFrames = 2;       // Minimum number of consistent frames required to confirm a vowel
-    std::vector<std::string> recentDetections; // Buffer to store recent vowel detections
-    size_t maxRecentDetections = 4;    // Maximum size of the recent detections buffer
+    std::vector<Vowel> recentDetections; // Ring buffer of recent vowel detections
+    size_t recentHead = 0;             // Index of the oldest entry in recentDetections
+    size_t recentCount = 0;            // Number of valid entries in recentDetections
+    size_t maxRecentDetections = RECENT_DETECTIONS; // Maximum size of the recent detections buffer
     
     // Additional methods:
-    bool isSilence(const std::vector<double>& windowedData); // Check if the given data represents silence
-    std::string getConsistentVowel(); // Retrieve the most consistently detected vowel
+    void addDetection(Vowel vowel); // Push a result into the recent detections ring
+    Vowel getConsistentVowel(); // Retrieve the most consistently detected vowel
 };
 
 #endif
\ No newline at end of file
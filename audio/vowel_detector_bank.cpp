@@ -0,0 +1,196 @@
+#define _USE_MATH_DEFINES
+#include <cmath>
+#include "vowel_detector_bank.h"
+#include "simd_kernels.h"
+#include <algorithm>
+
+VowelDetectorBank::VowelDetectorBank(size_t streamCount, size_t blockSize, size_t hopSize, FormantMethod method)
+    : streams(streamCount), hop(std::max<size_t>(hopSize, 1)), frameLength(blockSize / 2),
+      engine(createFormantEngine(method)) {
+    history.assign(streams * frameLength * 2, 0);
+    recent.assign(VowelDetector::RECENT_DETECTIONS * streams, Vowel::None);
+    decisions.assign(streams, Vowel::None);
+    energies.assign(streams, 0.0);
+    voicedFlags.assign(streams, 0);
+    frameVowels.assign(streams, Vowel::None);
+
+    // Same Hamming coefficients as VowelDetector::prepareWorkspace
+    hammingWindow.resize(frameLength);
+    for (size_t i = 0; i < frameLength; i++) {
+        hammingWindow[i] = static_cast<float>(0.54 - 0.46 * cos(2.0 * M_PI * i / (frameLength - 1)));
+    }
+    windowed.resize(streams * frameLength);
+    voicedStreams.resize(streams);
+
+    size_t bins = frameLength / 2;
+    if (method == FormantMethod::SpectralPeaks && FftPlanF::isSupportedSize(frameLength) && streams > 0) {
+        fftPlan = std::make_unique<BatchFftPlanF>(frameLength, streams);
+        binsReal.resize(bins * streams);
+        binsImag.resize(bins * streams);
+        tileBins.resize(tileStride() * ROW_TILE);
+    }
+    spectrum.resize(bins);
+    peaks.reserve(bins);
+
+    f1.resize(streams);
+    f2.resize(streams);
+    amplitude.resize(streams);
+    minScore.resize(streams);
+    scoredStreams.resize(streams);
+    scoredVowels.resize(streams);
+}
+
+void VowelDetectorBank::process(const short* input, size_t size, int sampleRate) {
+    if (!input || frameLength == 0 || streams == 0) return;
+
+    size_t offset = 0;
+    while (offset < size) {
+        // Samples until the next frame is due, using the same per-sample rule
+        // as VowelDetector::process: the hop has passed and the ring is full
+        size_t untilHop = sinceLastFrame < hop ? hop - sinceLastFrame : 0;
+        size_t untilFull = frameLength - historyFill;
+        size_t untilFrame = std::max<size_t>({1, untilHop, untilFull});
+        size_t count = std::min(untilFrame, size - offset);
+
+        for (size_t s = 0; s < streams; s++) {
+            const short* samples = input + s * size + offset;
+            short* ring = history.data() + s * frameLength * 2;
+            size_t pos = historyPos;
+            for (size_t i = 0; i < count; i++) {
+                ring[pos] = samples[i];
+                ring[pos + frameLength] = samples[i];
+                if (++pos == frameLength) {
+                    pos = 0;
+                }
+            }
+        }
+        historyPos = (historyPos + count) % frameLength;
+        historyFill = std::min(frameLength, historyFill + count);
+        sinceLastFrame += count;
+        offset += count;
+
+        if (count == untilFrame) {
+            sinceLastFrame = 0;
+            analyzeFrame(sampleRate);
+            frames++;
+        }
+    }
+}
+
+void VowelDetectorBank::reset() {
+    historyPos = 0;
+    historyFill = 0;
+    sinceLastFrame = 0;
+    recentCount = 0;
+    recentNext = 0;
+    std::fill(decisions.begin(), decisions.end(), Vowel::None);
+}
+
+void VowelDetectorBank::analyzeFrame(int sampleRate) {
+    const SimdKernels& kernels = simdKernels();
+
+    // Window every stream; voiced frames are packed into the first rows so
+    // the transform only runs on streams that can produce a vowel
+    size_t voicedCount = 0;
+    for (size_t s = 0; s < streams; s++) {
+        const short* frame = history.data() + s * frameLength * 2 + historyPos;
+        float* row = windowed.data() + voicedCount * frameLength;
+        double energy = kernels.windowEnergy(frame, hammingWindow.data(), row, frameLength);
+        bool isVoiced = VowelDetector::isVoicedEnergy(energy, frameLength);
+
+        energies[s] = energy;
+        voicedFlags[s] = isVoiced ? 1 : 0;
+        frameVowels[s] = Vowel::None;
+        if (isVoiced) {
+            voicedStreams[voicedCount++] = s;
+        }
+    }
+
+    if (voicedCount > 0) {
+        estimateFormants(voicedCount, sampleRate);
+    }
+
+    // Vote over the last RECENT_DETECTIONS frames. VowelDetector returns the
+    // first vowel in enum order seen in its ring, which is the smallest
+    // non-None id, so the order of the slots does not matter
+    const size_t slots = VowelDetector::RECENT_DETECTIONS;
+    Vowel* slot = recent.data() + recentNext * streams;
+    std::copy(frameVowels.begin(), frameVowels.end(), slot);
+    recentNext = (recentNext + 1) % slots;
+    recentCount = std::min(recentCount + 1, slots);
+
+    for (size_t s = 0; s < streams; s++) {
+        decisions[s] = Vowel::Count;
+    }
+    for (size_t n = 0; n < recentCount; n++) {
+        const Vowel* votes = recent.data() + n * streams;
+        for (size_t s = 0; s < streams; s++) {
+            bool better = votes[s] != Vowel::None && votes[s] < decisions[s];
+            decisions[s] = better ? votes[s] : decisions[s];
+        }
+    }
+    for (size_t s = 0; s < streams; s++) {
+        if (decisions[s] == Vowel::Count) {
+            decisions[s] = Vowel::None;
+        }
+    }
+}
+
+void VowelDetectorBank::estimateFormants(size_t voicedCount, int sampleRate) {
+    size_t scored = 0;
+    auto addEstimate = [&](size_t row, const FormantEstimate& estimate) {
+        f1[scored] = estimate.f1;
+        f2[scored] = estimate.f2;
+        amplitude[scored] = estimate.f1Amplitude + estimate.f2Amplitude;
+        minScore[scored] = estimate.maxAmplitude * VowelDetector::MIN_SCORE_RATIO;
+        scoredStreams[scored] = voicedStreams[row];
+        scored++;
+    };
+
+    if (fftPlan) {
+        size_t bins = frameLength / 2;
+        const SimdKernels& kernels = simdKernels();
+        fftPlan->forwardReal(windowed.data(), voicedCount, binsReal.data(), binsImag.data());
+
+        // The transform leaves the bins as [bin][row]. A tile of rows at a time
+        // is transposed into one complex row per stream, so the magnitude
+        // kernel and the peak picking see contiguous spectra exactly as a
+        // standalone detector does. The transpose goes in blocks of
+        // ROW_TILE bins, touching one cache line per bin and per row
+        size_t stride = tileStride();
+        for (size_t first = 0; first < voicedCount; first += ROW_TILE) {
+            size_t width = std::min(ROW_TILE, voicedCount - first);
+            for (size_t block = 0; block < bins; block += ROW_TILE) {
+                size_t blockEnd = std::min(bins, block + ROW_TILE);
+                for (size_t r = 0; r < width; r++) {
+                    std::complex<float>* row = tileBins.data() + r * stride;
+                    for (size_t k = block; k < blockEnd; k++) {
+                        size_t index = k * voicedCount + first + r;
+                        row[k] = std::complex<float>(binsReal[index], binsImag[index]);
+                    }
+                }
+            }
+
+            // Peak picking is data dependent, so it runs row by row
+            for (size_t r = 0; r < width; r++) {
+                kernels.magnitude(tileBins.data() + r * stride, spectrum.data(), bins);
+                FormantEstimate estimate;
+                if (pickSpectralFormants(spectrum.data(), bins, sampleRate, peaks, estimate)) {
+                    addEstimate(first + r, estimate);
+                }
+            }
+        }
+    } else {
+        for (size_t row = 0; row < voicedCount; row++) {
+            FormantEstimate estimate;
+            if (engine->estimate(windowed.data() + row * frameLength, frameLength, sampleRate, estimate)) {
+                addEstimate(row, estimate);
+            }
+        }
+    }
+
+    vowelTable.classifyBatch(f1.data(), f2.data(), amplitude.data(), minScore.data(), scoredVowels.data(), scored);
+    for (size_t i = 0; i < scored; i++) {
+        frameVowels[scoredStreams[i]] = scoredVowels[i];
+    }
+}
@@ -0,0 +1,109 @@
+#ifndef VOWEL_DETECTOR_BANK_H
+#define VOWEL_DETECTOR_BANK_H
+
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+#include "fft.h"
+#include "formant_engine.h"
+#include "vowel_detector.h"
+#include "vowel_table.h"
+#include "vowel.h"
+
+// The VowelDetectorBank class runs the streaming VowelDetector algorithm on
+// many audio streams at once, e.g. one per dispenser on a host. The state of
+// all streams is kept in structure-of-arrays form (one array per field,
+// indexed by stream), and every frame is analyzed for all streams in one
+// batched pass: windowing, a BatchFftPlanF transform vectorized across
+// streams, and VowelTable::classifyBatch scoring.
+//
+// All streams advance in lockstep, so the ring position, hop counter and vote
+// count are shared. For every stream the decisions are the ones a standalone
+// VowelDetector with the same block size, hop and method returns from
+// process() when fed the same samples.
+class VowelDetectorBank {
+public:
+    // Creates a bank of streamCount streams. Frames are blockSize / 2 samples
+    // long and start every hopSize samples, as in VowelDetector.
+    VowelDetectorBank(size_t streamCount, size_t blockSize = 2048, size_t hopSize = 256,
+                      FormantMethod method = FormantMethod::SpectralPeaks);
+
+    // Feeds size samples of every stream; stream s reads input[s * size .. s * size + size).
+    // Analyzes one frame of all streams for every hop completed inside the chunk.
+    void process(const short* input, size_t size, int sampleRate = 16000);
+    // Feeds exactly one hop of every stream (input holds streamCount() * hopSize() samples).
+    void processHop(const short* input, int sampleRate = 16000) { process(input, hop, sampleRate); }
+    // Forgets the history and votes of every stream.
+    void reset();
+
+    size_t streamCount() const { return streams; }
+    size_t hopSize() const { return hop; }
+    size_t frameSize() const { return frameLength; }
+    uint64_t framesAnalyzed() const { return frames; }
+
+    // Decision of the last frame of each stream, streamCount() entries.
+    const Vowel* vowels() const { return decisions.data(); }
+    Vowel vowel(size_t stream) const { return decisions[stream]; }
+    // Windowed energy and voicing of the last frame of a stream.
+    double energy(size_t stream) const { return energies[stream]; }
+    bool voiced(size_t stream) const { return voicedFlags[stream] != 0; }
+
+    // Replaces the vowel profiles used for every stream.
+    void setVowelTable(const VowelTable& table) { vowelTable = table; }
+    const VowelTable& vowelProfiles() const { return vowelTable; }
+
+private:
+    // Rows transposed out of the batched FFT output together; their 16 floats
+    // of one bin share a cache line.
+    static constexpr size_t ROW_TILE = 16;
+    // Distance between the rows of tileBins. The padding keeps rows of a
+    // power-of-two length from mapping to the same cache sets.
+    size_t tileStride() const { return frameLength / 2 + 8; }
+
+    // Analyzes the latest frame of every stream and updates the votes.
+    void analyzeFrame(int sampleRate);
+    // Finds the formants of the voiced frames, which are packed at the start of windowed.
+    void estimateFormants(size_t voicedCount, int sampleRate);
+
+    size_t streams;                  // Number of streams
+    size_t hop;                      // Samples between frame starts
+    size_t frameLength;              // Samples per frame
+
+    // Shared streaming state, identical for all streams
+    size_t historyPos = 0;           // Position of the oldest sample in every ring
+    size_t historyFill = 0;          // Valid samples in every ring
+    size_t sinceLastFrame = 0;       // Samples received since the last frame
+    uint64_t frames = 0;             // Frames analyzed
+    size_t recentCount = 0;          // Valid vote slots
+    size_t recentNext = 0;           // Vote slot written by the next frame
+
+    // Per-stream state, one entry (or row) per stream
+    std::vector<short> history;      // Mirrored rings, 2 * frameLength per stream
+    std::vector<Vowel> recent;       // Votes, slot-major: recent[slot * streams + stream]
+    std::vector<Vowel> decisions;    // Decision of the last frame
+    std::vector<double> energies;    // Windowed energy of the last frame
+    std::vector<uint8_t> voicedFlags; // Whether the last frame passed the energy checks
+
+    // Per-frame workspace
+    std::vector<float> hammingWindow;  // Hamming coefficients for frameLength
+    std::vector<float> windowed;       // Windowed voiced frames, one row per voiced stream
+    std::vector<size_t> voicedStreams; // Stream of each row in windowed
+    std::unique_ptr<BatchFftPlanF> fftPlan; // Null for LPC or unsupported frame sizes
+    std::unique_ptr<FormantEngine> engine;  // Per-frame fallback when there is no batch plan
+    std::vector<float> binsReal, binsImag;  // Batched FFT output, [bin][row]
+    std::vector<std::complex<float>> tileBins; // Bins of ROW_TILE rows, tileStride() apart
+    std::vector<float> spectrum;            // Magnitude spectrum of one row
+    std::vector<std::pair<double, double>> peaks; // Peak picking scratch
+
+    // Formants of the rows that have both F1 and F2, packed for classifyBatch
+    std::vector<double> f1, f2, amplitude, minScore;
+    std::vector<size_t> scoredStreams;
+    std::vector<Vowel> scoredVowels;
+    std::vector<Vowel> frameVowels;    // Per-frame decision of every stream before voting
+    VowelTable vowelTable;             // Vowel profiles shared by all streams
+};
+
+#endif  // VOWEL_DETECTOR_BANK_H
@@ -1,21 +1,28 @@
 #include "vowel_queue.h"
-#include <iostream>
+#include "../logging/logger.h"
 
-VowelQueue::VowelQueue() : isEmpty(true) {}
+VowelQueue::VowelQueue() : currentVowel(Vowel::None), isEmpty(true) {}
 
 // Adds vowels to the queue. If the first vowel in the input vector is different 
 // from the current vowel or if the queue is empty, the current vowel is updated.
 // Additionally, the timestamp of the last update is refreshed. If the vowel is 
 // the same as the current one, only the timestamp is updated to prevent the vowel 
 // from being cleared due to timeout.
-void VowelQueue::addVowels(const std::vector<std::string>& vowels) {
-    if (!vowels.empty() && !vowels[0].empty()) {
+void VowelQueue::addVowels(const std::vector<Vowel>& vowels) {
+    if (!vowels.empty()) {
+        addVowel(vowels[0]);
+    }
+}
+
+// Adds a single vowel, with the same smoothing as addVowels.
+void VowelQueue::addVowel(Vowel vowel) {
+    if (vowel != Vowel::None) {
         // Perform a simple smoothing mechanism - change the vowel only if it differs
-        if (currentVowel != vowels[0] || isEmpty) {
-            currentVowel = vowels[0];
+        if (currentVowel != vowel || isEmpty) {
+            currentVowel = vowel;
             lastUpdateTime = std::chrono::steady_clock::now();
             isEmpty = false;
-            std::cout << "Vowel changed to: " << currentVowel << std::endl;
+            LOG_DEBUG("Vowel changed to: " << vowelName(currentVowel));
         } else {
             // Update the timestamp to prevent the vowel from being cleared
             lastUpdateTime = std::chrono::steady_clock::now();
@@ -24,8 +31,8 @@ void VowelQueue::addVowels(const std::vector<std::string>& vowels) {
 }
 
 // Returns the current vowel. If too much time has passed since the last update, 
-// the current vowel is cleared and an empty string is returned.
-std::string VowelQueue::getCurrentVowel() {
+// the current vowel is cleared and Vowel::None is returned.
+Vowel VowelQueue::getCurrentVowel() {
     auto now = std::chrono::steady_clock::now();
     
     // If the timeout duration has passed, clear the current vowel
@@ -33,7 +40,7 @@ std::string VowelQueue::getCurrentVowel() {
         clear();
     }
     
-    return isEmpty ? "" : currentVowel;
+    return isEmpty ? Vowel::None : currentVowel;
 }
 
 // Checks if there are any vowels in the queue. Returns true if the queue is not empty.
@@ -43,6 +50,6 @@ bool VowelQueue::hasVowels() const {
 
 // Clears the current vowel and marks the queue as empty.
 void VowelQueue::clear() {
-    currentVowel.clear();
+    currentVowel = Vowel::None;
     isEmpty = true;
 }
\ No newline at end of file
@@ -1,9 +1,9 @@
 #ifndef VOWEL_QUEUE_H
 #define VOWEL_QUEUE_H
 
-#include <string>
 #include <chrono>
 #include <vector>
+#include "vowel.h"
 
 // The VowelQueue class is responsible for managing a queue of vowels.
 // It provides functionality to add vowels, retrieve the current vowel,
@@ -13,12 +13,16 @@ public:
     VowelQueue(); // Constructor to initialize the VowelQueue object.
 
     // Adds a list of vowels to the queue.
-    // @param vowels: A vector of strings representing the vowels to be added.
-    void addVowels(const std::vector<std::string>& vowels);
+    // @param vowels: The vowels to be added.
+    void addVowels(const std::vector<Vowel>& vowels);
+
+    // Adds a single vowel to the queue.
+    // @param vowel: The vowel to be added; Vowel::None is ignored.
+    void addVowel(Vowel vowel);
 
     // Retrieves the current vowel from the queue.
-    // @return: A string representing the current vowel.
-    std::string getCurrentVowel();
+    // @return: The current vowel, or Vowel::None if the queue is empty.
+    Vowel getCurrentVowel();
 
     // Checks if there are any vowels in the queue.
     // @return: A boolean value indicating whether the queue contains vowels.
@@ -28,7 +32,7 @@ public:
     void clear();
 
 private:
-    std::string currentVowel; // Stores the current vowel being displayed.
+    Vowel currentVowel; // Stores the current vowel being displayed.
     std::chrono::steady_clock::time_point lastUpdateTime; // Tracks the last time the vowel was updated.
     const std::chrono::milliseconds vowelDisplayDuration{100}; // Duration for which each vowel is displayed (100ms).
     bool isEmpty; // Indicates whether the queue is empty.
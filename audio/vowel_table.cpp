@@ -0,0 +1,190 @@
+#include "vowel_table.h"
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include "../logging/logger.h"
+
+namespace {
+
+// Accepts either the ASCII id or the letter of a vowel
+bool parseVowel(const std::string& text, Vowel& vowel) {
+    for (size_t v = 1; v < VOWEL_COUNT; v++) {
+        if (text == VOWEL_IDS[v] || text == VOWEL_NAMES[v]) {
+            vowel = static_cast<Vowel>(v);
+            return true;
+        }
+    }
+    return false;
+}
+
+// Accepts the id of a mouth shape other than the closed mouth
+bool parseVisemeGroup(const std::string& text, VisemeGroup& group) {
+    for (size_t g = 1; g < VISEME_GROUP_COUNT; g++) {
+        if (text == VISEME_GROUP_IDS[g]) {
+            group = static_cast<VisemeGroup>(g);
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace
+
+VowelTable::VowelTable() {
+    std::copy(std::begin(VISEME_OF_VOWEL), std::end(VISEME_OF_VOWEL), viseme_.begin());
+    assign(DEFAULT_VOWEL_PROFILES, DEFAULT_VOWEL_PROFILE_COUNT);
+}
+
+VowelTable::VowelTable(const VowelProfile* profiles, size_t count) {
+    std::copy(std::begin(VISEME_OF_VOWEL), std::end(VISEME_OF_VOWEL), viseme_.begin());
+    assign(profiles, count);
+}
+
+void VowelTable::assign(const VowelProfile* profiles, size_t count) {
+    count_ = std::min(count, MAX_PROFILES);
+    for (size_t i = 0; i < count_; i++) {
+        const VowelProfile& p = profiles[i];
+        vowel_[i] = p.vowel;
+        f1Min_[i] = p.f1Min;
+        f1Max_[i] = p.f1Max;
+        f2Min_[i] = p.f2Min;
+        f2Max_[i] = p.f2Max;
+        coreF1Min_[i] = p.coreF1Min;
+        coreF1Max_[i] = p.coreF1Max;
+        coreF2Min_[i] = p.coreF2Min;
+        coreF2Max_[i] = p.coreF2Max;
+        weight_[i] = p.weight;
+        coreBoost_[i] = p.coreBoost;
+    }
+}
+
+bool VowelTable::loadFromFile(const std::string& path) {
+    std::ifstream file(path);
+    if (!file) {
+        LOG_ERROR("Failed to open vowel table: " << path);
+        return false;
+    }
+
+    VowelProfile profiles[MAX_PROFILES];
+    size_t count = 0;
+    std::array<VisemeGroup, VOWEL_COUNT> viseme;
+    std::copy(std::begin(VISEME_OF_VOWEL), std::end(VISEME_OF_VOWEL), viseme.begin());
+    std::array<bool, VOWEL_COUNT> visemeSet{};
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(file, line)) {
+        lineNumber++;
+        std::istringstream fields(line);
+        std::string name;
+        if (!(fields >> name) || name[0] == '#') {
+            continue;
+        }
+
+        if (count == MAX_PROFILES) {
+            LOG_ERROR("Vowel table " << path << " has more than " << MAX_PROFILES << " profiles");
+            return false;
+        }
+
+        VowelProfile& p = profiles[count];
+        if (!parseVowel(name, p.vowel) ||
+            !(fields >> p.f1Min >> p.f1Max >> p.f2Min >> p.f2Max
+                     >> p.coreF1Min >> p.coreF1Max >> p.coreF2Min >> p.coreF2Max
+                     >> p.weight >> p.coreBoost)) {
+            LOG_ERROR("Invalid vowel profile at " << path << ":" << lineNumber);
+            return false;
+        }
+
+        std::string groupName;
+        if (fields >> groupName) {
+            VisemeGroup group;
+            size_t v = static_cast<size_t>(p.vowel);
+            if (!parseVisemeGroup(groupName, group)) {
+                LOG_ERROR("Unknown viseme group '" << groupName << "' at " << path << ":" << lineNumber);
+                return false;
+            }
+            if (visemeSet[v] && viseme[v] != group) {
+                LOG_ERROR("Conflicting viseme group for '" << VOWEL_IDS[v] << "' at " << path << ":" << lineNumber);
+                return false;
+            }
+            viseme[v] = group;
+            visemeSet[v] = true;
+        }
+        count++;
+    }
+
+    if (count == 0) {
+        LOG_ERROR("Vowel table " << path << " has no profiles");
+        return false;
+    }
+
+    assign(profiles, count);
+    viseme_ = viseme;
+    return true;
+}
+
+Vowel VowelTable::classify(double f1, double f2, double amplitude, double minScore) const {
+    // Every profile is scored with the same arithmetic; range checks become
+    // 0/1 factors instead of branches so the loop vectorizes
+    double scores[MAX_PROFILES];
+    for (size_t i = 0; i < count_; i++) {
+        double inRange = static_cast<double>((f1 >= f1Min_[i]) & (f1 <= f1Max_[i]) &
+                                             (f2 >= f2Min_[i]) & (f2 <= f2Max_[i]));
+        double inCore = static_cast<double>((f1 >= coreF1Min_[i]) & (f1 <= coreF1Max_[i]) &
+                                            (f2 >= coreF2Min_[i]) & (f2 <= coreF2Max_[i]));
+        scores[i] = amplitude * weight_[i] * inRange * (1.0 + (coreBoost_[i] - 1.0) * inCore);
+    }
+
+    // Highest score wins, earlier profiles win ties
+    size_t best = 0;
+    for (size_t i = 1; i < count_; i++) {
+        if (scores[i] > scores[best]) {
+            best = i;
+        }
+    }
+
+    if (count_ == 0 || scores[best] < minScore || scores[best] <= 0.0) {
+        return Vowel::None;
+    }
+    return vowel_[best];
+}
+
+void VowelTable::classifyBatch(const double* f1, const double* f2, const double* amplitude,
+                               const double* minScore, Vowel* out, size_t count) const {
+    // Frames are scored in fixed chunks so the running best fits on the stack
+    const size_t CHUNK = 64;
+    double bestScore[CHUNK];
+    size_t bestIndex[CHUNK];
+
+    for (size_t base = 0; base < count; base += CHUNK) {
+        size_t n = std::min(CHUNK, count - base);
+        const double* x1 = f1 + base;
+        const double* x2 = f2 + base;
+        const double* amp = amplitude + base;
+
+        for (size_t j = 0; j < n; j++) {
+            bestScore[j] = 0.0;
+            bestIndex[j] = 0;
+        }
+
+        // Same arithmetic and tie rule as classify(): the first profile seeds
+        // the best score, later ones replace it only when strictly higher
+        for (size_t i = 0; i < count_; i++) {
+            for (size_t j = 0; j < n; j++) {
+                double inRange = static_cast<double>((x1[j] >= f1Min_[i]) & (x1[j] <= f1Max_[i]) &
+                                                     (x2[j] >= f2Min_[i]) & (x2[j] <= f2Max_[i]));
+                double inCore = static_cast<double>((x1[j] >= coreF1Min_[i]) & (x1[j] <= coreF1Max_[i]) &
+                                                    (x2[j] >= coreF2Min_[i]) & (x2[j] <= coreF2Max_[i]));
+                double score = amp[j] * weight_[i] * inRange * (1.0 + (coreBoost_[i] - 1.0) * inCore);
+                bool better = i == 0 || score > bestScore[j];
+                bestScore[j] = better ? score : bestScore[j];
+                bestIndex[j] = better ? i : bestIndex[j];
+            }
+        }
+
+        for (size_t j = 0; j < n; j++) {
+            bool accepted = count_ != 0 && !(bestScore[j] < minScore[base + j]) && bestScore[j] > 0.0;
+            out[base + j] = accepted ? vowel_[bestIndex[j]] : Vowel::None;
+        }
+    }
+}
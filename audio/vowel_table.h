@@ -0,0 +1,94 @@
+#ifndef VOWEL_TABLE_H
+#define VOWEL_TABLE_H
+
+#include <array>
+#include <cstddef>
+#include <string>
+#include "vowel.h"
+
+// Formant description of one vowel. A frame whose F1/F2 fall inside the
+// outer ranges scores (F1 amplitude + F2 amplitude) * weight; inside the core
+// ranges the score is multiplied by coreBoost as well. The viseme group is
+// looked up per vowel in the VowelTable (see VowelTable::visemeGroup()).
+struct VowelProfile {
+    Vowel vowel;
+    double f1Min, f1Max;         // Accepted F1 range in Hz
+    double f2Min, f2Max;         // Accepted F2 range in Hz
+    double coreF1Min, coreF1Max; // Typical F1 range in Hz
+    double coreF2Min, coreF2Max; // Typical F2 range in Hz
+    double weight;               // Score per unit of formant amplitude
+    double coreBoost;            // Score multiplier inside the core ranges
+};
+
+// Built-in profiles of the Russian vowels. Earlier entries win ties.
+constexpr VowelProfile DEFAULT_VOWEL_PROFILES[] = {
+    //  vowel       F1 range    F2 range     core F1     core F2      weight boost
+    {Vowel::A,  650, 900, 1000, 1500, 700, 850, 1100, 1300, 0.5, 1.5},
+    {Vowel::Ya, 600, 850, 1200, 1600, 650, 800, 1300, 1500, 0.4, 1.3},
+    {Vowel::E,  450, 700, 1300, 2000, 500, 650, 1400, 1800, 0.5, 1.5},
+    {Vowel::Ye, 400, 650, 1500, 2100, 450, 600, 1600, 2000, 0.4, 1.3},
+    {Vowel::I,  200, 450, 1800, 3000, 250, 400, 2000, 2800, 0.5, 1.5},
+    {Vowel::Y,  300, 550, 1100, 1700, 350, 500, 1200, 1600, 0.5, 1.5},
+    {Vowel::O,  400, 700,  800, 1300, 450, 650,  850, 1200, 0.5, 1.5},
+    {Vowel::Yo, 400, 650,  900, 1400, 450, 600, 1000, 1300, 0.4, 1.3},
+    {Vowel::U,  250, 500,  550, 1100, 300, 450,  600, 1000, 0.5, 1.5},
+    {Vowel::Yu, 250, 450,  800, 1300, 300, 400,  900, 1200, 0.4, 1.3},
+};
+
+constexpr size_t DEFAULT_VOWEL_PROFILE_COUNT = sizeof(DEFAULT_VOWEL_PROFILES) / sizeof(DEFAULT_VOWEL_PROFILES[0]);
+
+// The VowelTable class stores vowel profiles column by column, so scoring a
+// frame against every vowel is one branch-free loop over contiguous arrays.
+// It also maps each vowel to the mouth shape shown for it, which starts as
+// the built-in VISEME_OF_VOWEL and can be changed per vowel by a table file.
+// Tables are fixed-capacity and never allocate.
+//
+// Profiles can only name the vowels of the Vowel enum; a table tunes the
+// formant ranges and mouth shapes of those vowels, it cannot add new ones.
+class VowelTable {
+public:
+    static constexpr size_t MAX_PROFILES = 32;
+
+    // Creates the table of the built-in Russian profiles.
+    VowelTable();
+    // Creates a table from the given profiles; extra profiles beyond MAX_PROFILES are ignored.
+    VowelTable(const VowelProfile* profiles, size_t count);
+
+    // Replaces the table with profiles read from a text file. Each non-empty
+    // line that does not start with '#' holds one profile:
+    //   vowel f1Min f1Max f2Min f2Max coreF1Min coreF1Max coreF2Min coreF2Max weight coreBoost [viseme]
+    // where vowel is a Latin id (a, ya, e, ye, i, y, o, yo, u, yu) or the
+    // vowel letter itself, and the optional viseme is a group id (open, mid,
+    // spread, central, round, narrow) that replaces the vowel's built-in mouth
+    // shape. Profiles of the same vowel must agree on the group.
+    // On error the table is left unchanged.
+    // Returns:
+    // - true if the file was read and held at least one profile, false otherwise.
+    bool loadFromFile(const std::string& path);
+
+    // Scores F1/F2 against every profile and returns the best vowel, or
+    // Vowel::None if the best score is below minScore.
+    Vowel classify(double f1, double f2, double amplitude, double minScore) const;
+
+    // Classifies count frames at once; out[i] equals classify() of frame i.
+    // Profiles are the outer loop, so the scoring vectorizes across frames.
+    void classifyBatch(const double* f1, const double* f2, const double* amplitude,
+                       const double* minScore, Vowel* out, size_t count) const;
+
+    size_t size() const { return count_; }
+
+    // Returns the mouth shape shown for a vowel.
+    VisemeGroup visemeGroup(Vowel vowel) const { return viseme_[static_cast<size_t>(vowel)]; }
+
+private:
+    void assign(const VowelProfile* profiles, size_t count);
+
+    size_t count_ = 0;
+    std::array<VisemeGroup, VOWEL_COUNT> viseme_{}; // Mouth shape of every vowel, indexed by Vowel
+    std::array<Vowel, MAX_PROFILES> vowel_{};
+    std::array<double, MAX_PROFILES> f1Min_{}, f1Max_{}, f2Min_{}, f2Max_{};
+    std::array<double, MAX_PROFILES> coreF1Min_{}, coreF1Max_{}, coreF2Min_{}, coreF2Max_{};
+    std::array<double, MAX_PROFILES> weight_{}, coreBoost_{};
+};
+
+#endif  // VOWEL_TABLE_H
@@ -0,0 +1,160 @@
+// Compares the FFT peak picking and LPC formant engines on synthetic vowels:
+// CPU time per frame, accuracy against the synthesized vowel and how often
+// the two engines agree. Also times VowelDetectorBank against the same
+// number of standalone detectors streaming the frames.
+//
+// Usage: formant_bench [frames per vowel]
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+#include "../audio/vowel_detector.h"
+#include "../audio/vowel_detector_bank.h"
+#include "../logging/logger.h"
+#include "synthetic_vowels.h"
+
+namespace {
+
+const int SAMPLE_RATE = 16000;
+const size_t FRAME_SIZE = 1024;
+
+struct EngineResult {
+    double nanosecondsPerFrame = 0.0;
+    int correct = 0;
+    std::vector<Vowel> decisions;
+};
+
+EngineResult runEngine(FormantMethod method, const std::vector<std::vector<short>>& frames,
+                       const std::vector<Vowel>& truth) {
+    VowelDetector detector(FRAME_SIZE * 2, 256, method, SAMPLE_RATE);
+    EngineResult result;
+    result.decisions.resize(frames.size());
+
+    // Warm up caches and workspace before timing
+    for (size_t i = 0; i < frames.size() && i < 16; i++) {
+        detector.classifyFrame(frames[i].data(), FRAME_SIZE, SAMPLE_RATE);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < frames.size(); i++) {
+        result.decisions[i] = detector.classifyFrame(frames[i].data(), FRAME_SIZE, SAMPLE_RATE);
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    result.nanosecondsPerFrame = std::chrono::duration<double, std::nano>(elapsed).count() / frames.size();
+
+    for (size_t i = 0; i < frames.size(); i++) {
+        if (result.decisions[i] == truth[i]) {
+            result.correct++;
+        }
+    }
+    return result;
+}
+
+struct BankResult {
+    double nanosecondsPerBank = 0.0;
+    double nanosecondsPerDetectors = 0.0;
+    size_t decisions = 0;
+    size_t matching = 0;
+};
+
+// Streams the frames through BANK_STREAMS detectors, each stream starting at a
+// different frame, and compares a VowelDetectorBank with standalone detectors
+BankResult runBank(const std::vector<std::vector<short>>& frames) {
+    const size_t BANK_STREAMS = 16;
+    const size_t HOP = 256;
+    BankResult result;
+
+    // Planar input, hop by hop: hop h of stream s starts at (h * BANK_STREAMS + s) * HOP
+    size_t hopsPerFrame = FRAME_SIZE / HOP;
+    size_t hops = frames.size() * hopsPerFrame;
+    std::vector<short> input(hops * BANK_STREAMS * HOP);
+    for (size_t h = 0; h < hops; h++) {
+        for (size_t s = 0; s < BANK_STREAMS; s++) {
+            size_t sample = ((h + s * 37 * hopsPerFrame) % hops) * HOP;
+            const std::vector<short>& frame = frames[sample / FRAME_SIZE];
+            std::copy(frame.begin() + sample % FRAME_SIZE, frame.begin() + sample % FRAME_SIZE + HOP,
+                      input.begin() + (h * BANK_STREAMS + s) * HOP);
+        }
+    }
+
+    VowelDetectorBank bank(BANK_STREAMS, FRAME_SIZE * 2, HOP);
+    std::vector<VowelDetector> detectors;
+    for (size_t s = 0; s < BANK_STREAMS; s++) {
+        detectors.emplace_back(FRAME_SIZE * 2, HOP, FormantMethod::SpectralPeaks, SAMPLE_RATE);
+    }
+    std::vector<Vowel> bankVowels(hops * BANK_STREAMS), detectorVowels(hops * BANK_STREAMS);
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t h = 0; h < hops; h++) {
+        bank.processHop(input.data() + h * BANK_STREAMS * HOP, SAMPLE_RATE);
+        std::copy(bank.vowels(), bank.vowels() + BANK_STREAMS, bankVowels.begin() + h * BANK_STREAMS);
+    }
+    auto middle = std::chrono::steady_clock::now();
+    for (size_t h = 0; h < hops; h++) {
+        for (size_t s = 0; s < BANK_STREAMS; s++) {
+            const short* hop = input.data() + (h * BANK_STREAMS + s) * HOP;
+            detectorVowels[h * BANK_STREAMS + s] = detectors[s].process(hop, HOP, SAMPLE_RATE);
+        }
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    double streamFrames = static_cast<double>(bank.framesAnalyzed() * BANK_STREAMS);
+    result.nanosecondsPerBank = std::chrono::duration<double, std::nano>(middle - start).count() / streamFrames;
+    result.nanosecondsPerDetectors = std::chrono::duration<double, std::nano>(end - middle).count() / streamFrames;
+    result.decisions = bankVowels.size();
+    for (size_t i = 0; i < bankVowels.size(); i++) {
+        if (bankVowels[i] == detectorVowels[i]) {
+            result.matching++;
+        }
+    }
+    return result;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    int framesPerVowel = argc > 1 ? std::atoi(argv[1]) : 200;
+    if (framesPerVowel <= 0) {
+        std::cerr << "Usage: formant_bench [frames per vowel]" << std::endl;
+        return 1;
+    }
+
+    std::mt19937 rng(12345);
+    std::vector<std::vector<short>> frames;
+    std::vector<Vowel> truth;
+    for (const auto& target : SYNTHETIC_VOWELS) {
+        for (int n = 0; n < framesPerVowel; n++) {
+            frames.emplace_back(FRAME_SIZE);
+            synthesizeVowelFrame(target, SAMPLE_RATE, rng, frames.back());
+            truth.push_back(target.vowel);
+        }
+    }
+
+    // Keep the detector's per-frame logging out of the timings
+    Logger::setLevel(LogLevel::Warn);
+    EngineResult fft = runEngine(FormantMethod::SpectralPeaks, frames, truth);
+    EngineResult lpc = runEngine(FormantMethod::Lpc, frames, truth);
+    BankResult bank = runBank(frames);
+
+    int agree = 0;
+    for (size_t i = 0; i < frames.size(); i++) {
+        if (fft.decisions[i] == lpc.decisions[i]) {
+            agree++;
+        }
+    }
+
+    double total = static_cast<double>(frames.size());
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << "kernels: " << simdKernels().name << std::endl;
+    std::cout << "frames: " << frames.size() << " (" << FRAME_SIZE << " samples at " << SAMPLE_RATE << " Hz)" << std::endl;
+    std::cout << "engine  ns/frame  accuracy" << std::endl;
+    std::cout << "fft     " << std::setw(8) << fft.nanosecondsPerFrame << "  " << 100.0 * fft.correct / total << "%" << std::endl;
+    std::cout << "lpc     " << std::setw(8) << lpc.nanosecondsPerFrame << "  " << 100.0 * lpc.correct / total << "%" << std::endl;
+    std::cout << "agreement: " << 100.0 * agree / total << "%" << std::endl;
+    std::cout << "bank ns/stream-frame: " << bank.nanosecondsPerBank
+              << " (standalone detectors " << bank.nanosecondsPerDetectors << "), matching "
+              << 100.0 * bank.matching / bank.decisions << "%" << std::endl;
+    return 0;
+}
@@ -0,0 +1,418 @@
+// Microbenchmarks of the hot paths, for tracking regressions between releases:
+// - VowelDetector::detectVowel, classifyFrame and the stages of a frame
+//   (windowing, FFT, formant picking, classification) for several frame sizes;
+// - the Vosk result handling: parseVoskJson on typical partial and final
+//   payloads, extractVowels and extractNewVowels;
+// - VowelQueue operations;
+// - with --model, --recording and --transcript: real-time factor and vowel
+//   accuracy of SpeechRecognizer in FullVocabulary and VowelGrammar mode.
+//
+// Usage: dispenser_microbench [--filter <text>] [--min-time <ms>]
+//                             [--model <dir> --recording <file> --transcript <file>]
+//
+// Output is one JSON object per line. The first describes the run, every
+// other one a benchmark:
+//   {"bench":"detectVowel","param":"frame=1024","ns_per_op":15123.4,"min_ns_per_op":14987.0,"ops":4096}
+// ns_per_op is the median over ROUNDS rounds, min_ns_per_op the fastest round.
+// Recognizer lines carry "rtf", "vowel_accuracy" and "audio_seconds" instead.
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "synthetic_vowels.h"
+#include "../audio/fft.h"
+#include "../audio/file_audio_source.h"
+#include "../audio/formant_engine.h"
+#include "../audio/multirate_front_end.h"
+#include "../audio/simd_kernels.h"
+#include "../audio/vowel_detector.h"
+#include "../audio/vowel_queue.h"
+#include "../audio/vowel_table.h"
+#include "../recognizer/vosk_json.h"
+#include "../recognizer/vosk_recognizer.h"
+#include "../logging/logger.h"
+
+namespace {
+
+const int SAMPLE_RATE = 16000;
+const size_t FRAME_SIZES[] = {256, 512, 1024, 2048};
+const size_t FRAMES_PER_SIZE = 64; // Distinct synthetic frames cycled through by each benchmark
+const int ROUNDS = 5;
+
+struct Options {
+    std::string filter;
+    double minTimeMs = 200.0; // Time spent measuring each benchmark, all rounds together
+    std::string modelPath;
+    std::string recordingPath;
+    std::string transcriptPath;
+};
+
+Options options;
+std::vector<std::string> output; // Result lines, printed once every benchmark has run
+volatile uint64_t sink = 0;      // Keeps results alive so the work is not optimized away
+
+bool selected(const std::string& name) {
+    return options.filter.empty() || name.find(options.filter) != std::string::npos;
+}
+
+// Runs op(n), which performs n operations, until the timing is stable and
+// records the median and best round in ns per operation
+template <typename Op>
+void measure(const std::string& name, const std::string& param, Op op) {
+    if (!selected(name)) {
+        return;
+    }
+    using Clock = std::chrono::steady_clock;
+    auto timeRound = [&](uint64_t n) {
+        auto start = Clock::now();
+        op(n);
+        return std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+    };
+
+    // Grow the round until it takes its share of the time budget
+    double roundBudget = options.minTimeMs * 1e6 / ROUNDS;
+    uint64_t n = 1;
+    double elapsed = timeRound(n);
+    while (elapsed < roundBudget && n < (uint64_t(1) << 40)) {
+        double scale = elapsed > 0.0 ? roundBudget / elapsed : 100.0;
+        n = std::max(n + 1, static_cast<uint64_t>(n * std::min(scale * 1.1, 100.0)));
+        elapsed = timeRound(n);
+    }
+
+    std::vector<double> perOp;
+    for (int r = 0; r < ROUNDS; r++) {
+        perOp.push_back(timeRound(n) / n);
+    }
+    std::sort(perOp.begin(), perOp.end());
+
+    char line[256];
+    std::snprintf(line, sizeof(line),
+                  "{\"bench\":\"%s\",\"param\":\"%s\",\"ns_per_op\":%.1f,\"min_ns_per_op\":%.1f,\"ops\":%llu}",
+                  name.c_str(), param.c_str(), perOp[ROUNDS / 2], perOp[0], static_cast<unsigned long long>(n));
+    output.push_back(line);
+}
+
+std::vector<std::vector<short>> makeFrames(size_t size, std::mt19937& rng) {
+    std::vector<std::vector<short>> frames(FRAMES_PER_SIZE, std::vector<short>(size));
+    for (size_t i = 0; i < frames.size(); i++) {
+        synthesizeVowelFrame(SYNTHETIC_VOWELS[i % (sizeof(SYNTHETIC_VOWELS) / sizeof(SYNTHETIC_VOWELS[0]))],
+                             SAMPLE_RATE, rng, frames[i]);
+    }
+    return frames;
+}
+
+// VowelDetector::detectVowel on whole blocks, and each of its stages on its own
+void benchDetector() {
+    std::mt19937 rng(12345);
+    for (size_t frameSize : FRAME_SIZES) {
+        std::string param = "frame=" + std::to_string(frameSize);
+
+        // detectVowel analyzes the central half of a block; classifyFrame is the
+        // per-frame work of both detectVowel and the streaming process()
+        std::vector<std::vector<short>> blocks = makeFrames(frameSize * 2, rng);
+        for (FormantMethod method : {FormantMethod::SpectralPeaks, FormantMethod::Lpc}) {
+            std::string suffix = method == FormantMethod::Lpc ? ".lpc" : "";
+            VowelDetector detector(frameSize * 2, 256, method, SAMPLE_RATE);
+            measure("detectVowel" + suffix, param, [&](uint64_t n) {
+                for (uint64_t i = 0; i < n; i++) {
+                    sink += static_cast<uint64_t>(detector.detectVowel(blocks[i % blocks.size()], SAMPLE_RATE));
+                }
+            });
+            measure("classifyFrame" + suffix, param, [&](uint64_t n) {
+                for (uint64_t i = 0; i < n; i++) {
+                    const std::vector<short>& block = blocks[i % blocks.size()];
+                    sink += static_cast<uint64_t>(detector.classifyFrame(block.data() + frameSize / 2, frameSize,
+                                                                         SAMPLE_RATE));
+                }
+            });
+        }
+
+        // applyWindow: int16 to float, Hamming window and energy in one pass
+        std::vector<std::vector<short>> frames = makeFrames(frameSize, rng);
+        std::vector<float> window(frameSize), windowed(frameSize);
+        for (size_t i = 0; i < frameSize; i++) {
+            window[i] = static_cast<float>(0.54 - 0.46 * std::cos(2.0 * 3.14159265358979323846 * i / (frameSize - 1)));
+        }
+        const SimdKernels& kernels = simdKernels();
+        measure("applyWindow", param, [&](uint64_t n) {
+            for (uint64_t i = 0; i < n; i++) {
+                sink += static_cast<uint64_t>(kernels.windowEnergy(frames[i % frames.size()].data(), window.data(),
+                                                                   windowed.data(), frameSize));
+            }
+        });
+
+        // fft: the real transform the spectral engine runs on the windowed frame
+        std::vector<std::vector<float>> windowedFrames(frames.size(), std::vector<float>(frameSize));
+        for (size_t f = 0; f < frames.size(); f++) {
+            kernels.windowEnergy(frames[f].data(), window.data(), windowedFrames[f].data(), frameSize);
+        }
+        FftPlanF plan(frameSize);
+        std::vector<std::complex<float>> bins(frameSize / 2);
+        measure("fft", param, [&](uint64_t n) {
+            for (uint64_t i = 0; i < n; i++) {
+                plan.forwardReal(windowedFrames[i % windowedFrames.size()].data(), bins.data());
+                sink += static_cast<uint64_t>(bins[1].real());
+            }
+        });
+
+        // formants: spectrum and peak picking (fft) or the LPC envelope (lpc)
+        std::vector<FormantEstimate> estimates(frames.size());
+        for (FormantMethod method : {FormantMethod::SpectralPeaks, FormantMethod::Lpc}) {
+            std::unique_ptr<FormantEngine> engine = createFormantEngine(method);
+            engine->prepare(frameSize, SAMPLE_RATE);
+            for (size_t f = 0; f < frames.size(); f++) {
+                engine->estimate(windowedFrames[f].data(), frameSize, SAMPLE_RATE, estimates[f]);
+            }
+            measure(std::string("formants.") + formantMethodName(method), param, [&](uint64_t n) {
+                FormantEstimate estimate;
+                for (uint64_t i = 0; i < n; i++) {
+                    sink += engine->estimate(windowedFrames[i % windowedFrames.size()].data(), frameSize,
+                                             SAMPLE_RATE, estimate);
+                }
+            });
+        }
+
+        // classifyVowel: scoring F1/F2 against the vowel profiles, as the detector does
+        VowelTable table;
+        measure("classifyVowel", param, [&](uint64_t n) {
+            for (uint64_t i = 0; i < n; i++) {
+                const FormantEstimate& e = estimates[i % estimates.size()];
+                sink += static_cast<uint64_t>(table.classify(e.f1, e.f2, e.f1Amplitude + e.f2Amplitude,
+                                                             e.maxAmplitude * VowelDetector::MIN_SCORE_RATIO));
+            }
+        });
+    }
+}
+
+// Typical Vosk results: growing partials of a short phrase and the final
+// result with word timing, as returned with word times enabled
+const char* const PARTIAL_PAYLOADS[] = {
+    "{\n  \"partial\" : \"\"\n}",
+    "{\n  \"partial\" : \"привет\"\n}",
+    "{\n  \"partial\" : \"привет как\"\n}",
+    "{\n  \"partial\" : \"привет как дела\"\n}",
+};
+
+const char* const PARTIAL_WORDS_PAYLOAD =
+    "{\n  \"partial\" : \"привет как дела\",\n  \"partial_result\" : [{\n      \"conf\" : 1.000000,\n"
+    "      \"end\" : 0.960000,\n      \"start\" : 0.450000,\n      \"word\" : \"привет\"\n    }, {\n"
+    "      \"conf\" : 1.000000,\n      \"end\" : 1.230000,\n      \"start\" : 0.990000,\n      \"word\" : \"как\"\n"
+    "    }, {\n      \"conf\" : 1.000000,\n      \"end\" : 1.680000,\n      \"start\" : 1.260000,\n"
+    "      \"word\" : \"дела\"\n    }]\n}";
+
+const char* const FINAL_PAYLOAD =
+    "{\n  \"result\" : [{\n      \"conf\" : 0.981234,\n      \"end\" : 0.960000,\n      \"start\" : 0.450000,\n"
+    "      \"word\" : \"привет\"\n    }, {\n      \"conf\" : 0.874512,\n      \"end\" : 1.230000,\n"
+    "      \"start\" : 0.990000,\n      \"word\" : \"как\"\n    }, {\n      \"conf\" : 1.000000,\n"
+    "      \"end\" : 1.680000,\n      \"start\" : 1.260000,\n      \"word\" : \"дела\"\n    }, {\n"
+    "      \"conf\" : 0.912345,\n      \"end\" : 2.370000,\n      \"start\" : 1.920000,\n      \"word\" : \"мама\"\n"
+    "    }],\n  \"text\" : \"привет как дела мама\"\n}";
+
+// The Vosk result handling SpeechRecognizer does after every decoded block
+void benchRecognizerHelpers() {
+    std::vector<VoskJsonWord> words(64);
+    VoskJsonResult result;
+
+    measure("parseVoskJson", "partial", [&](uint64_t n) {
+        for (uint64_t i = 0; i < n; i++) {
+            sink += parseVoskJson(PARTIAL_PAYLOADS[i % 4], result, words.data(), words.size());
+            sink += result.text.size();
+        }
+    });
+    measure("parseVoskJson", "partial-words", [&](uint64_t n) {
+        for (uint64_t i = 0; i < n; i++) {
+            sink += parseVoskJson(PARTIAL_WORDS_PAYLOAD, result, words.data(), words.size());
+            sink += result.wordCount;
+        }
+    });
+    measure("parseVoskJson", "final-words", [&](uint64_t n) {
+        for (uint64_t i = 0; i < n; i++) {
+            sink += parseVoskJson(FINAL_PAYLOAD, result, words.data(), words.size());
+            sink += result.wordCount;
+        }
+    });
+
+    // The text helpers need no model
+    SpeechRecognizer recognizer(std::shared_ptr<VoskModel>(), SpeechRecognizer::Mode::FullVocabulary);
+    const std::string finalText = "привет как дела мама";
+    measure("extractVowels", "final", [&](uint64_t n) {
+        for (uint64_t i = 0; i < n; i++) {
+            sink += recognizer.extractVowels(finalText).size();
+        }
+    });
+    measure("extractNewVowels", "partial-growth", [&](uint64_t n) {
+        const std::string partials[] = {"", "привет", "привет как", "привет как дела", finalText};
+        for (uint64_t i = 0; i < n; i++) {
+            size_t k = i % 4;
+            sink += recognizer.extractNewVowels(partials[k + 1], partials[k]).size();
+        }
+    });
+}
+
+void benchVowelQueue() {
+    const Vowel vowels[] = {Vowel::A, Vowel::O, Vowel::I, Vowel::U};
+    VowelQueue queue;
+    measure("VowelQueue.addVowel", "repeat", [&](uint64_t n) {
+        for (uint64_t i = 0; i < n; i++) {
+            queue.addVowel(Vowel::A);
+        }
+    });
+    measure("VowelQueue.addVowel", "change", [&](uint64_t n) {
+        for (uint64_t i = 0; i < n; i++) {
+            queue.addVowel(vowels[i % 4]);
+        }
+    });
+    measure("VowelQueue.addVowels", "result", [&](uint64_t n) {
+        const std::vector<Vowel> result = {Vowel::I, Vowel::E, Vowel::A};
+        for (uint64_t i = 0; i < n; i++) {
+            queue.addVowels(result);
+        }
+    });
+    measure("VowelQueue.getCurrentVowel", "", [&](uint64_t n) {
+        for (uint64_t i = 0; i < n; i++) {
+            sink += static_cast<uint64_t>(queue.getCurrentVowel());
+        }
+    });
+}
+
+// Levenshtein distance between two vowel sequences
+size_t editDistance(const std::vector<Vowel>& a, const std::vector<Vowel>& b) {
+    std::vector<size_t> row(b.size() + 1);
+    for (size_t j = 0; j <= b.size(); j++) {
+        row[j] = j;
+    }
+    for (size_t i = 1; i <= a.size(); i++) {
+        size_t diagonal = row[0];
+        row[0] = i;
+        for (size_t j = 1; j <= b.size(); j++) {
+            size_t above = row[j];
+            row[j] = std::min({row[j] + 1, row[j - 1] + 1, diagonal + (a[i - 1] == b[j - 1] ? 0 : 1)});
+            diagonal = above;
+        }
+    }
+    return row[b.size()];
+}
+
+// Decodes a recording in both modes and compares the vowels the application
+// would see (new vowels of every changed result) with the transcript's
+bool benchRecognizerModes() {
+    if ((options.modelPath.empty() && options.recordingPath.empty()) || !selected("recognizer")) {
+        return true;
+    }
+    if (options.modelPath.empty() || options.recordingPath.empty() || options.transcriptPath.empty()) {
+        std::cerr << "--model, --recording and --transcript go together" << std::endl;
+        return false;
+    }
+
+    std::ifstream transcriptFile(options.transcriptPath);
+    if (!transcriptFile) {
+        std::cerr << "Failed to open transcript " << options.transcriptPath << std::endl;
+        return false;
+    }
+    std::stringstream transcript;
+    transcript << transcriptFile.rdbuf();
+
+    // The whole recording at 16 kHz, decoded in 100 ms blocks like the live path posts it
+    FileAudioSource source(options.recordingPath, FileAudioSource::Pacing::AsFastAsPossible);
+    if (!source.init()) {
+        return false;
+    }
+    MultirateFrontEnd frontEnd(source.sampleRate(), ResamplerQuality::Balanced, 4096);
+    std::vector<short> speech, block(4096);
+    source.start();
+    for (int read; (read = source.read(block.data(), static_cast<int>(block.size()))) > 0;) {
+        frontEnd.process(block.data(), read);
+        speech.insert(speech.end(), frontEnd.speech(), frontEnd.speech() + frontEnd.speechSize());
+    }
+    double audioSeconds = speech.size() / static_cast<double>(MultirateFrontEnd::SPEECH_RATE);
+
+    std::shared_ptr<VoskModel> model = SpeechRecognizer::loadModel(options.modelPath);
+    if (!model) {
+        return false;
+    }
+
+    for (SpeechRecognizer::Mode mode : {SpeechRecognizer::Mode::FullVocabulary, SpeechRecognizer::Mode::VowelGrammar}) {
+        const char* modeName = mode == SpeechRecognizer::Mode::VowelGrammar ? "vowel-grammar" : "full-vocabulary";
+        SpeechRecognizer recognizer(model, mode);
+        if (!recognizer.isValid()) {
+            return false;
+        }
+        std::vector<Vowel> reference = recognizer.extractVowels(transcript.str());
+
+        const size_t BLOCK = MultirateFrontEnd::SPEECH_RATE / 10;
+        std::vector<Vowel> heard;
+        std::string lastText;
+        auto start = std::chrono::steady_clock::now();
+        for (size_t offset = 0; offset < speech.size(); offset += BLOCK) {
+            int size = static_cast<int>(std::min(BLOCK, speech.size() - offset));
+            const std::string& text = recognizer.recognize(speech.data() + offset, size);
+            if (!text.empty() && text != lastText) {
+                std::vector<Vowel> vowels = recognizer.extractNewVowels(text, lastText);
+                heard.insert(heard.end(), vowels.begin(), vowels.end());
+                lastText = text;
+            }
+        }
+        double decodeSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        double accuracy = reference.empty() ? 0.0
+            : std::max(0.0, 1.0 - static_cast<double>(editDistance(reference, heard)) / reference.size());
+        char line[256];
+        std::snprintf(line, sizeof(line),
+                      "{\"bench\":\"recognizer\",\"param\":\"mode=%s\",\"rtf\":%.4f,\"vowel_accuracy\":%.4f,"
+                      "\"audio_seconds\":%.2f,\"reference_vowels\":%zu,\"heard_vowels\":%zu}",
+                      modeName, audioSeconds > 0.0 ? decodeSeconds / audioSeconds : 0.0, accuracy,
+                      audioSeconds, reference.size(), heard.size());
+        output.push_back(line);
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--filter" && i + 1 < argc) {
+            options.filter = argv[++i];
+        } else if (arg == "--min-time" && i + 1 < argc) {
+            options.minTimeMs = std::atof(argv[++i]);
+        } else if (arg == "--model" && i + 1 < argc) {
+            options.modelPath = argv[++i];
+        } else if (arg == "--recording" && i + 1 < argc) {
+            options.recordingPath = argv[++i];
+        } else if (arg == "--transcript" && i + 1 < argc) {
+            options.transcriptPath = argv[++i];
+        } else {
+            std::cerr << "Usage: dispenser_microbench [--filter <text>] [--min-time <ms>]\n"
+                         "                            [--model <dir> --recording <file> --transcript <file>]"
+                      << std::endl;
+            return 1;
+        }
+    }
+    if (options.minTimeMs <= 0.0) {
+        options.minTimeMs = 200.0;
+    }
+
+    // The detector, queue and recognizer log as they go; keep that out of the
+    // timings and the results
+    Logger::setLevel(LogLevel::Warn);
+    benchDetector();
+    benchRecognizerHelpers();
+    benchVowelQueue();
+    bool recognizerOk = benchRecognizerModes();
+
+    std::cout << "{\"bench\":\"context\",\"kernels\":\"" << simdKernels().name << "\",\"sample_rate\":" << SAMPLE_RATE
+              << ",\"rounds\":" << ROUNDS << ",\"min_time_ms\":" << options.minTimeMs << "}" << std::endl;
+    for (const std::string& line : output) {
+        std::cout << line << std::endl;
+    }
+    return recognizerOk ? 0 : 1;
+}
@@ -0,0 +1,185 @@
+#define _USE_MATH_DEFINES
+#include "synthetic_vowels.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+const double BANDWIDTHS[3] = {80.0, 100.0, 150.0}; // F1, F2, F3 resonator bandwidths in Hz
+const double OUTPUT_GAIN = 60000.0;                // Resonator output to int16 sample units
+const double RAMP_MS = 10.0;                       // Onset and release ramps around pauses
+
+short toSample(double value) {
+    return static_cast<short>(std::max(-32768.0, std::min(32767.0, value)));
+}
+
+} // namespace
+
+void FormantResonator::tune(double frequency, double bandwidth, int sampleRate) {
+    double r = std::exp(-M_PI * bandwidth / sampleRate);
+    a1 = 2.0 * r * std::cos(2.0 * M_PI * frequency / sampleRate);
+    a2 = -r * r;
+    gain = 1.0 - a1 - a2;
+}
+
+void synthesizeVowelFrame(const VowelFormants& target, int sampleRate, std::mt19937& rng,
+                          std::vector<short>& frame) {
+    std::uniform_real_distribution<double> jitter(-0.04, 0.04);
+    std::uniform_real_distribution<double> pitch(100.0, 220.0);
+    std::normal_distribution<double> noise(0.0, 30.0);
+
+    FormantResonator r1, r2, r3;
+    r1.tune(target.f1 * (1.0 + jitter(rng)), BANDWIDTHS[0], sampleRate);
+    r2.tune(target.f2 * (1.0 + jitter(rng)), BANDWIDTHS[1], sampleRate);
+    r3.tune(target.f3, BANDWIDTHS[2], sampleRate);
+    double period = sampleRate / pitch(rng);
+
+    // Let the resonators settle before the frame starts
+    const size_t warmup = 512;
+    double phase = 0.0;
+    for (size_t i = 0; i < warmup + frame.size(); i++) {
+        double pulse = 0.0;
+        phase += 1.0;
+        if (phase >= period) {
+            phase -= period;
+            pulse = 1.0;
+        }
+        double y = r3.process(r2.process(r1.process(pulse)));
+        if (i >= warmup) {
+            frame[i - warmup] = toSample(y * OUTPUT_GAIN + noise(rng));
+        }
+    }
+}
+
+VowelSynthesizer::VowelSynthesizer(const SynthesisSettings& settings, uint32_t seed)
+    : settings_(settings),
+      rng_(seed),
+      noise_(0.0, std::max(0.0, settings.noiseLevel)),
+      rampSamples_(std::max<size_t>(1, static_cast<size_t>(RAMP_MS * settings.sampleRate / 1000.0))) {
+}
+
+void VowelSynthesizer::tune(double f1, double f2, double f3) {
+    resonators_[0].tune(f1, BANDWIDTHS[0], settings_.sampleRate);
+    resonators_[1].tune(f2, BANDWIDTHS[1], settings_.sampleRate);
+    resonators_[2].tune(f3, BANDWIDTHS[2], settings_.sampleRate);
+}
+
+void VowelSynthesizer::startSegment() {
+    // Uniform draw that tolerates an empty or inverted range
+    auto between = [this](double low, double high) {
+        return high > low ? std::uniform_real_distribution<double>(low, high)(rng_) : low;
+    };
+    auto samples = [this](double ms) {
+        return static_cast<uint64_t>(std::max(1.0, ms * settings_.sampleRate / 1000.0));
+    };
+
+    uint64_t start = position_;
+    bool afterVowel = !segments_.empty() && segments_.back().vowel != Vowel::None;
+    if (afterVowel && pauseNext_) {
+        uint64_t length = samples(between(settings_.minPauseMs, settings_.maxPauseMs));
+        segments_.push_back({Vowel::None, start, start, start + length});
+        return;
+    }
+
+    // Any vowel but the one just played, so every segment boundary is a change
+    const size_t count = sizeof(SYNTHETIC_VOWELS) / sizeof(SYNTHETIC_VOWELS[0]);
+    Vowel previous = afterVowel ? segments_.back().vowel : Vowel::None;
+    size_t pick = std::uniform_int_distribution<size_t>(0, afterVowel ? count - 2 : count - 1)(rng_);
+    if (afterVowel && SYNTHETIC_VOWELS[pick].vowel == previous) {
+        pick = count - 1;
+    }
+    const VowelFormants& target = SYNTHETIC_VOWELS[pick];
+
+    double jitter = std::max(0.0, settings_.formantJitter);
+    double formants[3] = {target.f1 * (1.0 + between(-jitter, jitter)),
+                          target.f2 * (1.0 + between(-jitter, jitter)),
+                          target.f3};
+    for (int k = 0; k < 3; k++) {
+        from_[k] = afterVowel ? to_[k] : formants[k];
+        to_[k] = formants[k];
+    }
+
+    // After a vowel the formants glide; after a pause the voice fades in
+    uint64_t settle = afterVowel ? samples(settings_.transitionMs) : rampSamples_;
+    uint64_t length = std::max(samples(between(settings_.minVowelMs, settings_.maxVowelMs)),
+                               settle + 2 * rampSamples_);
+    onset_ = !afterVowel;
+    pauseNext_ = std::bernoulli_distribution(std::min(1.0, std::max(0.0, settings_.pauseProbability)))(rng_);
+
+    double pitch = between(settings_.minPitch, settings_.maxPitch);
+    startPeriod_ = settings_.sampleRate / std::max(pitch, 20.0);
+    endPeriod_ = startPeriod_ / std::max(0.1, 1.0 + between(-settings_.pitchDrift, settings_.pitchDrift));
+    if (onset_) {
+        phase_ = startPeriod_; // First pulse right at the onset
+        tune(to_[0], to_[1], to_[2]);
+        tuned_ = true;
+    } else {
+        tuned_ = false;
+    }
+
+    segments_.push_back({target.vowel, start, start + settle, start + length});
+}
+
+void VowelSynthesizer::generate(short* out, size_t count) {
+    for (size_t i = 0; i < count; i++, position_++) {
+        if (segments_.empty() || position_ >= segments_.back().end) {
+            startSegment();
+        }
+        const SynthesizedSegment& segment = segments_.back();
+
+        double excitation = 0.0;
+        if (segment.vowel != Vowel::None) {
+            uint64_t offset = position_ - segment.start;
+
+            // Glide linearly from the previous vowel's formants, retuning every sample
+            if (!tuned_) {
+                if (position_ < segment.steadyStart) {
+                    double k = static_cast<double>(offset) / (segment.steadyStart - segment.start);
+                    tune(from_[0] + k * (to_[0] - from_[0]), from_[1] + k * (to_[1] - from_[1]),
+                         from_[2] + k * (to_[2] - from_[2]));
+                } else {
+                    tune(to_[0], to_[1], to_[2]);
+                    tuned_ = true;
+                }
+            }
+
+            double progress = static_cast<double>(offset) / (segment.end - segment.start);
+            double period = startPeriod_ + (endPeriod_ - startPeriod_) * progress;
+            phase_ += 1.0;
+            if (phase_ >= period) {
+                phase_ -= period;
+                excitation = 1.0;
+            }
+
+            double envelope = 1.0;
+            if (onset_ && offset < rampSamples_) {
+                envelope = static_cast<double>(offset) / rampSamples_;
+            }
+            uint64_t remaining = segment.end - position_;
+            if (pauseNext_ && remaining < rampSamples_) {
+                envelope = std::min(envelope, static_cast<double>(remaining) / rampSamples_);
+            }
+            excitation *= envelope;
+        }
+
+        double y = resonators_[2].process(resonators_[1].process(resonators_[0].process(excitation)));
+        out[i] = toSample(y * OUTPUT_GAIN + noise_(rng_));
+    }
+}
+
+bool VowelSynthesizer::label(uint64_t first, uint64_t last, Vowel& vowel) const {
+    if (last <= first || last > position_) {
+        return false;
+    }
+    auto next = std::upper_bound(segments_.begin(), segments_.end(), first,
+                                 [](uint64_t sample, const SynthesizedSegment& s) { return sample < s.start; });
+    if (next == segments_.begin()) {
+        return false;
+    }
+    const SynthesizedSegment& segment = *(next - 1);
+    if (first < segment.steadyStart || last > segment.end) {
+        return false;
+    }
+    vowel = segment.vowel;
+    return true;
+}
@@ -0,0 +1,122 @@
+#ifndef SYNTHETIC_VOWELS_H
+#define SYNTHETIC_VOWELS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <vector>
+#include "../audio/vowel.h"
+
+// Formant frequencies, in Hz, a synthetic vowel is generated with.
+struct VowelFormants {
+    Vowel vowel;
+    double f1, f2, f3;
+};
+
+// Centers of the detector's formant ranges, F3 from typical adult speech.
+constexpr VowelFormants SYNTHETIC_VOWELS[] = {
+    {Vowel::A, 775, 1200, 2500},
+    {Vowel::Ya, 725, 1400, 2500},
+    {Vowel::E, 575, 1600, 2500},
+    {Vowel::Ye, 525, 1800, 2600},
+    {Vowel::I, 325, 2400, 3000},
+    {Vowel::Y, 425, 1400, 2400},
+    {Vowel::O, 550, 1025, 2400},
+    {Vowel::Yo, 525, 1150, 2400},
+    {Vowel::U, 375, 800, 2300},
+    {Vowel::Yu, 350, 1050, 2300},
+};
+
+// Synthesizes one frame of a vowel: a glottal pulse train at a random pitch
+// (100-220 Hz) through three formant resonators, with F1 and F2 jittered by
+// up to 4% and a little noise added.
+void synthesizeVowelFrame(const VowelFormants& target, int sampleRate, std::mt19937& rng,
+                          std::vector<short>& frame);
+
+// Two-pole resonator with a given center frequency and bandwidth, unity gain
+// at DC. Retuning keeps the filter state, so formants can glide.
+struct FormantResonator {
+    double a1 = 0.0, a2 = 0.0, gain = 0.0, y1 = 0.0, y2 = 0.0;
+
+    void tune(double frequency, double bandwidth, int sampleRate);
+
+    double process(double x) {
+        double y = gain * x + a1 * y1 + a2 * y2;
+        y2 = y1;
+        y1 = y;
+        return y;
+    }
+};
+
+// Settings of a VowelSynthesizer stream.
+struct SynthesisSettings {
+    int sampleRate = 8000;
+    double minPitch = 100.0;            // Range each vowel's starting pitch is drawn from, in Hz
+    double maxPitch = 220.0;
+    double pitchDrift = 0.1;            // Largest pitch change over one vowel, relative to its start
+    double formantJitter = 0.04;        // Largest random offset of a vowel's F1 and F2, relative
+    double noiseLevel = 30.0;           // Standard deviation of the added noise, in sample units
+    double minVowelMs = 200.0;          // Length of a vowel, its transition included
+    double maxVowelMs = 500.0;
+    double transitionMs = 40.0;         // Formant glide from the previous vowel
+    double pauseProbability = 0.2;      // Chance of a pause after a vowel
+    double minPauseMs = 100.0;
+    double maxPauseMs = 300.0;
+};
+
+// A labeled stretch of a synthesized stream, in samples from the stream start.
+struct SynthesizedSegment {
+    Vowel vowel;          // Vowel::None for a pause
+    uint64_t start;       // First sample
+    uint64_t steadyStart; // First sample past the transition or onset
+    uint64_t end;         // One past the last sample
+};
+
+// The VowelSynthesizer class generates an endless labeled stream of random
+// vowels and pauses: a glottal pulse train through F1/F2/F3 resonators at the
+// SYNTHETIC_VOWELS targets, with pitch drift, formant jitter, formant glides
+// between consecutive vowels, onset and release ramps around pauses, and
+// additive noise. The same settings and seed always give the same stream.
+class VowelSynthesizer {
+public:
+    VowelSynthesizer(const SynthesisSettings& settings, uint32_t seed);
+
+    // Appends count samples to the stream.
+    void generate(short* out, size_t count);
+
+    // Samples generated so far.
+    uint64_t position() const { return position_; }
+
+    // Segments generated so far, in order; the last one may still be running.
+    const std::vector<SynthesizedSegment>& segments() const { return segments_; }
+
+    // Label of the samples [first, last): true with the vowel (Vowel::None for
+    // a pause) if they lie in the steady part of a single segment, false if
+    // they span a transition or a segment boundary.
+    bool label(uint64_t first, uint64_t last, Vowel& vowel) const;
+
+private:
+    // Picks the next vowel or pause once the current segment has ended.
+    void startSegment();
+    // Moves the resonators to the given formants.
+    void tune(double f1, double f2, double f3);
+
+    SynthesisSettings settings_;
+    std::mt19937 rng_;
+    std::normal_distribution<double> noise_;
+    std::vector<SynthesizedSegment> segments_;
+    uint64_t position_ = 0;
+
+    double from_[3] = {0.0, 0.0, 0.0}; // Formants at the start of the current vowel
+    double to_[3] = {0.0, 0.0, 0.0};   // Formants of the current vowel once the glide is over
+    bool tuned_ = false;               // Whether the resonators already sit at to_
+    bool pauseNext_ = false;           // Whether a pause follows the current vowel
+    bool onset_ = false;               // Whether the current vowel starts from silence
+    double startPeriod_ = 0.0;         // Pitch period at the start and end of the current vowel, in samples
+    double endPeriod_ = 0.0;
+    double phase_ = 0.0;               // Samples since the last glottal pulse
+    size_t rampSamples_;               // Length of the onset and release ramps
+    FormantResonator resonators_[3];
+};
+
+#endif  // SYNTHETIC_VOWELS_H
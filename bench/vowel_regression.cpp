@@ -0,0 +1,252 @@
+// Regression harness for the vowel detector: streams labeled synthetic speech
+// from VowelSynthesizer through VowelDetector::process() as fast as possible
+// and reports a confusion matrix of the detector's decisions against the
+// synthesized vowels, plus the frame rate.
+//
+// A frame is scored when it lies entirely in the steady part of one vowel or
+// pause; frames spanning a formant transition or a boundary are skipped. The
+// defaults match the application's analysis: 8 kHz, 64 ms frames every 16 ms.
+//
+// Usage: vowel_regression [--seconds <n>] [--seed <n>] [--rate <hz>] [--block <n>] [--hop <n>]
+//                         [--pitch <min hz> <max hz>] [--drift <fraction>] [--jitter <fraction>]
+//                         [--noise <level>] [--transition <ms>] [--pause <probability>]
+//                         [--lpc] [--vowel-table <file>] [--json]
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "../audio/vowel_detector.h"
+#include "../audio/vowel_table.h"
+#include "../logging/logger.h"
+#include "synthetic_vowels.h"
+
+namespace {
+
+struct Options {
+    double seconds = 120.0;
+    uint32_t seed = 12345;
+    size_t blockSize = 1024;
+    size_t hopSize = 128;
+    FormantMethod method = FormantMethod::SpectralPeaks;
+    std::string vowelTablePath;
+    bool json = false;
+    SynthesisSettings synthesis;
+};
+
+const char* USAGE =
+    "Usage: vowel_regression [--seconds <n>] [--seed <n>] [--rate <hz>] [--block <n>] [--hop <n>]\n"
+    "                        [--pitch <min hz> <max hz>] [--drift <fraction>] [--jitter <fraction>]\n"
+    "                        [--noise <level>] [--transition <ms>] [--pause <probability>]\n"
+    "                        [--lpc] [--vowel-table <file>] [--json]";
+
+bool parseOptions(int argc, char* argv[], Options& options) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--seconds" && hasValue) {
+            options.seconds = std::atof(argv[++i]);
+        } else if (arg == "--seed" && hasValue) {
+            options.seed = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--rate" && hasValue) {
+            options.synthesis.sampleRate = std::atoi(argv[++i]);
+        } else if (arg == "--block" && hasValue) {
+            options.blockSize = static_cast<size_t>(std::atoi(argv[++i]));
+        } else if (arg == "--hop" && hasValue) {
+            options.hopSize = static_cast<size_t>(std::atoi(argv[++i]));
+        } else if (arg == "--pitch" && i + 2 < argc) {
+            options.synthesis.minPitch = std::atof(argv[++i]);
+            options.synthesis.maxPitch = std::atof(argv[++i]);
+        } else if (arg == "--drift" && hasValue) {
+            options.synthesis.pitchDrift = std::atof(argv[++i]);
+        } else if (arg == "--jitter" && hasValue) {
+            options.synthesis.formantJitter = std::atof(argv[++i]);
+        } else if (arg == "--noise" && hasValue) {
+            options.synthesis.noiseLevel = std::atof(argv[++i]);
+        } else if (arg == "--transition" && hasValue) {
+            options.synthesis.transitionMs = std::atof(argv[++i]);
+        } else if (arg == "--pause" && hasValue) {
+            options.synthesis.pauseProbability = std::atof(argv[++i]);
+        } else if (arg == "--lpc") {
+            options.method = FormantMethod::Lpc;
+        } else if (arg == "--vowel-table" && hasValue) {
+            options.vowelTablePath = argv[++i];
+        } else if (arg == "--json") {
+            options.json = true;
+        } else {
+            return false;
+        }
+    }
+    return options.seconds > 0.0 && options.synthesis.sampleRate >= 4000 && options.hopSize > 0
+        && options.blockSize >= 2 * options.hopSize && options.synthesis.minPitch > 0.0
+        && options.synthesis.maxPitch >= options.synthesis.minPitch;
+}
+
+// Counts of (synthesized, detected) vowel pairs, indexed by Vowel
+struct ConfusionMatrix {
+    uint64_t counts[VOWEL_COUNT][VOWEL_COUNT] = {};
+
+    uint64_t row(size_t truth) const {
+        uint64_t total = 0;
+        for (size_t d = 0; d < VOWEL_COUNT; d++) {
+            total += counts[truth][d];
+        }
+        return total;
+    }
+};
+
+struct Summary {
+    uint64_t vowelFrames = 0;   // Scored frames of a vowel
+    uint64_t vowelCorrect = 0;  // ... detected as that vowel
+    uint64_t groupCorrect = 0;  // ... detected as a vowel with the same mouth shape
+    uint64_t vowelMissed = 0;   // ... detected as no vowel
+    uint64_t pauseFrames = 0;   // Scored frames of a pause
+    uint64_t pauseFalse = 0;    // ... detected as a vowel
+};
+
+Summary summarize(const ConfusionMatrix& matrix, const VowelTable& table) {
+    Summary summary;
+    for (size_t t = 0; t < VOWEL_COUNT; t++) {
+        for (size_t d = 0; d < VOWEL_COUNT; d++) {
+            uint64_t n = matrix.counts[t][d];
+            if (t == 0) {
+                summary.pauseFrames += n;
+                summary.pauseFalse += d != 0 ? n : 0;
+                continue;
+            }
+            summary.vowelFrames += n;
+            summary.vowelCorrect += t == d ? n : 0;
+            summary.vowelMissed += d == 0 ? n : 0;
+            summary.groupCorrect +=
+                d != 0 && table.visemeGroup(static_cast<Vowel>(t)) == table.visemeGroup(static_cast<Vowel>(d)) ? n : 0;
+        }
+    }
+    return summary;
+}
+
+double percent(uint64_t part, uint64_t total) {
+    return total ? 100.0 * part / total : 0.0;
+}
+
+void printTable(const Options& options, const ConfusionMatrix& matrix, const Summary& summary,
+                uint64_t frames, double seconds, const char* engine) {
+    auto label = [](size_t v) { return v == 0 ? "-" : VOWEL_IDS[v]; };
+    double audioSeconds = options.seconds;
+
+    std::cout << "kernels: " << simdKernels().name << ", engine: " << engine << std::endl;
+    std::cout << "audio: " << audioSeconds << " s at " << options.synthesis.sampleRate << " Hz, frames of "
+              << options.blockSize / 2 << " every " << options.hopSize << " samples" << std::endl;
+    std::cout << "rows: synthesized, columns: detected, '-' is a pause / no vowel" << std::endl;
+
+    std::cout << "      ";
+    for (size_t d = 0; d < VOWEL_COUNT; d++) {
+        std::cout << std::setw(6) << label(d);
+    }
+    std::cout << "  correct" << std::endl;
+    std::cout << std::fixed << std::setprecision(1);
+    for (size_t t = 0; t < VOWEL_COUNT; t++) {
+        std::cout << std::setw(6) << label(t);
+        for (size_t d = 0; d < VOWEL_COUNT; d++) {
+            std::cout << std::setw(6) << matrix.counts[t][d];
+        }
+        std::cout << std::setw(8) << percent(matrix.counts[t][t], matrix.row(t)) << "%" << std::endl;
+    }
+
+    std::cout << "scored frames: " << summary.vowelFrames + summary.pauseFrames << " of " << frames << std::endl;
+    std::cout << "vowel accuracy: " << percent(summary.vowelCorrect, summary.vowelFrames)
+              << "%, mouth shape accuracy: " << percent(summary.groupCorrect, summary.vowelFrames)
+              << "%, missed: " << percent(summary.vowelMissed, summary.vowelFrames) << "%" << std::endl;
+    std::cout << "pause false vowels: " << percent(summary.pauseFalse, summary.pauseFrames) << "%" << std::endl;
+    std::cout << "throughput: " << std::setprecision(0) << frames / seconds << " frames/s ("
+              << audioSeconds / seconds << "x real time)" << std::endl;
+}
+
+void printJson(const Options& options, const ConfusionMatrix& matrix, const Summary& summary,
+               uint64_t frames, double seconds, const char* engine) {
+    std::cout << "{\"engine\":\"" << engine << "\",\"kernels\":\"" << simdKernels().name
+              << "\",\"sample_rate\":" << options.synthesis.sampleRate << ",\"audio_seconds\":" << options.seconds
+              << ",\"frames\":" << frames << ",\"frames_per_second\":" << frames / seconds
+              << ",\"vowel_accuracy\":" << summary.vowelCorrect / std::max(1.0, double(summary.vowelFrames))
+              << ",\"group_accuracy\":" << summary.groupCorrect / std::max(1.0, double(summary.vowelFrames))
+              << ",\"pause_false_rate\":" << summary.pauseFalse / std::max(1.0, double(summary.pauseFrames))
+              << ",\"labels\":[";
+    for (size_t v = 0; v < VOWEL_COUNT; v++) {
+        std::cout << (v ? "," : "") << "\"" << VOWEL_IDS[v] << "\"";
+    }
+    std::cout << "],\"confusion\":[";
+    for (size_t t = 0; t < VOWEL_COUNT; t++) {
+        std::cout << (t ? ",[" : "[");
+        for (size_t d = 0; d < VOWEL_COUNT; d++) {
+            std::cout << (d ? "," : "") << matrix.counts[t][d];
+        }
+        std::cout << "]";
+    }
+    std::cout << "]}" << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        std::cerr << USAGE << std::endl;
+        return 1;
+    }
+
+    VowelDetector detector(options.blockSize, options.hopSize, options.method, options.synthesis.sampleRate);
+    if (!options.vowelTablePath.empty()) {
+        VowelTable table;
+        if (!table.loadFromFile(options.vowelTablePath)) {
+            return 1;
+        }
+        detector.setVowelTable(table);
+    }
+
+    // Synthesize the whole stream up front so only the detector is timed
+    const int rate = options.synthesis.sampleRate;
+    VowelSynthesizer synthesizer(options.synthesis, options.seed);
+    std::vector<short> audio(static_cast<size_t>(options.seconds * rate));
+    synthesizer.generate(audio.data(), audio.size());
+
+    // Feed one hop at a time, so every call analyzes at most one frame whose
+    // last sample is the last one fed, and record its decision
+    const size_t hop = options.hopSize;
+    const size_t frameSize = options.blockSize / 2;
+    std::vector<Vowel> decisions;
+    std::vector<uint64_t> frameEnds;
+    decisions.reserve(audio.size() / hop + 1);
+    frameEnds.reserve(audio.size() / hop + 1);
+
+    // Keep the detector's per-frame logging out of the timing and the results
+    Logger::setLevel(LogLevel::Warn);
+    auto start = std::chrono::steady_clock::now();
+    for (size_t offset = 0; offset + hop <= audio.size(); offset += hop) {
+        uint64_t before = detector.framesAnalyzed();
+        Vowel vowel = detector.process(audio.data() + offset, hop, rate);
+        if (detector.framesAnalyzed() != before) {
+            decisions.push_back(vowel);
+            frameEnds.push_back(offset + hop);
+        }
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    ConfusionMatrix matrix;
+    for (size_t f = 0; f < decisions.size(); f++) {
+        Vowel truth;
+        if (synthesizer.label(frameEnds[f] - frameSize, frameEnds[f], truth)) {
+            matrix.counts[static_cast<size_t>(truth)][static_cast<size_t>(decisions[f])]++;
+        }
+    }
+
+    Summary summary = summarize(matrix, detector.vowelProfiles());
+    seconds = std::max(seconds, 1e-9);
+    if (options.json) {
+        printJson(options, matrix, summary, decisions.size(), seconds, detector.formantEngineName());
+    } else {
+        printTable(options, matrix, summary, decisions.size(), seconds, detector.formantEngineName());
+    }
+    return 0;
+}
@@ -0,0 +1,144 @@
+// Headless viseme output: runs the same capture and recognition pipeline as
+// the windowed application, but instead of drawing the mouth it writes every
+// mouth-shape change as an event for a downstream animation system.
+//
+// Usage: dispenser_headless [--format json|binary] [--output <file>]
+//                           [--fast] [--vowel-grammar] [--lpc] [--vowel-table <file>]
+//                           [--resampler-quality q] [--model <dir>] [--log-level <level>]
+//                           [--log-rate <lines/s>] [--queue-size <stage> <items>]
+//                           [--queue-policy <stage> <policy>] [recording.wav|.raw]
+// Events go to stdout unless --output is given (see VisemeEventWriter for the
+// formats). This thread is the pipeline's render stage; its queue blocks by
+// default so no event is lost, which slows the pipeline down when the reader
+// falls behind. Diagnostics go to stderr so stdout carries only events; SIGUSR1
+// (Ctrl+Break on Windows) prints the latency histograms there. Stops on
+// SIGINT/SIGTERM, when the event reader goes away, or once a recording has
+// ended and the pipeline has drained (see VisemePipeline::isDrained()).
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <string>
+#include "../logging/logger.h"
+#include "../pipeline/viseme_event_writer.h"
+#include "../pipeline/viseme_pipeline.h"
+
+#ifdef _WIN32
+    #include <fcntl.h>
+    #include <io.h>
+#endif
+
+namespace {
+
+std::atomic<bool> stopRequested(false);
+
+void onSignal(int) {
+    stopRequested.store(true);
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    // stdout belongs to the event stream; the log lines meant for stdout go to stderr
+    std::cout.rdbuf(std::cerr.rdbuf());
+
+    PipelineConfig config;
+    config.renderQueue.policy = DropPolicy::Block;
+    VisemeEventFormat format = VisemeEventFormat::Json;
+    std::string outputPath;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (parsePipelineOption(argc, argv, i, config) || parseLogOption(argc, argv, i)) {
+            continue;
+        } else if (arg == "--format" && i + 1 < argc) {
+            if (!parseVisemeEventFormat(argv[++i], format)) {
+                LOG_ERROR("Unknown event format '" << argv[i] << "', expected json or binary");
+                return 1;
+            }
+        } else if (arg == "--output" && i + 1 < argc) {
+            outputPath = argv[++i];
+        } else {
+            config.recordingPath = arg;
+        }
+    }
+
+    std::unique_ptr<VisemeEventWriter> writer;
+    if (outputPath.empty()) {
+#ifdef _WIN32
+        // Keep Windows from rewriting \n as \r\n in the binary stream
+        if (format == VisemeEventFormat::Binary) {
+            _setmode(_fileno(stdout), _O_BINARY);
+        }
+#endif
+        writer = std::make_unique<VisemeEventWriter>(stdout, format);
+    } else {
+        writer = std::make_unique<VisemeEventWriter>(outputPath, format);
+        if (!writer->isOpen()) {
+            return 1;
+        }
+    }
+
+    VisemePipeline pipeline(config);
+    if (!pipeline.init()) {
+        return 1;
+    }
+
+    std::signal(SIGINT, onSignal);
+    std::signal(SIGTERM, onSignal);
+    installLatencyDumpSignal();
+#ifndef _WIN32
+    // A closed pipe should fail the write, not kill the process
+    std::signal(SIGPIPE, SIG_IGN);
+#endif
+
+    pipeline.start();
+    LOG_INFO("Writing viseme events, press Ctrl+C to stop");
+
+    // After a recording ends the last Vosk results and the silence timeout
+    // still have to come through; this only guards against a stuck stage
+    constexpr std::chrono::seconds DRAIN_TIMEOUT(30);
+    bool draining = false;
+    std::chrono::steady_clock::time_point drainStart;
+
+    // How long to wait for a change before checking for a stop request again
+    constexpr std::chrono::milliseconds POLL_TIME(50);
+
+    VisemeChange change;
+    while (!stopRequested.load()) {
+        bool changed = pipeline.nextChange(change, std::chrono::steady_clock::now() + POLL_TIME);
+        if (changed && !writer->write(change)) {
+            LOG_WARN("Event output closed, stopping");
+            break;
+        }
+
+        if (changed || pipeline.isCapturing()) {
+            continue;
+        }
+        if (!draining) {
+            draining = true;
+            drainStart = std::chrono::steady_clock::now();
+        }
+        if (pipeline.isDrained()) {
+            // Every change is queued by now; write whatever arrived since the last wait
+            bool open = true;
+            while (open && pipeline.pollChange(change)) {
+                open = writer->write(change);
+            }
+            if (!open) {
+                LOG_WARN("Event output closed, stopping");
+            }
+            break;
+        }
+        if (std::chrono::steady_clock::now() - drainStart > DRAIN_TIMEOUT) {
+            LOG_WARN("The pipeline did not drain within " << DRAIN_TIMEOUT.count() << " s, stopping");
+            break;
+        }
+    }
+
+    pipeline.stop();
+    LOG_INFO("Viseme events written: " << writer->eventCount());
+    pipeline.printStatistics();
+    return 0;
+}
@@ -0,0 +1,364 @@
+#include "logger.h"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <streambuf>
+#include <string>
+#include <thread>
+
+std::atomic<LogLevel> Logger::threshold_(LogLevel::Info);
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+const char LEVEL_LETTERS[] = {'T', 'D', 'I', 'W', 'E'};
+const char* const LEVEL_NAMES[] = {"trace", "debug", "info", "warn", "error", "off"};
+constexpr std::chrono::milliseconds WRITE_INTERVAL(5); // How long queued lines may wait for the writer
+constexpr double BURST_SECONDS = 2.0;                  // Rate limit bucket size, in seconds of lines
+constexpr double DEFAULT_RATE = 200.0;                 // Lines per second below Warn
+
+struct LogRecord {
+    int64_t time;   // Steady clock nanoseconds when the line was queued
+    LogLevel level;
+    uint16_t length;
+    char text[Logger::MAX_LINE];
+};
+
+// Bounded lock-free queue for many producers and the single writer thread
+// (D. Vyukov's sequence-numbered ring). A slot's sequence tells whose turn it
+// is: equal to the position when free for a producer, position + 1 once
+// filled for the consumer.
+class LogQueue {
+public:
+    LogQueue() {
+        for (size_t i = 0; i < Logger::QUEUE_SIZE; i++) {
+            slots_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    bool push(LogLevel level, int64_t time, const char* text, size_t length) {
+        size_t position = tail_.load(std::memory_order_relaxed);
+        for (;;) {
+            Slot& slot = slots_[position & MASK];
+            size_t sequence = slot.sequence.load(std::memory_order_acquire);
+            intptr_t lag = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+            if (lag == 0) {
+                if (tail_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    slot.record.time = time;
+                    slot.record.level = level;
+                    slot.record.length = static_cast<uint16_t>(length);
+                    std::memcpy(slot.record.text, text, length);
+                    slot.sequence.store(position + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (lag < 0) {
+                return false; // Full: the writer has not reached this slot's previous line yet
+            } else {
+                position = tail_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Consumer side only
+    bool pop(LogRecord& record) {
+        size_t position = head_.load(std::memory_order_relaxed);
+        Slot& slot = slots_[position & MASK];
+        if (slot.sequence.load(std::memory_order_acquire) != position + 1) {
+            return false;
+        }
+        record = slot.record;
+        slot.sequence.store(position + Logger::QUEUE_SIZE, std::memory_order_release);
+        head_.store(position + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Positions of the next line to queue and the next line to write
+    size_t queued() const { return tail_.load(std::memory_order_acquire); }
+    size_t taken() const { return head_.load(std::memory_order_acquire); }
+
+private:
+    static constexpr size_t MASK = Logger::QUEUE_SIZE - 1;
+    static_assert((Logger::QUEUE_SIZE & MASK) == 0, "QUEUE_SIZE must be a power of two");
+
+    struct Slot {
+        std::atomic<size_t> sequence;
+        LogRecord record;
+    };
+
+    Slot slots_[Logger::QUEUE_SIZE];
+    alignas(64) std::atomic<size_t> tail_{0}; // Next position for a producer
+    alignas(64) std::atomic<size_t> head_{0}; // Next position for the writer
+};
+
+// The background writer. Created on first use and never destroyed, so lines
+// logged from static destructors still find it; at exit it drains the queue
+// and later lines are written directly.
+class LogWriter {
+public:
+    static LogWriter& instance() {
+        static LogWriter* writer = new LogWriter();
+        return *writer;
+    }
+
+    bool submit(LogLevel level, const char* text, size_t length) {
+        int64_t time = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count();
+        if (stopped_.load(std::memory_order_acquire)) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            LogRecord record{time, level, static_cast<uint16_t>(length), {}};
+            std::memcpy(record.text, text, length);
+            write(record);
+            flushStreams();
+            return true;
+        }
+        if (queue_.push(level, time, text, length)) {
+            return true;
+        }
+        if (level >= LogLevel::Warn) {
+            // Warnings and errors are rare enough to wait for: make room by
+            // writing out the queue here, then write this line after it
+            std::lock_guard<std::mutex> lock(mutex_);
+            drain();
+            LogRecord record{time, level, static_cast<uint16_t>(length), {}};
+            std::memcpy(record.text, text, length);
+            write(record);
+            flushStreams();
+            return true;
+        }
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    void flush() {
+        size_t target = queue_.queued();
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (stopped_.load(std::memory_order_acquire)) {
+            return;
+        }
+        flushRequested_ = true;
+        wake_.notify_one();
+        drained_.wait(lock, [&] { return queue_.taken() >= target || stopped_.load(std::memory_order_acquire); });
+    }
+
+    void setRateLimit(double linesPerSecond) {
+        rate_.store(linesPerSecond > 0.0 ? linesPerSecond : 0.0, std::memory_order_relaxed);
+    }
+
+private:
+    LogWriter() : start_(Clock::now()) {
+        thread_ = std::thread(&LogWriter::run, this);
+        std::atexit([] { instance().shutdown(); });
+    }
+
+    void shutdown() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        wake_.notify_one();
+        if (thread_.joinable()) {
+            thread_.join();
+        }
+    }
+
+    void run() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        for (;;) {
+            wake_.wait_for(lock, WRITE_INTERVAL, [this] { return stopping_ || flushRequested_; });
+            bool stopping = stopping_;
+            flushRequested_ = false;
+            drain();
+            if (stopping) {
+                // Producers still racing the shutdown flag may have queued one more line
+                stopped_.store(true, std::memory_order_release);
+                drain();
+                reportSuppressed(true);
+                flushStreams();
+                drained_.notify_all();
+                return;
+            }
+            drained_.notify_all();
+        }
+    }
+
+    // Writes out everything queued; called with the mutex held
+    void drain() {
+        LogRecord record;
+        bool wrote = false;
+        while (queue_.pop(record)) {
+            wrote |= write(record);
+        }
+        reportSuppressed(false);
+        if (wrote) {
+            flushStreams();
+        }
+    }
+
+    // Returns false if the rate limit swallowed the line
+    bool write(const LogRecord& record) {
+        double rate = rate_.load(std::memory_order_relaxed);
+        if (record.level < LogLevel::Warn && rate > 0.0) {
+            // Token bucket refilled by the time between lines
+            double elapsed = (record.time - lastRefill_) * 1e-9;
+            lastRefill_ = record.time;
+            tokens_ = std::min(tokens_ + elapsed * rate, rate * BURST_SECONDS);
+            if (tokens_ < 1.0) {
+                suppressed_++;
+                return false;
+            }
+            tokens_ -= 1.0;
+        }
+
+        double seconds = (record.time - startTime()) * 1e-9;
+        char prefix[32];
+        int prefixLength = std::snprintf(prefix, sizeof(prefix), "[%9.3f] %c ", seconds,
+                                         LEVEL_LETTERS[static_cast<size_t>(record.level)]);
+        std::ostream& out = record.level >= LogLevel::Warn ? std::cerr : std::cout;
+        out.write(prefix, prefixLength);
+        out.write(record.text, record.length);
+        out.put('\n');
+        return true;
+    }
+
+    // Tells how many lines were lost, at most once a second unless final
+    void reportSuppressed(bool final) {
+        uint64_t dropped = dropped_.exchange(0, std::memory_order_relaxed);
+        droppedPending_ += dropped;
+        if (suppressed_ == 0 && droppedPending_ == 0) {
+            return;
+        }
+        Clock::time_point now = Clock::now();
+        if (!final && now - lastReport_ < std::chrono::seconds(1)) {
+            return;
+        }
+        lastReport_ = now;
+        std::fprintf(stderr, "[%9.3f] W log lines lost: %llu over the rate limit, %llu to a full queue\n",
+                     std::chrono::duration<double>(now - start_).count(),
+                     static_cast<unsigned long long>(suppressed_), static_cast<unsigned long long>(droppedPending_));
+        suppressed_ = 0;
+        droppedPending_ = 0;
+    }
+
+    void flushStreams() {
+        std::cout.flush();
+        std::cerr.flush();
+    }
+
+    int64_t startTime() const {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(start_.time_since_epoch()).count();
+    }
+
+    LogQueue queue_;
+    std::atomic<uint64_t> dropped_{0};       // Lines that found the queue full, not yet reported
+    std::atomic<double> rate_{DEFAULT_RATE}; // Rate limit in lines per second, 0 for none
+    std::atomic<bool> stopped_{false};       // Set once the writer thread has finished
+
+    // Writer state, guarded by mutex_
+    std::mutex mutex_;
+    std::condition_variable wake_;    // Wakes the writer for a flush or the shutdown
+    std::condition_variable drained_; // Wakes flush() after a drain
+    bool stopping_ = false;
+    bool flushRequested_ = false;
+    Clock::time_point start_;
+    Clock::time_point lastReport_;
+    int64_t lastRefill_ = 0;
+    double tokens_ = DEFAULT_RATE * BURST_SECONDS;
+    uint64_t suppressed_ = 0;      // Lines over the rate limit, not yet reported
+    uint64_t droppedPending_ = 0;  // Full-queue drops taken from dropped_, not yet reported
+    std::thread thread_;
+};
+
+// ostream target over a fixed buffer; once it is full the rest of the message is cut off
+class LineBuffer : public std::streambuf {
+public:
+    LineBuffer() { reset(); }
+
+    void reset() { setp(data_, data_ + sizeof(data_)); }
+    const char* data() const { return pbase(); }
+    size_t size() const { return static_cast<size_t>(pptr() - pbase()); }
+
+protected:
+    int_type overflow(int_type) override { return traits_type::eof(); }
+
+private:
+    char data_[Logger::MAX_LINE];
+};
+
+struct LineStream {
+    LineBuffer buffer;
+    std::ostream stream{&buffer};
+};
+
+LineStream& lineStream() {
+    thread_local LineStream line;
+    return line;
+}
+
+} // namespace
+
+void Logger::setLevel(LogLevel level) {
+    threshold_.store(level, std::memory_order_relaxed);
+}
+
+void Logger::setRateLimit(double linesPerSecond) {
+    LogWriter::instance().setRateLimit(linesPerSecond);
+}
+
+bool Logger::submit(LogLevel level, const char* text, size_t length) {
+    if (length > MAX_LINE) {
+        length = MAX_LINE;
+    }
+    return LogWriter::instance().submit(level, text, length);
+}
+
+void Logger::flush() {
+    LogWriter::instance().flush();
+}
+
+LogMessage::LogMessage(LogLevel level) : level_(level), stream_(lineStream().stream) {
+    // The stream is reused by every message of this thread; undo what the last one changed
+    lineStream().buffer.reset();
+    stream_.clear();
+    stream_.flags(std::ios::dec | std::ios::skipws);
+    stream_.precision(6);
+    stream_.width(0);
+    stream_.fill(' ');
+}
+
+LogMessage::~LogMessage() {
+    LineBuffer& buffer = lineStream().buffer;
+    Logger::submit(level_, buffer.data(), buffer.size());
+}
+
+bool parseLogLevel(const char* name, LogLevel& level) {
+    for (size_t i = 0; i < sizeof(LEVEL_NAMES) / sizeof(LEVEL_NAMES[0]); i++) {
+        if (std::strcmp(name, LEVEL_NAMES[i]) == 0) {
+            level = static_cast<LogLevel>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool parseLogOption(int argc, char* argv[], int& i) {
+    std::string arg = argv[i];
+    if (arg == "--log-level" && i + 1 < argc) {
+        LogLevel level;
+        if (parseLogLevel(argv[++i], level)) {
+            Logger::setLevel(level);
+        } else {
+            LOG_WARN("Unknown log level '" << argv[i] << "', expected trace, debug, info, warn, error or off");
+        }
+        return true;
+    }
+    if (arg == "--log-rate" && i + 1 < argc) {
+        Logger::setRateLimit(std::atof(argv[++i]));
+        return true;
+    }
+    return false;
+}
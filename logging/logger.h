@@ -0,0 +1,143 @@
+#ifndef LOGGER_H
+#define LOGGER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+
+// Severity of a log message, lowest first.
+enum class LogLevel : uint8_t {
+    Trace = 0, // Per-frame detail (formants of every frame)
+    Debug,     // Per-result detail (Vosk partials, vowel changes)
+    Info,      // Startup, shutdown and statistics
+    Warn,      // Something failed but the program carries on
+    Error,     // Something failed and the operation was abandoned
+    Off
+};
+
+// Lowest level that is compiled in, as a number (0 = Trace ... 5 = Off).
+// Calls below it compile to nothing and their arguments are never evaluated.
+// Release builds keep Debug and up; define DISPENSER_LOG_MIN_LEVEL to change that.
+#ifndef DISPENSER_LOG_MIN_LEVEL
+#ifdef NDEBUG
+#define DISPENSER_LOG_MIN_LEVEL 1
+#else
+#define DISPENSER_LOG_MIN_LEVEL 0
+#endif
+#endif
+
+// The Logger class takes log lines off the calling thread. A message is
+// formatted into a thread-local buffer and copied into a fixed-size lock-free
+// queue; a background thread writes the lines out, Warn and Error to stderr
+// and the rest to stdout, prefixed with the time since start and the level.
+// Logging below Warn never blocks and never allocates after a thread's first
+// message.
+//
+// Lines below Warn are rate limited; lines over the limit, and lines that
+// find the queue full, are dropped and reported as a count. A Warn or Error
+// line that finds the queue full is written by the caller instead. Everything
+// queued is written at exit or on flush().
+class Logger {
+public:
+    static constexpr size_t MAX_LINE = 240;    // Longer messages are truncated
+    static constexpr size_t QUEUE_SIZE = 1024; // Lines waiting for the writer, a power of two
+
+    // Checks whether messages of the level are currently written.
+    static bool enabled(LogLevel level) {
+        return level >= threshold_.load(std::memory_order_relaxed);
+    }
+
+    // Sets the lowest level written at runtime (Info by default).
+    static void setLevel(LogLevel level);
+    static LogLevel level() { return threshold_.load(std::memory_order_relaxed); }
+
+    // Sets how many lines below Warn are written per second, with bursts of
+    // up to two seconds' worth; 0 turns the limit off. 200 by default.
+    static void setRateLimit(double linesPerSecond);
+
+    // Queues one line. Returns false if it was dropped because the queue is full.
+    static bool submit(LogLevel level, const char* text, size_t length);
+
+    // Waits until every line queued so far has been written.
+    static void flush();
+
+private:
+    static std::atomic<LogLevel> threshold_;
+};
+
+// Formats one message with stream syntax and queues it when destroyed. Used
+// through the LOG_* macros; not reentrant, so do not log from inside a
+// message's own operator<<.
+class LogMessage {
+public:
+    explicit LogMessage(LogLevel level);
+    ~LogMessage();
+
+    LogMessage(const LogMessage&) = delete;
+    LogMessage& operator=(const LogMessage&) = delete;
+
+    std::ostream& stream() { return stream_; }
+
+private:
+    LogLevel level_;
+    std::ostream& stream_;
+};
+
+// Parses a level name: trace, debug, info, warn, error or off.
+// Returns false if the name is unknown.
+bool parseLogLevel(const char* name, LogLevel& level);
+
+// Consumes the logging options at argv[i]: --log-level <level> and
+// --log-rate <lines per second>. Advances i past the option's value and returns
+// true if it was one of them.
+bool parseLogOption(int argc, char* argv[], int& i);
+
+#define DISPENSER_LOG(level, message)                    \
+    do {                                                 \
+        if (Logger::enabled(level)) {                    \
+            LogMessage dispenserLogMessage(level);       \
+            dispenserLogMessage.stream() << message;     \
+        }                                                \
+    } while (0)
+
+// Type-checks the message but never evaluates it, so the optimizer drops it
+#define DISPENSER_LOG_ELIDED(message)                    \
+    do {                                                 \
+        if (false) {                                     \
+            LogMessage dispenserLogMessage(LogLevel::Off);\
+            dispenserLogMessage.stream() << message;     \
+        }                                                \
+    } while (0)
+
+#if DISPENSER_LOG_MIN_LEVEL <= 0
+#define LOG_TRACE(message) DISPENSER_LOG(LogLevel::Trace, message)
+#else
+#define LOG_TRACE(message) DISPENSER_LOG_ELIDED(message)
+#endif
+
+#if DISPENSER_LOG_MIN_LEVEL <= 1
+#define LOG_DEBUG(message) DISPENSER_LOG(LogLevel::Debug, message)
+#else
+#define LOG_DEBUG(message) DISPENSER_LOG_ELIDED(message)
+#endif
+
+#if DISPENSER_LOG_MIN_LEVEL <= 2
+#define LOG_INFO(message) DISPENSER_LOG(LogLevel::Info, message)
+#else
+#define LOG_INFO(message) DISPENSER_LOG_ELIDED(message)
+#endif
+
+#if DISPENSER_LOG_MIN_LEVEL <= 3
+#define LOG_WARN(message) DISPENSER_LOG(LogLevel::Warn, message)
+#else
+#define LOG_WARN(message) DISPENSER_LOG_ELIDED(message)
+#endif
+
+#if DISPENSER_LOG_MIN_LEVEL <= 4
+#define LOG_ERROR(message) DISPENSER_LOG(LogLevel::Error, message)
+#else
+#define LOG_ERROR(message) DISPENSER_LOG_ELIDED(message)
+#endif
+
+#endif  // LOGGER_H
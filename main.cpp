@@ -5,21 +5,36 @@
 #endif
 
 #define SDL_MAIN_HANDLED
-#include <vector>
-#include <queue>
 #include <chrono>
-#include <iostream>
+#include <cstdint>
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_image.h>
-#include <thread>
-#include <chrono>
-#include <algorithm>
-#include "audio/mic_input.h"
-#include "audio/vowel_detector.h"
-#include "recognizer/vosk_recognizer.h"
-#include "audio/vowel_queue.h" // Add this include for vowel queue functionality
+#include <memory>
+#include <string>
+#include "logging/logger.h"
+#include "pipeline/viseme_pipeline.h"
+#include "render/viseme_atlas.h"
+
+namespace {
+
+// Shuts SDL and SDL_image down on every return path of main(), once they
+// have been initialized.
+struct SdlLibraries {
+    bool sdl = false;
+    bool image = false;
+
+    ~SdlLibraries() {
+        if (image) IMG_Quit();
+        if (sdl) SDL_Quit();
+    }
+};
+
+using WindowPtr = std::unique_ptr<SDL_Window, decltype(&SDL_DestroyWindow)>;
+using RendererPtr = std::unique_ptr<SDL_Renderer, decltype(&SDL_DestroyRenderer)>;
 
-int main() {
+} // namespace
+
+int main(int argc, char* argv[]) {
     SDL_SetMainReady();
 
     #ifdef _WIN32
@@ -27,264 +42,185 @@ int main() {
         SetConsoleCP(65001);       // Set console input encoding to UTF-8
     #endif
 
+    // Command line: TalkingDispenser [recording.wav|recording.raw] [--fast] [--vowel-grammar] [--lpc]
+    //                                [--vowel-table <file>] [--resampler-quality fast|balanced|high]
+    //                                [--model <dir>] [--images <dir>] [--viseme-image <group> <file>]
+    //                                [--log-level trace|debug|info|warn|error|off] [--log-rate <lines/s>]
+    //                                [--queue-size <stage> <items>] [--queue-policy <stage> <policy>]
+    // --fast plays the recording as fast as possible instead of in real time.
+    // --vowel-grammar restricts Vosk to vowel syllables and short words.
+    // --lpc finds formants with linear prediction instead of FFT peak picking.
+    // --vowel-table loads vowel formant profiles (see tables/vowels_ru.txt).
+    // --resampler-quality trades resampling filter quality for CPU time.
+    // --model points at the Vosk model directory.
+    // --images loads the mouth images 1.png..7.png from a directory;
+    // --viseme-image replaces the image of one shape (silence, open, mid, ...).
+    // --queue-size and --queue-policy size the queue in front of a pipeline stage (analysis,
+    // recognition, fusion, render) and choose what happens when it is full: block, drop-oldest, drop-newest.
+    // --log-level shows more (debug: every detection) or less; --log-rate caps lines per second below warn.
+    PipelineConfig pipelineConfig;
+    VisemeImagePaths imagePaths = visemeImagesInDirectory("C:/Users/Acer/Desktop/im");
+    for (int i = 1; i < argc; i++) {
+        if (!parsePipelineOption(argc, argv, i, pipelineConfig)
+            && !parseVisemeImageOption(argc, argv, i, imagePaths)
+            && !parseLogOption(argc, argv, i)) {
+            pipelineConfig.recordingPath = argv[i];
+        }
+    }
+
+    SdlLibraries libraries;
+
     // Initialize SDL library
     if (SDL_Init(SDL_INIT_VIDEO) < 0) {
-        std::cerr << "SDL could not initialize! SDL_Error: " << SDL_GetError() << std::endl;
+        LOG_ERROR("SDL could not initialize! SDL_Error: " << SDL_GetError());
         return 1;
     }
+    libraries.sdl = true;
 
     // Initialize SDL_image library with support for PNG and JPG formats
     int imgFlags = IMG_INIT_PNG | IMG_INIT_JPG;
     if (!(IMG_Init(imgFlags) & imgFlags)) {
-        std::cerr << "SDL_image could not initialize! SDL_image Error: " << IMG_GetError() << std::endl;
-        SDL_Quit();
+        LOG_ERROR("SDL_image could not initialize! SDL_image Error: " << IMG_GetError());
         return 1;
     }
+    libraries.image = true;
 
     // Create the main application window
-    SDL_Window* window = SDL_CreateWindow("Talking Dispenser", 
-                                        SDL_WINDOWPOS_CENTERED, 
-                                        SDL_WINDOWPOS_CENTERED, 
-                                        640, 480, 
-                                        SDL_WINDOW_SHOWN);
+    WindowPtr window(SDL_CreateWindow("Talking Dispenser",
+                                      SDL_WINDOWPOS_CENTERED,
+                                      SDL_WINDOWPOS_CENTERED,
+                                      640, 480,
+                                      SDL_WINDOW_SHOWN),
+                     SDL_DestroyWindow);
     if (!window) {
-        std::cerr << "Failed to create window: " << SDL_GetError() << std::endl;
-        IMG_Quit();
-        SDL_Quit();
+        LOG_ERROR("Failed to create window: " << SDL_GetError());
         return 1;
     }
 
-    // Create a renderer for the window
-    SDL_Renderer* renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED);
+    // Create a renderer for the window; presenting waits for vsync, so a redraw never tears
+    RendererPtr renderer(SDL_CreateRenderer(window.get(), -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC),
+                         SDL_DestroyRenderer);
     if (!renderer) {
-        std::cerr << "Failed to create renderer: " << SDL_GetError() << std::endl;
-        SDL_DestroyWindow(window);
-        IMG_Quit();
-        SDL_Quit();
+        LOG_ERROR("Failed to create renderer: " << SDL_GetError());
         return 1;
     }
 
-    // Load textures for vowel visualization
-    SDL_Texture* texture1 = IMG_LoadTexture(renderer, "C:/Users/Acer/Desktop/im/1.png"); // 'a', 'ya'
-    SDL_Texture* texture2 = IMG_LoadTexture(renderer, "C:/Users/Acer/Desktop/im/2.png"); // 'e', 'ye'
-    SDL_Texture* texture3 = IMG_LoadTexture(renderer, "C:/Users/Acer/Desktop/im/3.png"); // 'i'
-    SDL_Texture* texture4 = IMG_LoadTexture(renderer, "C:/Users/Acer/Desktop/im/4.png"); // 'y'
-    SDL_Texture* texture5 = IMG_LoadTexture(renderer, "C:/Users/Acer/Desktop/im/5.png"); // 'o', 'yo'
-    SDL_Texture* texture6 = IMG_LoadTexture(renderer, "C:/Users/Acer/Desktop/im/6.png"); // 'u', 'yu'
-    SDL_Texture* texture7 = IMG_LoadTexture(renderer, "C:/Users/Acer/Desktop/im/7.png"); // silence
-
-    // Check if all textures were loaded successfully
-    if (!texture1 || !texture2 || !texture3 || !texture4 || !texture5 || !texture6 || !texture7) {
-        std::cerr << "Failed to load textures: " << IMG_GetError() << std::endl;
-        
-        // Check each texture individually for debugging purposes
-        if (!texture1) std::cerr << "Failed to load 1.jpg" << std::endl;
-        if (!texture2) std::cerr << "Failed to load 2.jpg" << std::endl;
-        if (!texture3) std::cerr << "Failed to load 3.jpg" << std::endl;
-        if (!texture4) std::cerr << "Failed to load 4.jpg" << std::endl;
-        if (!texture5) std::cerr << "Failed to load 5.jpg" << std::endl;
-        if (!texture6) std::cerr << "Failed to load 6.jpg" << std::endl;
-        if (!texture7) std::cerr << "Failed to load 7.jpg" << std::endl;
-
-        // Clean up loaded textures to avoid memory leaks
-        if (texture1) SDL_DestroyTexture(texture1);
-        if (texture2) SDL_DestroyTexture(texture2);
-        if (texture3) SDL_DestroyTexture(texture3);
-        if (texture4) SDL_DestroyTexture(texture4);
-        if (texture5) SDL_DestroyTexture(texture5);
-        if (texture6) SDL_DestroyTexture(texture6);
-        if (texture7) SDL_DestroyTexture(texture7);
-        SDL_DestroyRenderer(renderer);
-        SDL_DestroyWindow(window);
-        IMG_Quit();
-        SDL_Quit();
-        return 1;
-    } else {
-        // Debugging: Check the dimensions of each texture
-        int w, h;
-        SDL_QueryTexture(texture1, nullptr, nullptr, &w, &h);
-        std::cout << "Texture '1' loaded: " << w << "x" << h << std::endl;
-        SDL_QueryTexture(texture2, nullptr, nullptr, &w, &h);
-        std::cout << "Texture '2' loaded: " << w << "x" << h << std::endl;
-        SDL_QueryTexture(texture3, nullptr, nullptr, &w, &h);
-        std::cout << "Texture '3' loaded: " << w << "x" << h << std::endl;
-        SDL_QueryTexture(texture4, nullptr, nullptr, &w, &h);
-        std::cout << "Texture '4' loaded: " << w << "x" << h << std::endl;
-        SDL_QueryTexture(texture5, nullptr, nullptr, &w, &h);
-        std::cout << "Texture '5' loaded: " << w << "x" << h << std::endl;
-        SDL_QueryTexture(texture6, nullptr, nullptr, &w, &h);
-        std::cout << "Texture '6' loaded: " << w << "x" << h << std::endl;
-        SDL_QueryTexture(texture7, nullptr, nullptr, &w, &h);
-        std::cout << "Texture '7' loaded: " << w << "x" << h << std::endl;
-    }
+    // Decode the mouth images in the background while the Vosk model loads
+    VisemeAtlas atlas;
+    atlas.startLoading(imagePaths);
 
-    // Initialize audio input for microphone recording
-    MicInput micInput;
-
-    // Replace old SpeechRecognizer code with VowelDetector
-    VowelDetector vowelDetector;
-
-    // Check if microphone input was initialized successfully
-    if (!micInput.init()) {
-        std::cerr << "Failed to initialize audio input" << std::endl;
-        SDL_DestroyTexture(texture1);
-        SDL_DestroyTexture(texture2);
-        SDL_DestroyTexture(texture3);
-        SDL_DestroyTexture(texture4);
-        SDL_DestroyTexture(texture5);
-        SDL_DestroyTexture(texture6);
-        SDL_DestroyTexture(texture7);
-        SDL_DestroyRenderer(renderer);
-        SDL_DestroyWindow(window);
-        IMG_Quit();
-        SDL_Quit();
+    // Capture, detection and recognition; the window only shows the result
+    VisemePipeline pipeline(pipelineConfig);
+
+    // Check if audio input and the speech recognizer were initialized successfully
+    if (!pipeline.init()) {
         return 1;
     }
 
-    // Initialize speech recognizer with the Vosk model
-    SpeechRecognizer recognizer("C:/Users/Acer/Desktop/main/model/vosk-model-small-ru-0.22");
-    VowelQueue vowelQueue;
-    
-    // Check if the speech recognizer was initialized successfully
-    if (!recognizer.isValid()) {
-        std::cerr << "Failed to initialize speech recognizer" << std::endl;
-        SDL_DestroyTexture(texture1);
-        SDL_DestroyTexture(texture2);
-        SDL_DestroyTexture(texture3);
-        SDL_DestroyTexture(texture4);
-        SDL_DestroyTexture(texture5);
-        SDL_DestroyTexture(texture6);
-        SDL_DestroyTexture(texture7);
-        SDL_DestroyRenderer(renderer);
-        SDL_DestroyWindow(window);
-        IMG_Quit();
-        SDL_Quit();
+    // All mouth shapes live in one texture; a shape is a rectangle of it
+    if (!atlas.finishLoading(renderer.get())) {
         return 1;
     }
 
-    // Start audio recording from the microphone
-    micInput.start();
+    // This thread is the pipeline's render stage. The fusion stage wakes it
+    // with an SDL event (SDL_PushEvent is thread-safe) whenever it queues a
+    // change; the changes themselves, timestamps included, come from the pipeline's render queue
+    const Uint32 visemeEvent = SDL_RegisterEvents(1);
+    pipeline.setChangeNotifier([visemeEvent] {
+        SDL_Event event;
+        SDL_zero(event);
+        event.type = visemeEvent;
+        SDL_PushEvent(&event);
+    });
+
+    // SIGUSR1 (Ctrl+Break on Windows) prints the latency histograms; they are also printed on exit
+    installLatencyDumpSignal();
 
-    // Main application loop
+    // Start audio recording and the pipeline's stages
+    pipeline.start();
+
+    // Main application loop: sleeps in SDL_WaitEvent and presents a frame
+    // only when the mouth shape changes or the window needs repainting
     bool running = true;
-    SDL_Texture* currentTexture = texture7; // Set the default texture to 'silence'
-    auto lastRecognitionTime = std::chrono::steady_clock::now();
-    const auto DISPLAY_DURATION = std::chrono::milliseconds(2000); // Display each texture for 2 seconds
-    
-    std::cout << "Talking Dispenser started! Pronounce vowels 'a', 'o', 'i'..." << std::endl;
+    bool redraw = true;  // Draw the first frame
+    uint64_t framesPresented = 0;
+    VisemeGroup currentGroup = VisemeGroup::Silence;
+    bool changeShown = false;  // Whether the next frame shows lastChange
+    VisemeChange lastChange{};
+
+    auto handleEvent = [&](const SDL_Event& event) {
+        if (event.type == SDL_QUIT) {
+            running = false;
+        } else if (event.type == SDL_KEYDOWN && event.key.keysym.sym == SDLK_ESCAPE) {
+            running = false;
+        } else if (event.type == visemeEvent) {
+            // One event may stand for several queued changes, or for ones an earlier event already took
+            VisemeChange change;
+            while (pipeline.pollChange(change)) {
+                if (change.group != currentGroup) {
+                    redraw = true;
+                    changeShown = true;
+                    lastChange = change;
+                }
+                currentGroup = change.group;
+            }
+        } else if (event.type == SDL_WINDOWEVENT
+                   && (event.window.event == SDL_WINDOWEVENT_EXPOSED
+                       || event.window.event == SDL_WINDOWEVENT_SIZE_CHANGED
+                       || event.window.event == SDL_WINDOWEVENT_RESTORED)) {
+            redraw = true;
+        }
+    };
+
+    LOG_INFO("Talking Dispenser started! Pronounce vowels 'a', 'o', 'i'...");
 
     while (running) {
+        // Block until something happens, then take everything that queued up
+        // meanwhile so a burst of changes costs a single frame
         SDL_Event event;
+        if (!SDL_WaitEvent(&event)) {
+            LOG_ERROR("SDL_WaitEvent failed: " << SDL_GetError());
+            break;
+        }
+        handleEvent(event);
         while (SDL_PollEvent(&event)) {
-            if (event.type == SDL_QUIT) {
-                running = false;
-            }
-            if (event.type == SDL_KEYDOWN && event.key.keysym.sym == SDLK_ESCAPE) {
-                running = false;
-            }
+            handleEvent(event);
         }
 
-        // Clear the screen with a black background
-        SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
-        SDL_RenderClear(renderer);
-
-        // Read audio data from the microphone
-        std::vector<short> audioBuffer(2048);
-        int samplesRead = micInput.read(audioBuffer.data(), static_cast<int>(audioBuffer.size()));
-
-        if (samplesRead > 0) {
-            // Priority: Direct vowel detection from audio
-            std::string detectedVowel = vowelDetector.detectVowel(audioBuffer, 16000);
-            
-            if (!detectedVowel.empty()) {
-                std::cout << "Direct detection: " << detectedVowel << std::endl;
-                std::vector<std::string> vowels = {detectedVowel};
-                vowelQueue.addVowels(vowels);
-                lastRecognitionTime = std::chrono::steady_clock::now();
-            }
-            
-            // Additionally: Vowel detection using Vosk (only if direct detection fails)
-            static std::string lastRecognizedText = "";
-            std::string recognizedText = recognizer.recognize(audioBuffer.data(), samplesRead);
-            
-            if (!recognizedText.empty() && recognizedText != lastRecognizedText) {
-                std::vector<std::string> newVowels = recognizer.extractNewVowels(recognizedText, lastRecognizedText);
-                if (!newVowels.empty() && detectedVowel.empty()) {
-                    std::cout << "Vosk backup: ";
-                    for (const auto& v : newVowels) {
-                        std::cout << v << " ";
-                    }
-                    std::cout << std::endl;
-                    vowelQueue.addVowels(newVowels);
-                    lastRecognitionTime = std::chrono::steady_clock::now();
-                }
-                lastRecognizedText = recognizedText;
-            }
+        if (!redraw || !running) {
+            continue;
         }
+        redraw = false;
 
-        // Update the displayed texture based on the detected vowel
-        std::string currentVowel = vowelQueue.getCurrentVowel();
-        if (!currentVowel.empty()) {
-            SDL_Texture* newTexture = nullptr;
-            
-            // Group vowels by lip shape
-            if (currentVowel == "а" || currentVowel == "я") {
-                newTexture = texture1;
-            } else if (currentVowel == "э" || currentVowel == "е") {
-                newTexture = texture2;
-            } else if (currentVowel == "и") {
-                newTexture = texture3;
-            } else if (currentVowel == "ы") {
-                newTexture = texture4;
-            } else if (currentVowel == "о" || currentVowel == "ё") {
-                newTexture = texture5;
-            } else if (currentVowel == "у" || currentVowel == "ю") {
-                newTexture = texture6;
-            }
-            
-            if (newTexture && currentTexture != newTexture) {
-                currentTexture = newTexture;
-                std::cout << "Switched to vowel group for '" << currentVowel << "'" << std::endl;
-            }
-        } else {
-            // Return to the 'silence' texture if no vowel is detected
-            auto currentTime = std::chrono::steady_clock::now();
-            if (currentTime - lastRecognitionTime > std::chrono::milliseconds(150)) {
-                if (currentTexture != texture7) {
-                    currentTexture = texture7;
-                    std::cout << "Back to silence" << std::endl;
-                }
-            }
-        }
+        // Clear the screen with a black background
+        SDL_SetRenderDrawColor(renderer.get(), 0, 0, 0, 255);
+        SDL_RenderClear(renderer.get());
 
-        // Display the current texture
-        if (currentTexture) {
-            SDL_RenderCopy(renderer, currentTexture, nullptr, nullptr);
-        }
+        // Display the current mouth shape
+        SDL_RenderCopy(renderer.get(), atlas.texture(), &atlas.rect(currentGroup), nullptr);
 
         // Update the screen with the rendered content
-        SDL_RenderPresent(renderer);
-
-        // Small delay to prevent high CPU usage
-        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        SDL_RenderPresent(renderer.get());
+        framesPresented++;
+
+        // The change is on screen now. Returns to silence have no audio behind
+        // them, so they only count toward the render stage
+        if (changeShown) {
+            changeShown = false;
+            auto presented = std::chrono::steady_clock::now();
+            pipeline.latency().record(LatencyStage::Render, presented - lastChange.publishTime);
+            if (lastChange.vowel != Vowel::None) {
+                pipeline.latency().record(LatencyStage::EndToEnd, presented - lastChange.captureTime);
+            }
+        }
     }
 
     // Stop audio recording
-    micInput.stop();
-
-    // Clean up resources before exiting
-    SDL_DestroyTexture(texture1);
-    SDL_DestroyTexture(texture2);
-    SDL_DestroyTexture(texture3);
-    SDL_DestroyTexture(texture4);
-    SDL_DestroyTexture(texture5);
-    SDL_DestroyTexture(texture6);
-    SDL_DestroyTexture(texture7);
-    SDL_DestroyRenderer(renderer);
-    SDL_DestroyWindow(window);
-    IMG_Quit();
-    SDL_Quit();
-
-    std::cout << "Program terminated." << std::endl;
+    pipeline.stop();
+
+    pipeline.printStatistics();
+    LOG_INFO("Frames presented: " << framesPresented);
+
+    LOG_INFO("Program terminated.");
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,29 @@
+#include "latency_trace.h"
+#include <csignal>
+
+std::atomic<bool> LatencyTrace::dumpRequested_(false);
+
+namespace {
+
+void onDumpSignal(int signal) {
+    LatencyTrace::requestDump();
+    std::signal(signal, onDumpSignal); // Some platforms reset the handler after one delivery
+}
+
+} // namespace
+
+void LatencyTrace::print(std::ostream& out) const {
+    for (size_t s = 0; s < LATENCY_STAGE_COUNT; s++) {
+        if (histograms_[s].count() > 0) {
+            histograms_[s].print(out, LATENCY_STAGE_NAMES[s]);
+        }
+    }
+}
+
+void installLatencyDumpSignal() {
+#ifdef _WIN32
+    std::signal(SIGBREAK, onDumpSignal);
+#else
+    std::signal(SIGUSR1, onDumpSignal);
+#endif
+}
@@ -0,0 +1,63 @@
+#ifndef LATENCY_TRACE_H
+#define LATENCY_TRACE_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <ostream>
+#include "../audio/latency_histogram.h"
+
+// Stages between a sound reaching the microphone and the mouth on screen.
+enum class LatencyStage {
+    Capture,       // ADC time of the newest sample to the pipeline reading it.
+    AnalysisQueue, // A read waiting for the analysis stage.
+    FrontEnd,      // Resampling one read to the speech and analysis rates.
+    Detect,        // Direct vowel detection on one read.
+    FusionQueue,   // A detection or Vosk result waiting for the fusion stage.
+    Publish,       // ADC time of the newest sample to the viseme change leaving the pipeline.
+    Render,        // Viseme change leaving the pipeline to SDL_RenderPresent returning.
+    EndToEnd       // ADC time of the newest sample to SDL_RenderPresent returning.
+};
+
+constexpr size_t LATENCY_STAGE_COUNT = 8;
+
+// Short name of every stage, indexed by LatencyStage.
+constexpr const char* LATENCY_STAGE_NAMES[LATENCY_STAGE_COUNT] = {
+    "capture", "analysis-queue", "front-end", "detect", "fusion-queue", "publish", "render", "end-to-end"
+};
+
+// The LatencyTrace class keeps one LatencyHistogram per stage. Stages are
+// recorded from whichever thread runs them; the Vosk queue and decode
+// times are kept by AsyncSpeechRecognizer itself.
+//
+// Besides printing on exit, a dump can be requested from a signal handler
+// (see installLatencyDumpSignal()); the pipeline's fusion stage prints it.
+class LatencyTrace {
+public:
+    void record(LatencyStage stage, std::chrono::nanoseconds duration) {
+        histograms_[static_cast<size_t>(stage)].record(duration);
+    }
+
+    const LatencyHistogram& histogram(LatencyStage stage) const {
+        return histograms_[static_cast<size_t>(stage)];
+    }
+
+    // Writes one line per stage that recorded anything.
+    void print(std::ostream& out) const;
+
+    // Asks for a dump; safe to call from a signal handler.
+    static void requestDump() { dumpRequested_.store(true, std::memory_order_relaxed); }
+
+    // Returns true once per requestDump().
+    static bool takeDumpRequest() { return dumpRequested_.exchange(false, std::memory_order_relaxed); }
+
+private:
+    LatencyHistogram histograms_[LATENCY_STAGE_COUNT];
+
+    static std::atomic<bool> dumpRequested_;
+};
+
+// Makes SIGUSR1 (SIGBREAK, i.e. Ctrl+Break, on Windows) request a latency dump.
+void installLatencyDumpSignal();
+
+#endif  // LATENCY_TRACE_H
@@ -0,0 +1,80 @@
+#include "viseme_event_writer.h"
+#include "../logging/logger.h"
+
+namespace {
+
+// Stores value little-endian regardless of the host byte order
+void putLittleEndian(unsigned char* out, uint64_t value, size_t bytes) {
+    for (size_t i = 0; i < bytes; i++) {
+        out[i] = static_cast<unsigned char>(value >> (8 * i));
+    }
+}
+
+} // namespace
+
+bool parseVisemeEventFormat(const std::string& text, VisemeEventFormat& format) {
+    if (text == "json") {
+        format = VisemeEventFormat::Json;
+    } else if (text == "binary") {
+        format = VisemeEventFormat::Binary;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+VisemeEventWriter::VisemeEventWriter(std::FILE* output, VisemeEventFormat format)
+    : output_(output), ownsOutput_(false), format_(format), headerWritten_(false), events_(0) {
+}
+
+VisemeEventWriter::VisemeEventWriter(const std::string& path, VisemeEventFormat format)
+    : output_(std::fopen(path.c_str(), format == VisemeEventFormat::Binary ? "wb" : "w")),
+      ownsOutput_(true), format_(format), headerWritten_(false), events_(0) {
+    if (!output_) {
+        LOG_ERROR("Failed to open " << path << " for writing");
+    }
+}
+
+VisemeEventWriter::~VisemeEventWriter() {
+    if (output_ && ownsOutput_) {
+        std::fclose(output_);
+    }
+}
+
+bool VisemeEventWriter::writeHeader() {
+    unsigned char header[8] = {'V', 'I', 'S', 'M'};
+    putLittleEndian(header + 4, BINARY_VERSION, 2);
+    putLittleEndian(header + 6, BINARY_RECORD_SIZE, 2);
+    headerWritten_ = true;
+    return std::fwrite(header, 1, sizeof(header), output_) == sizeof(header);
+}
+
+bool VisemeEventWriter::write(const VisemeChange& change) {
+    if (!output_) {
+        return false;
+    }
+
+    bool ok;
+    if (format_ == VisemeEventFormat::Binary) {
+        if (!headerWritten_ && !writeHeader()) {
+            return false;
+        }
+        unsigned char record[BINARY_RECORD_SIZE] = {};
+        putLittleEndian(record, static_cast<uint64_t>(change.captureSample), 8);
+        record[8] = static_cast<unsigned char>(change.group);
+        record[9] = static_cast<unsigned char>(change.vowel);
+        ok = std::fwrite(record, 1, sizeof(record), output_) == sizeof(record);
+    } else {
+        ok = std::fprintf(output_, "{\"sample\":%lld,\"t\":%.3f,\"group\":\"%s\",\"vowel\":\"%s\"}\n",
+                          static_cast<long long>(change.captureSample),
+                          change.captureSample / static_cast<double>(MultirateFrontEnd::SPEECH_RATE),
+                          visemeGroupId(change.group), vowelId(change.vowel)) > 0;
+    }
+
+    // Only events that reached the reader are counted
+    ok = ok && std::fflush(output_) == 0;
+    if (ok) {
+        events_++;
+    }
+    return ok;
+}
@@ -0,0 +1,66 @@
+#ifndef VISEME_EVENT_WRITER_H
+#define VISEME_EVENT_WRITER_H
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include "viseme_pipeline.h"
+
+// Encodings of the viseme event stream.
+enum class VisemeEventFormat {
+    Json,  // One JSON object per line
+    Binary // Fixed-size little-endian records after a short header
+};
+
+// Parses "json" or "binary". Returns false for anything else.
+bool parseVisemeEventFormat(const std::string& text, VisemeEventFormat& format);
+
+// The VisemeEventWriter class writes viseme changes for downstream animation
+// systems. Every event is flushed immediately, so a reader on a pipe sees it
+// as soon as the mouth shape changes.
+//
+// JSON lines:
+//   {"sample":19744,"t":1.234,"group":"open","vowel":"a"}
+// where sample counts 16 kHz capture samples, t is the same in seconds, and
+// vowel is "" for the return to silence.
+//
+// Binary stream: an 8-byte header "VISM", version (uint16, 1) and record size
+// (uint16, 12), then one 12-byte record per event: capture sample (int64),
+// group (uint8, VisemeGroup), vowel (uint8, Vowel), two zero bytes.
+class VisemeEventWriter {
+public:
+    // Writes to an already open stream (e.g. stdout); the stream is not closed.
+    VisemeEventWriter(std::FILE* output, VisemeEventFormat format);
+
+    // Opens a file for writing; check isOpen().
+    VisemeEventWriter(const std::string& path, VisemeEventFormat format);
+
+    // Closes the file if the writer opened it.
+    ~VisemeEventWriter();
+
+    VisemeEventWriter(const VisemeEventWriter&) = delete;
+    VisemeEventWriter& operator=(const VisemeEventWriter&) = delete;
+
+    bool isOpen() const { return output_ != nullptr; }
+
+    // Writes one event. Returns false if the output failed (e.g. the reader went away).
+    bool write(const VisemeChange& change);
+
+    // Events written and flushed successfully.
+    uint64_t eventCount() const { return events_; }
+
+    static constexpr uint16_t BINARY_VERSION = 1;
+    static constexpr uint16_t BINARY_RECORD_SIZE = 12;
+
+private:
+    // Writes the binary header before the first record.
+    bool writeHeader();
+
+    std::FILE* output_;
+    bool ownsOutput_;
+    VisemeEventFormat format_;
+    bool headerWritten_;
+    uint64_t events_;
+};
+
+#endif  // VISEME_EVENT_WRITER_H
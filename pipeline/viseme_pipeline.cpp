@@ -0,0 +1,451 @@
+#include "viseme_pipeline.h"
+#include <algorithm>
+#include <cstdlib>
+#include <sstream>
+#include "../audio/file_audio_source.h"
+#include "../audio/mic_input.h"
+#include "../logging/logger.h"
+
+namespace {
+
+// Names of the stages behind the configurable queues, as used on the command line
+StageQueueConfig* stageQueue(PipelineConfig& config, const std::string& stage) {
+    if (stage == "analysis") {
+        return &config.analysisQueue;
+    } else if (stage == "recognition") {
+        return &config.recognitionQueue;
+    } else if (stage == "fusion") {
+        return &config.fusionQueue;
+    } else if (stage == "render") {
+        return &config.renderQueue;
+    }
+    LOG_WARN("Unknown pipeline stage '" << stage << "', expected analysis, recognition, fusion or render");
+    return nullptr;
+}
+
+const char* dropPolicyName(DropPolicy policy) {
+    switch (policy) {
+        case DropPolicy::Block: return "block";
+        case DropPolicy::DropOldest: return "drop-oldest";
+        case DropPolicy::DropNewest: return "drop-newest";
+    }
+    return "?";
+}
+
+template <typename T>
+void logQueue(const char* stage, const StageQueue<T>& queue) {
+    LOG_INFO("Queue to " << stage << ": " << queue.pushedCount() << " pushed, " << queue.droppedCount()
+             << " dropped (" << queue.capacity() << " slots, " << dropPolicyName(queue.policy()) << ")");
+}
+
+} // namespace
+
+bool parsePipelineOption(int argc, char* argv[], int& i, PipelineConfig& config) {
+    std::string arg = argv[i];
+    if (arg == "--fast") {
+        config.fastPlayback = true;
+    } else if (arg == "--vowel-grammar") {
+        config.vowelGrammar = true;
+    } else if (arg == "--lpc") {
+        config.formantMethod = FormantMethod::Lpc;
+    } else if (arg == "--vowel-table" && i + 1 < argc) {
+        config.vowelTablePath = argv[++i];
+    } else if (arg == "--model" && i + 1 < argc) {
+        config.modelPath = argv[++i];
+    } else if (arg == "--resampler-quality" && i + 1 < argc) {
+        if (!parseResamplerQuality(argv[++i], config.resamplerQuality)) {
+            LOG_WARN("Unknown resampler quality '" << argv[i] << "', using balanced");
+        }
+    } else if (arg == "--queue-size" && i + 2 < argc) {
+        StageQueueConfig* queue = stageQueue(config, argv[i + 1]);
+        int size = std::atoi(argv[i + 2]);
+        if (queue && size > 0) {
+            queue->capacity = static_cast<size_t>(size);
+        }
+        i += 2;
+    } else if (arg == "--queue-policy" && i + 2 < argc) {
+        StageQueueConfig* queue = stageQueue(config, argv[i + 1]);
+        if (queue && !parseDropPolicy(argv[i + 2], queue->policy)) {
+            LOG_WARN("Unknown drop policy '" << argv[i + 2] << "', expected block, drop-oldest or drop-newest");
+        }
+        i += 2;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+VisemePipeline::VisemePipeline(const PipelineConfig& config)
+    : config_(config),
+      analysisQueue_(config.analysisQueue, CapturedBlock(AUDIO_BLOCK)),
+      fusionQueue_(config.fusionQueue),
+      renderQueue_(config.renderQueue),
+      stopping_(false), analyzing_(false), fusedEvents_(0), mouthClosed_(true),
+      readThreshold_(1), micInput_(nullptr), nativeSamplesRead_(0), captureBlockFirst_(0), captureBlockTime_(-1),
+      // Streaming analysis of the 8 kHz stream: a 512-sample frame every 128 samples (16 ms)
+      vowelDetector_(1024, ANALYSIS_HOP, config.formantMethod, MultirateFrontEnd::ANALYSIS_RATE),
+      capturedSamples_(0),
+      // Plays timed Vosk vowels back 300 ms behind the capture position
+      visemeScheduler_(4800),
+      fusionSample_(0), detectedVowel_(Vowel::None), currentGroup_(VisemeGroup::Silence),
+      silenceDeadline_(std::chrono::steady_clock::now()), newestCapture_(silenceDeadline_) {
+    // The microphone is used unless a recording is given
+    if (!config_.recordingPath.empty()) {
+        audioSource_ = std::make_unique<FileAudioSource>(config_.recordingPath,
+            config_.fastPlayback ? FileAudioSource::Pacing::AsFastAsPossible : FileAudioSource::Pacing::RealTime);
+    } else {
+        auto micInput = std::make_unique<MicInput>();
+        micInput_ = micInput.get();
+        audioSource_ = std::move(micInput);
+    }
+}
+
+VisemePipeline::~VisemePipeline() {
+    stop();
+    // The recognition worker pushes into fusionQueue_, which is destroyed before it
+    asyncRecognizer_.reset();
+}
+
+bool VisemePipeline::init() {
+    LOG_INFO("Formant engine: " << vowelDetector_.formantEngineName());
+    if (!config_.vowelTablePath.empty()) {
+        if (vowelTable_.loadFromFile(config_.vowelTablePath)) {
+            vowelDetector_.setVowelTable(vowelTable_);
+            LOG_INFO("Loaded " << vowelTable_.size() << " vowel profiles from " << config_.vowelTablePath);
+        } else {
+            LOG_WARN("Using the built-in vowel profiles");
+        }
+    }
+
+    if (!audioSource_->init()) {
+        LOG_ERROR("Failed to initialize audio input");
+        return false;
+    }
+
+    // Convert the source's native rate to 16 kHz for Vosk and 8 kHz for formant analysis
+    frontEnd_ = std::make_unique<MultirateFrontEnd>(audioSource_->sampleRate(), config_.resamplerQuality, AUDIO_BLOCK);
+    readThreshold_ = std::clamp(audioSource_->sampleRate() * ANALYSIS_HOP / MultirateFrontEnd::ANALYSIS_RATE,
+                                1, AUDIO_BLOCK);
+
+    // Initialize speech recognizer with the Vosk model
+    recognizer_ = std::make_unique<SpeechRecognizer>(config_.modelPath,
+        config_.vowelGrammar ? SpeechRecognizer::Mode::VowelGrammar : SpeechRecognizer::Mode::FullVocabulary);
+    if (!recognizer_->isValid()) {
+        LOG_ERROR("Failed to initialize speech recognizer");
+        return false;
+    }
+
+    // Ask Vosk for word timestamps so its vowels can be placed on the capture clock
+    recognizer_->setWordTimes(true);
+
+    // The recognition stage: Vosk decodes on its worker and sends results on to fusion
+    asyncRecognizer_ = std::make_unique<AsyncSpeechRecognizer>(*recognizer_, config_.recognitionQueue,
+        [this](RecognitionResult& result) {
+            recognitionEvent_.kind = FusionEvent::Kind::Recognition;
+            std::swap(recognitionEvent_.recognition, result);
+            recognitionEvent_.queuedTime = std::chrono::steady_clock::now();
+            fusionQueue_.push(recognitionEvent_);
+        }, AUDIO_BLOCK);
+    return true;
+}
+
+void VisemePipeline::start() {
+    if (!frontEnd_ || captureThread_.joinable() || stopping_.load()) {
+        return;
+    }
+    audioSource_->start();
+    analyzing_.store(true);
+    fusionThread_ = std::thread(&VisemePipeline::runFusion, this);
+    analysisThread_ = std::thread(&VisemePipeline::runAnalysis, this);
+    captureThread_ = std::thread(&VisemePipeline::runCapture, this);
+}
+
+void VisemePipeline::stop() {
+    // Downstream first would leave producers blocked on full queues, so
+    // close every queue, then wait for the threads front to back
+    stopping_.store(true);
+    if (audioSource_) {
+        audioSource_->stop();
+    }
+    analysisQueue_.close();
+    fusionQueue_.close();
+    renderQueue_.close();
+    for (std::thread* thread : {&captureThread_, &analysisThread_, &fusionThread_}) {
+        if (thread->joinable()) {
+            thread->join();
+        }
+    }
+}
+
+bool VisemePipeline::nextChange(VisemeChange& change, std::chrono::steady_clock::time_point deadline) {
+    return renderQueue_.pop(change, deadline);
+}
+
+bool VisemePipeline::pollChange(VisemeChange& change) {
+    return renderQueue_.tryPop(change);
+}
+
+bool VisemePipeline::isCapturing() const {
+    return audioSource_->isRunning() || analyzing_.load();
+}
+
+bool VisemePipeline::isDrained() const {
+    // Upstream first: once a stage is idle, nothing new reaches the next one
+    if (isCapturing() || (asyncRecognizer_ && !asyncRecognizer_->isIdle())) {
+        return false;
+    }
+    uint64_t fused = fusedEvents_.load(std::memory_order_acquire);
+    if (fused + fusionQueue_.droppedCount() < fusionQueue_.pushedCount()) {
+        return false;
+    }
+    return mouthClosed_.load(std::memory_order_acquire);
+}
+
+void VisemePipeline::runCapture() {
+    CapturedBlock block(AUDIO_BLOCK);
+    while (!stopping_.load()) {
+        // Wait for one analysis hop, then take whatever else has arrived meanwhile
+        int samplesRead = audioSource_->read(block.samples.data(), readThreshold_);
+        if (samplesRead == readThreshold_) {
+            samplesRead += audioSource_->readAvailable(block.samples.data() + samplesRead, AUDIO_BLOCK - samplesRead);
+        }
+        if (samplesRead <= 0) {
+            if (!audioSource_->isRunning()) {
+                break; // The recording ended or capture was stopped
+            }
+            continue;
+        }
+
+        block.size = samplesRead;
+        block.readTime = std::chrono::steady_clock::now();
+        block.captureTime = captureTime(samplesRead, block.readTime);
+        if (!analysisQueue_.push(block) && analysisQueue_.isClosed()) {
+            break;
+        }
+    }
+
+    // Let analysis finish what was read and then stop
+    analysisQueue_.close();
+}
+
+std::chrono::steady_clock::time_point VisemePipeline::captureTime(int samplesRead,
+                                                                 std::chrono::steady_clock::time_point readTime) {
+    nativeSamplesRead_ += static_cast<uint64_t>(samplesRead);
+    if (!micInput_) {
+        return readTime; // Recordings have no capture time; their audio counts as captured when read
+    }
+
+    // The newest block timestamp places every sample, read or not, on the steady clock
+    CaptureBlock block;
+    while (micInput_->popCaptureBlock(block)) {
+        captureBlockFirst_ = block.firstSample;
+        captureBlockTime_ = block.steadyTime;
+    }
+    if (captureBlockTime_ < 0) {
+        return readTime;
+    }
+    int64_t offset = static_cast<int64_t>(nativeSamplesRead_ - 1) - static_cast<int64_t>(captureBlockFirst_);
+    int64_t nanos = captureBlockTime_ + offset * 1000000000LL / audioSource_->sampleRate();
+    auto captured = std::chrono::steady_clock::time_point(std::chrono::nanoseconds(nanos));
+    latency_.record(LatencyStage::Capture, readTime - captured);
+    return captured;
+}
+
+void VisemePipeline::runAnalysis() {
+    CapturedBlock block(AUDIO_BLOCK);
+    FusionEvent event;
+    while (!stopping_.load() && analysisQueue_.pop(block)) {
+        auto start = std::chrono::steady_clock::now();
+        latency_.record(LatencyStage::AnalysisQueue, start - block.readTime);
+
+        // The capture clock counts 16 kHz samples, the rate Vosk timestamps use
+        frontEnd_->process(block.samples.data(), static_cast<size_t>(block.size));
+        capturedSamples_ += frontEnd_->speechSize();
+        auto detectStart = std::chrono::steady_clock::now();
+        latency_.record(LatencyStage::FrontEnd, detectStart - start);
+
+        // Priority: Direct vowel detection from audio, one overlapping frame per hop
+        Vowel detected = vowelDetector_.process(frontEnd_->analysis(), frontEnd_->analysisSize(),
+                                                MultirateFrontEnd::ANALYSIS_RATE);
+        latency_.record(LatencyStage::Detect, std::chrono::steady_clock::now() - detectStart);
+        if (detected != Vowel::None) {
+            LOG_DEBUG("Direct detection: " << vowelName(detected));
+        }
+
+        // Every read moves the fusion stage's capture clock, vowel or not
+        event.kind = FusionEvent::Kind::Analysis;
+        event.vowel = detected;
+        event.captureSample = capturedSamples_;
+        event.captureTime = block.captureTime;
+        event.queuedTime = std::chrono::steady_clock::now();
+        fusionQueue_.push(event);
+
+        // Additionally: hand the block to the recognition stage, unless it is
+        // silence or the direct detector already recognized it
+        int gatedSamples = voiceGate_.process(frontEnd_->speech(), static_cast<int>(frontEnd_->speechSize()),
+                                              vowelDetector_.lastFrameVoiced(), detected != Vowel::None);
+        for (int offset = 0; offset < gatedSamples; offset += AUDIO_BLOCK) {
+            int blockSize = std::min(gatedSamples - offset, AUDIO_BLOCK);
+            asyncRecognizer_->post(voiceGate_.output() + offset, blockSize,
+                                   static_cast<int64_t>(voiceGate_.outputStartSample()) + offset);
+        }
+    }
+    analyzing_.store(false);
+}
+
+void VisemePipeline::runFusion() {
+    FusionEvent event;
+    VisemeChange change;
+    while (true) {
+        // Sleep until there is news or the silence timer fires
+        auto wakeAt = std::min(std::chrono::steady_clock::now() + FUSION_IDLE_WAIT, silenceDeadline());
+        bool fused = fusionQueue_.pop(event, wakeAt);
+        if (fused) {
+            latency_.record(LatencyStage::FusionQueue, std::chrono::steady_clock::now() - event.queuedTime);
+            if (fuse(event, change)) {
+                publish(change);
+            }
+        } else if (fusionQueue_.isClosed()) {
+            break;
+        }
+
+        if (expireSilence(change)) {
+            publish(change);
+        }
+
+        // For isDrained(): the mouth state is stored before the event is counted
+        mouthClosed_.store(currentGroup_ == VisemeGroup::Silence, std::memory_order_release);
+        if (fused) {
+            fusedEvents_.fetch_add(1, std::memory_order_release);
+        }
+
+        // A dump requested by a signal is printed from here, off the signal handler
+        if (LatencyTrace::takeDumpRequest()) {
+            logLatency();
+        }
+    }
+}
+
+bool VisemePipeline::fuse(const FusionEvent& event, VisemeChange& change) {
+    if (event.kind == FusionEvent::Kind::Analysis) {
+        fusionSample_ = event.captureSample;
+        newestCapture_ = event.captureTime;
+        detectedVowel_ = event.vowel;
+        if (detectedVowel_ != Vowel::None) {
+            vowelQueue_.addVowel(detectedVowel_);
+            silenceDeadline_ = std::chrono::steady_clock::now() + SILENCE_DELAY;
+        }
+    } else {
+        // Vowel detection using Vosk (only if direct detection fails)
+        const RecognitionResult& recognition = event.recognition;
+        if (!recognition.timedVowels.empty()) {
+            // Timed vowels are played back by the scheduler below
+            visemeScheduler_.schedule(recognition.timedVowels, fusionSample_);
+        } else if (!recognition.vowels.empty() && detectedVowel_ == Vowel::None) {
+            LOG_DEBUG("Vosk backup: " << vowelNames(recognition.vowels));
+            vowelQueue_.addVowels(recognition.vowels);
+            silenceDeadline_ = std::chrono::steady_clock::now() + SILENCE_DELAY;
+        }
+    }
+
+    // Show the Vosk vowel that is due on the capture clock
+    Vowel scheduledVowel = visemeScheduler_.vowelAt(fusionSample_);
+    if (scheduledVowel != Vowel::None && detectedVowel_ == Vowel::None) {
+        vowelQueue_.addVowel(scheduledVowel);
+        silenceDeadline_ = std::chrono::steady_clock::now() + SILENCE_DELAY;
+    }
+
+    // Update the mouth shape based on the detected vowel; closing it is left
+    // to expireSilence()
+    Vowel currentVowel = vowelQueue_.getCurrentVowel();
+    if (currentVowel == Vowel::None) {
+        return false;
+    }
+
+    // Group vowels by lip shape, as the vowel table maps them
+    VisemeGroup group = vowelTable_.visemeGroup(currentVowel);
+    if (group == currentGroup_) {
+        return false;
+    }
+    LOG_DEBUG("Switched to vowel group for '" << vowelName(currentVowel) << "'");
+    currentGroup_ = group;
+    change.captureSample = fusionSample_;
+    change.vowel = currentVowel;
+    change.group = group;
+    change.captureTime = newestCapture_;
+    return true;
+}
+
+std::chrono::steady_clock::time_point VisemePipeline::silenceDeadline() const {
+    if (currentGroup_ == VisemeGroup::Silence) {
+        return std::chrono::steady_clock::time_point::max();
+    }
+    return silenceDeadline_;
+}
+
+bool VisemePipeline::expireSilence(VisemeChange& change) {
+    // Return to silence if no vowel has been recognized for SILENCE_DELAY
+    if (currentGroup_ == VisemeGroup::Silence || std::chrono::steady_clock::now() < silenceDeadline_) {
+        return false;
+    }
+    LOG_DEBUG("Back to silence");
+    currentGroup_ = VisemeGroup::Silence;
+    change.captureSample = fusionSample_;
+    change.vowel = Vowel::None;
+    change.group = VisemeGroup::Silence;
+    change.captureTime = silenceDeadline_;
+    return true;
+}
+
+void VisemePipeline::publish(VisemeChange& change) {
+    change.publishTime = std::chrono::steady_clock::now();
+    if (change.vowel != Vowel::None) {
+        latency_.record(LatencyStage::Publish, change.publishTime - change.captureTime);
+    }
+    if (renderQueue_.push(change) && changeNotifier_) {
+        changeNotifier_();
+    }
+}
+
+void VisemePipeline::printStatistics() const {
+    if (auto* micInput = dynamic_cast<MicInput*>(audioSource_.get())) {
+        LOG_INFO("Capture overflows: " << micInput->overflowCount() << ", underruns: " << micInput->underrunCount());
+    }
+    logQueue("analysis", analysisQueue_);
+    logQueue("fusion", fusionQueue_);
+    logQueue("render", renderQueue_);
+    if (asyncRecognizer_) {
+        LOG_INFO("Vosk blocks posted: " << asyncRecognizer_->postedBlocks()
+                 << ", dropped: " << asyncRecognizer_->droppedBlocks()
+                 << ", batches decoded: " << asyncRecognizer_->decodedBatches());
+    }
+    LOG_INFO("Timed Vosk vowels: " << visemeScheduler_.scheduledCount()
+             << ", late: " << visemeScheduler_.lateCount()
+             << ", arrival latency avg/max: " << visemeScheduler_.averageArrivalLatency() * 1000.0 / 16000
+             << "/" << visemeScheduler_.maxArrivalLatency() * 1000 / 16000 << " ms");
+    if (voiceGate_.samplesIn() > 0) {
+        LOG_INFO("Audio skipped by voice gate: " << voiceGate_.samplesSkipped() << " of "
+                 << voiceGate_.samplesIn() << " samples ("
+                 << 100.0 * voiceGate_.samplesSkipped() / voiceGate_.samplesIn() << "%)");
+    }
+    logLatency();
+}
+
+void VisemePipeline::logLatency() const {
+    // The histograms print themselves to a stream; log what they print line by line
+    std::ostringstream report;
+    printLatency(report);
+    std::istringstream lines(report.str());
+    for (std::string line; std::getline(lines, line);) {
+        LOG_INFO(line);
+    }
+}
+
+void VisemePipeline::printLatency(std::ostream& out) const {
+    out << "Latency per stage:" << std::endl;
+    latency_.print(out);
+    if (asyncRecognizer_) {
+        asyncRecognizer_->queueLatency().print(out, "vosk-queue");
+        asyncRecognizer_->decodeLatency().print(out, "vosk-decode");
+    }
+}
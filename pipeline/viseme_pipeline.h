@@ -0,0 +1,240 @@
+#ifndef VISEME_PIPELINE_H
+#define VISEME_PIPELINE_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../audio/audio_source.h"
+#include "../audio/multirate_front_end.h"
+#include "../audio/stage_queue.h"
+#include "../audio/viseme_scheduler.h"
+#include "../audio/voice_activity_gate.h"
+#include "../audio/vowel_detector.h"
+#include "../audio/vowel_queue.h"
+#include "../recognizer/async_recognizer.h"
+#include "../recognizer/vosk_recognizer.h"
+#include "latency_trace.h"
+
+// Settings of a VisemePipeline, usually taken from the command line.
+struct PipelineConfig {
+    std::string recordingPath;     // Recording to play back; the microphone if empty.
+    bool fastPlayback = false;     // Play the recording as fast as possible instead of in real time.
+    bool vowelGrammar = false;     // Restrict Vosk to vowel syllables and short words.
+    FormantMethod formantMethod = FormantMethod::SpectralPeaks;
+    std::string vowelTablePath;    // Vowel formant profiles to load; built-in ones if empty.
+    ResamplerQuality resamplerQuality = ResamplerQuality::Balanced;
+    std::string modelPath = "C:/Users/Acer/Desktop/main/model/vosk-model-small-ru-0.22";
+
+    // Queues in front of each stage. Capture waits for analysis rather than
+    // lose audio (the microphone's ring buffer absorbs short stalls), Vosk
+    // and the renderer only care about the newest data.
+    StageQueueConfig analysisQueue{16, DropPolicy::Block};         // Captured reads.
+    StageQueueConfig recognitionQueue{16, DropPolicy::DropOldest}; // Gated 16 kHz speech for Vosk.
+    StageQueueConfig fusionQueue{64, DropPolicy::Block};           // Detections and Vosk results.
+    StageQueueConfig renderQueue{16, DropPolicy::DropOldest};      // Mouth shape changes.
+};
+
+// Parses the pipeline option at argv[i], advancing i past its value:
+//   --fast, --vowel-grammar, --lpc, --vowel-table <file>,
+//   --resampler-quality fast|balanced|high, --model <dir>,
+//   --queue-size <stage> <items>, --queue-policy <stage> block|drop-oldest|drop-newest
+// where <stage> is the stage behind the queue: analysis, recognition, fusion or render.
+// Returns false if argv[i] is not a pipeline option.
+bool parsePipelineOption(int argc, char* argv[], int& i, PipelineConfig& config);
+
+class MicInput;
+
+// One change of the displayed mouth shape.
+struct VisemeChange {
+    int64_t captureSample; // Capture clock (16 kHz samples since start) when the change happened.
+    Vowel vowel;           // Vowel that caused it, Vowel::None for the return to silence.
+    VisemeGroup group;     // The new mouth shape.
+    // When the newest audio the change was based on reached the microphone
+    // (the read time for recordings, the silence deadline for silence), and
+    // when the change left the pipeline.
+    std::chrono::steady_clock::time_point captureTime;
+    std::chrono::steady_clock::time_point publishTime;
+};
+
+// The VisemePipeline class is everything between the audio source and the
+// mouth shape. It runs as a chain of stages, each on a thread of its own and
+// connected to the next by a bounded StageQueue, so every stage goes at its
+// natural rate and the slowest one no longer paces the others:
+//
+//   capture      reads the audio source one analysis hop at a time
+//   analysis     resamples, detects vowels directly and gates speech for Vosk
+//   recognition  decodes the gated speech (AsyncSpeechRecognizer's worker)
+//   fusion       arbitrates direct and Vosk vowels, schedules timed Vosk
+//                vowels and closes the mouth after SILENCE_DELAY without one
+//   render       the owner, taking changes with nextChange() or pollChange()
+//
+// Each queue's size and full-queue policy come from PipelineConfig. The
+// pipeline has no rendering dependencies, so the windowed application and
+// headless consumers drive the same code.
+class VisemePipeline {
+public:
+    // Called on the fusion thread after a change was queued for the renderer.
+    using ChangeNotifier = std::function<void()>;
+
+    explicit VisemePipeline(const PipelineConfig& config);
+
+    // Stops the stages if they are running.
+    ~VisemePipeline();
+
+    VisemePipeline(const VisemePipeline&) = delete;
+    VisemePipeline& operator=(const VisemePipeline&) = delete;
+
+    // Opens the audio source and loads the vowel table and the Vosk model.
+    // Returns true if successful, false otherwise (the reason is logged).
+    bool init();
+
+    // Sets a callback that wakes the renderer, e.g. by posting to its event
+    // loop. Must be called before start().
+    void setChangeNotifier(ChangeNotifier notifier) { changeNotifier_ = std::move(notifier); }
+
+    // Starts audio capture and the stage threads, and stops both. A stopped
+    // pipeline cannot be started again.
+    void start();
+    void stop();
+
+    // Takes the oldest mouth shape change not yet rendered, waiting for one
+    // until the deadline. Returns false if none arrived or the pipeline stopped.
+    bool nextChange(VisemeChange& change, std::chrono::steady_clock::time_point deadline);
+
+    // Takes the oldest change without waiting. Returns false if there is none.
+    bool pollChange(VisemeChange& change);
+
+    // Checks whether audio is still coming in: false once a recording has
+    // ended and everything read from it has been analyzed.
+    bool isCapturing() const;
+
+    // Checks whether a finished input has been fully processed: nothing is
+    // captured or analyzed any more, Vosk has decoded everything posted to it,
+    // the fusion stage has taken every event and the mouth has closed after
+    // SILENCE_DELAY. Every change is then in the render queue.
+    bool isDrained() const;
+
+    // Logs queue, scheduler and gate counters and the latency histograms.
+    // Call after stop().
+    void printStatistics() const;
+
+    // Writes the per-stage latency histograms, including Vosk's queue and decode times.
+    void printLatency(std::ostream& out) const;
+
+    // Per-stage latencies. The pipeline records up to Publish; whoever shows
+    // the changes records Render and EndToEnd.
+    LatencyTrace& latency() { return latency_; }
+
+    // Time without recognized vowels after which the mouth closes.
+    static constexpr std::chrono::milliseconds SILENCE_DELAY{150};
+
+    // Longest time the fusion stage sleeps without news, so latency dumps
+    // requested by a signal are printed while the input is quiet.
+    static constexpr std::chrono::milliseconds FUSION_IDLE_WAIT{100};
+
+private:
+    // One read from the audio source, passed from capture to analysis.
+    struct CapturedBlock {
+        explicit CapturedBlock(size_t capacity = 0) : samples(capacity) {}
+
+        std::vector<short> samples;                        // Native-rate audio, AUDIO_BLOCK long.
+        int size = 0;                                      // Samples used.
+        std::chrono::steady_clock::time_point readTime;    // When the capture stage read it.
+        std::chrono::steady_clock::time_point captureTime; // When its newest sample reached the microphone.
+    };
+
+    // Something for the fusion stage to act on.
+    struct FusionEvent {
+        enum class Kind { Analysis, Recognition };
+        Kind kind = Kind::Analysis;
+        // Analysis: the direct detection for one read and the capture clock after it
+        Vowel vowel = Vowel::None;
+        int64_t captureSample = 0;
+        std::chrono::steady_clock::time_point captureTime;
+        // Recognition: a Vosk result
+        RecognitionResult recognition;
+        std::chrono::steady_clock::time_point queuedTime;
+    };
+
+    PipelineConfig config_;
+
+    std::unique_ptr<AudioSource> audioSource_;
+    std::unique_ptr<SpeechRecognizer> recognizer_;
+    std::unique_ptr<AsyncSpeechRecognizer> asyncRecognizer_; // Declared after recognizer_, destroyed first.
+    LatencyTrace latency_;
+
+    StageQueue<CapturedBlock> analysisQueue_;
+    StageQueue<FusionEvent> fusionQueue_;
+    StageQueue<VisemeChange> renderQueue_;
+    ChangeNotifier changeNotifier_;
+
+    std::thread captureThread_;
+    std::thread analysisThread_;
+    std::thread fusionThread_;
+    std::atomic<bool> stopping_;
+    std::atomic<bool> analyzing_;         // Until the analysis stage has taken the last captured read.
+    std::atomic<uint64_t> fusedEvents_;   // Fusion events applied, their changes published.
+    std::atomic<bool> mouthClosed_;       // The fusion stage last showed silence.
+
+    // Capture stage
+    int readThreshold_;                   // Native samples per analysis hop, the least worth reading.
+    MicInput* micInput_;                  // audioSource_ if it is the microphone, for capture timestamps.
+    uint64_t nativeSamplesRead_;          // Samples read from the source so far.
+    uint64_t captureBlockFirst_;          // First sample of the last capture block timestamp seen.
+    int64_t captureBlockTime_;            // Its steady-clock time in nanoseconds, -1 before the first.
+
+    // Analysis stage
+    std::unique_ptr<MultirateFrontEnd> frontEnd_;
+    VowelDetector vowelDetector_;
+    VoiceActivityGate voiceGate_;
+    int64_t capturedSamples_;             // Capture clock: 16 kHz samples analyzed so far.
+
+    // Recognition stage, on AsyncSpeechRecognizer's worker
+    FusionEvent recognitionEvent_;        // Swapped into fusionQueue_ with every result.
+
+    // Fusion stage
+    VisemeScheduler visemeScheduler_;
+    VowelQueue vowelQueue_;
+    int64_t fusionSample_;                // Capture clock as of the newest analysis event.
+    Vowel detectedVowel_;                 // Result of the most recent direct detection.
+    VisemeGroup currentGroup_;            // Mouth shape shown now.
+    VowelTable vowelTable_;               // Vowel profiles and the mouth shape of each vowel, set by init().
+    std::chrono::steady_clock::time_point silenceDeadline_; // SILENCE_DELAY after a vowel was last queued.
+    std::chrono::steady_clock::time_point newestCapture_;   // When the newest analyzed sample reached the microphone.
+
+    // Stage thread bodies.
+    void runCapture();
+    void runAnalysis();
+    void runFusion();
+
+    // Fusion: applies one event; returns true and fills change if the mouth shape changed.
+    bool fuse(const FusionEvent& event, VisemeChange& change);
+
+    // Fusion: time at which the mouth closes unless another vowel is
+    // recognized; time_point::max() while it is closed.
+    std::chrono::steady_clock::time_point silenceDeadline() const;
+
+    // Fusion: returns the mouth to silence if silenceDeadline() has passed.
+    bool expireSilence(VisemeChange& change);
+
+    // Fusion: hands a change to the renderer.
+    void publish(VisemeChange& change);
+
+    // Logs printLatency() line by line.
+    void logLatency() const;
+
+    // Capture: returns when the newest of the samplesRead samples just read
+    // reached the microphone.
+    std::chrono::steady_clock::time_point captureTime(int samplesRead, std::chrono::steady_clock::time_point readTime);
+
+    static constexpr int AUDIO_BLOCK = 2048;   // Largest block read from the source and posted to Vosk.
+    static constexpr int ANALYSIS_HOP = 128;   // Detector hop at the 8 kHz analysis rate (16 ms).
+};
+
+#endif  // VISEME_PIPELINE_H
@@ -0,0 +1,113 @@
+#include "async_recognizer.h"
+#include <algorithm>
+#include <utility>
+
+AsyncSpeechRecognizer::AsyncSpeechRecognizer(SpeechRecognizer& recognizer, StageQueueConfig queue,
+                                             ResultHandler onResult, size_t maxBlockSize, size_t batchSize)
+    : recognizer_(recognizer), batchSize_(std::max(batchSize, maxBlockSize)), onResult_(std::move(onResult)),
+      // Every slot gets its samples up front so post() does not allocate
+      blocks_({std::max<size_t>(queue.capacity, 1), queue.policy}, AudioBlock(maxBlockSize)),
+      postBlock_(maxBlockSize), stopping_(false),
+      decodedBatches_(0), handledBlocks_(0), droppedResults_(0) {
+    worker_ = std::thread(&AsyncSpeechRecognizer::run, this);
+}
+
+AsyncSpeechRecognizer::~AsyncSpeechRecognizer() {
+    stopping_.store(true);
+    blocks_.close();
+    if (worker_.joinable()) {
+        worker_.join();
+    }
+}
+
+void AsyncSpeechRecognizer::post(const short* audio, int audioSize, int64_t captureSample) {
+    if (!audio || audioSize <= 0) {
+        return;
+    }
+
+    postBlock_.size = std::min(static_cast<size_t>(audioSize), postBlock_.samples.size());
+    std::copy(audio, audio + postBlock_.size, postBlock_.samples.begin());
+    postBlock_.captureSample = captureSample;
+    postBlock_.postTime = std::chrono::steady_clock::now();
+    blocks_.push(postBlock_);
+}
+
+bool AsyncSpeechRecognizer::isIdle() const {
+    // A queued block is either taken by the worker or dropped, so the two
+    // counts catch up with the posted count once the worker has finished
+    uint64_t posted = blocks_.pushedCount();
+    return handledBlocks_.load(std::memory_order_acquire) + blocks_.droppedCount() >= posted;
+}
+
+bool AsyncSpeechRecognizer::pollResult(RecognitionResult& result) {
+    std::lock_guard<std::mutex> lock(resultMutex_);
+    if (results_.empty()) {
+        return false;
+    }
+    result = std::move(results_.front());
+    results_.pop_front();
+    return true;
+}
+
+void AsyncSpeechRecognizer::run() {
+    std::vector<short> batch;
+    batch.reserve(batchSize_);
+    std::string lastRecognizedText;
+    AudioBlock block(postBlock_.samples.size());
+    bool haveBlock = false; // A block taken from the queue that did not fit the last batch
+
+    while (true) {
+        if (!haveBlock && !blocks_.pop(block)) {
+            return; // Closed
+        }
+        if (stopping_.load()) {
+            return;
+        }
+
+        // Take as many queued blocks as fit into one batch, remembering where
+        // each one lands on the decoder's timeline
+        batch.clear();
+        int64_t decoderPosition = recognizer_.decodedSamples();
+        queueLatency_.record(std::chrono::steady_clock::now() - block.postTime);
+        uint64_t batchBlocks = 0;
+        do {
+            batchBlocks++;
+            timeline_.addSegment(decoderPosition + static_cast<int64_t>(batch.size()),
+                                 block.captureSample, static_cast<int64_t>(block.size));
+            batch.insert(batch.end(), block.samples.begin(), block.samples.begin() + block.size);
+            haveBlock = blocks_.tryPop(block);
+        } while (haveBlock && batch.size() + block.size <= batchSize_);
+
+        // Decode while post() keeps queueing
+        decodedBatches_.fetch_add(1, std::memory_order_relaxed);
+        auto decodeStart = std::chrono::steady_clock::now();
+        const std::string& recognizedText = recognizer_.recognize(batch.data(), static_cast<int>(batch.size()));
+        decodeLatency_.record(std::chrono::steady_clock::now() - decodeStart);
+
+        if (!recognizedText.empty() && recognizedText != lastRecognizedText) {
+            RecognitionResult result;
+            result.vowels = recognizer_.extractNewVowels(recognizedText, lastRecognizedText);
+            result.text = recognizedText;
+
+            // Publish only timed vowels that lie after the ones already sent
+            timeline_.takeNewVowels(recognizer_.extractTimedVowels(), result.timedVowels);
+
+            lastRecognizedText = recognizedText;
+            if (onResult_) {
+                onResult_(result);
+            } else {
+                publish(std::move(result));
+            }
+        }
+        handledBlocks_.fetch_add(batchBlocks, std::memory_order_release);
+    }
+}
+
+void AsyncSpeechRecognizer::publish(RecognitionResult&& result) {
+    std::lock_guard<std::mutex> lock(resultMutex_);
+    if (results_.size() >= MAX_PENDING_RESULTS) {
+        results_.pop_front();
+        droppedResults_.fetch_add(1, std::memory_order_relaxed);
+    }
+    results_.push_back(std::move(result));
+}
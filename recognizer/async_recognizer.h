@@ -0,0 +1,125 @@
+#ifndef ASYNC_RECOGNIZER_H
+#define ASYNC_RECOGNIZER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "decoder_timeline.h"
+#include "../audio/latency_histogram.h"
+#include "../audio/stage_queue.h"
+#include "vosk_recognizer.h"
+
+// One decoded update produced by the recognition worker.
+struct RecognitionResult {
+    std::string text;                     // Recognized text (partial or final).
+    std::vector<Vowel> vowels;            // Vowels that are new compared to the previous update.
+    std::vector<TimedVowel> timedVowels;  // New vowels with capture-sample timing (needs word times enabled).
+};
+
+// The AsyncSpeechRecognizer class runs a SpeechRecognizer on its own worker
+// thread. Audio blocks are posted to a bounded StageQueue and decoded in
+// larger batches; results come back through a queue that is polled without
+// waiting, or are handed to a callback on the worker thread. By default the
+// oldest queued audio is dropped when the decoder falls behind, so the
+// caller never blocks.
+class AsyncSpeechRecognizer {
+public:
+    // Receives every result on the worker thread; it may take the result's contents.
+    using ResultHandler = std::function<void(RecognitionResult&)>;
+
+    // Constructor: Starts the worker thread.
+    // Parameters:
+    // - recognizer: The recognizer to drive. Must outlive this object and must
+    //   not be used by anyone else while the worker is running.
+    // - queue: Number of audio blocks waiting to be decoded, and what post()
+    //   does when that many are waiting.
+    // - onResult: Called with each result instead of queueing it for pollResult().
+    // - maxBlockSize: Largest block, in samples, that post() accepts without truncation.
+    // - batchSize: Maximum number of samples fed to Vosk in one call.
+    AsyncSpeechRecognizer(SpeechRecognizer& recognizer,
+                          StageQueueConfig queue = {16, DropPolicy::DropOldest},
+                          ResultHandler onResult = nullptr,
+                          size_t maxBlockSize = 2048, size_t batchSize = 8192);
+
+    // Destructor: Stops the worker thread, discarding audio that was not decoded.
+    ~AsyncSpeechRecognizer();
+
+    AsyncSpeechRecognizer(const AsyncSpeechRecognizer&) = delete;
+    AsyncSpeechRecognizer& operator=(const AsyncSpeechRecognizer&) = delete;
+
+    // Queues a block of audio for decoding, applying the queue's drop policy
+    // if it is full. Call from one thread at a time.
+    // Parameters:
+    // - audio: Pointer to the audio data (16-bit PCM samples).
+    // - audioSize: Number of samples in the audio data.
+    // - captureSample: Capture-clock index of the block's first sample, used to
+    //   place timed vowels; -1 if unknown.
+    void post(const short* audio, int audioSize, int64_t captureSample = -1);
+
+    // Checks whether every block posted so far has been decoded, or dropped,
+    // and its result handed on. Only conclusive while nothing is being posted.
+    bool isIdle() const;
+
+    // Retrieves the oldest pending result without waiting.
+    // Returns false if no result is ready.
+    bool pollResult(RecognitionResult& result);
+
+    // Counters for monitoring the queue.
+    uint64_t postedBlocks() const { return blocks_.pushedCount(); }
+    uint64_t droppedBlocks() const { return blocks_.droppedCount(); }
+    uint64_t decodedBatches() const { return decodedBatches_.load(std::memory_order_relaxed); }
+    uint64_t droppedResults() const { return droppedResults_.load(std::memory_order_relaxed); }
+
+    // Time the oldest block of a batch waited in the queue, and time Vosk
+    // spent decoding each batch.
+    const LatencyHistogram& queueLatency() const { return queueLatency_; }
+    const LatencyHistogram& decodeLatency() const { return decodeLatency_; }
+
+private:
+    // A queued block. Slots are allocated once and reused.
+    struct AudioBlock {
+        explicit AudioBlock(size_t capacity = 0) : samples(capacity) {}
+
+        std::vector<short> samples;
+        size_t size = 0;
+        int64_t captureSample = -1;
+        std::chrono::steady_clock::time_point postTime;
+    };
+
+    SpeechRecognizer& recognizer_; // Recognizer driven by the worker thread.
+    size_t batchSize_;             // Maximum samples per Vosk call.
+    ResultHandler onResult_;       // Takes results instead of results_, if set.
+
+    StageQueue<AudioBlock> blocks_;         // Audio waiting for the worker; slots are preallocated.
+    AudioBlock postBlock_;                  // Filled by post(), swapped with a queue slot.
+    std::atomic<bool> stopping_;            // Set when the worker should exit.
+
+    std::mutex resultMutex_;                // Protects the result queue.
+    std::deque<RecognitionResult> results_; // Results not yet polled.
+
+    std::atomic<uint64_t> decodedBatches_; // Batches handed to Vosk.
+    std::atomic<uint64_t> handledBlocks_;  // Blocks decoded with their result delivered.
+    std::atomic<uint64_t> droppedResults_; // Results discarded because nobody polled them.
+    LatencyHistogram queueLatency_;        // post() to the start of decoding.
+    LatencyHistogram decodeLatency_;       // Duration of each Vosk call.
+
+    DecoderTimeline timeline_;      // Decoder-to-capture mapping, owned by the worker.
+
+    std::thread worker_; // Decoding thread, started last.
+
+    // Worker thread body: drains the queue into batches and decodes them.
+    void run();
+
+    // Publishes a result, dropping the oldest one if too many are pending.
+    void publish(RecognitionResult&& result);
+
+    static constexpr size_t MAX_PENDING_RESULTS = 32; // Results kept for a caller that stops polling.
+};
+
+#endif  // ASYNC_RECOGNIZER_H
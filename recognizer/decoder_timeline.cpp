@@ -0,0 +1,44 @@
+#include "decoder_timeline.h"
+#include <algorithm>
+#include <utility>
+
+void DecoderTimeline::addSegment(int64_t decoderStart, int64_t captureStart, int64_t size) {
+    segments_.push_back({decoderStart, captureStart, size});
+    if (segments_.size() > MAX_SEGMENTS) {
+        segments_.pop_front();
+    }
+}
+
+int64_t DecoderTimeline::toCaptureSample(int64_t decoderSample) const {
+    // Find the newest segment starting at or before the sample; samples past a
+    // segment's end (a gap in the capture stream) are clamped to that end
+    for (auto it = segments_.rbegin(); it != segments_.rend(); ++it) {
+        if (it->decoderStart <= decoderSample) {
+            if (it->captureStart < 0) {
+                return -1;
+            }
+            return it->captureStart + std::min(decoderSample - it->decoderStart, it->size);
+        }
+    }
+    return -1;
+}
+
+void DecoderTimeline::takeNewVowels(std::vector<TimedVowel>&& decoded, std::vector<TimedVowel>& out) {
+    // Publish only timed vowels that lie after the ones already sent
+    for (TimedVowel& vowel : decoded) {
+        if (vowel.startSample < lastTimedEnd_ - TIMING_TOLERANCE) {
+            continue;
+        }
+        lastTimedEnd_ = vowel.endSample;
+        vowel.startSample = toCaptureSample(vowel.startSample);
+        vowel.endSample = toCaptureSample(vowel.endSample);
+        if (vowel.startSample >= 0 && vowel.endSample >= vowel.startSample) {
+            out.push_back(std::move(vowel));
+        }
+    }
+}
+
+void DecoderTimeline::reset() {
+    segments_.clear();
+    lastTimedEnd_ = 0;
+}
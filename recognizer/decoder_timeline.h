@@ -0,0 +1,45 @@
+#ifndef DECODER_TIMELINE_H
+#define DECODER_TIMELINE_H
+
+#include <cstdint>
+#include <deque>
+#include <vector>
+#include "vosk_recognizer.h"
+
+// The DecoderTimeline class maps positions on a SpeechRecognizer's decoder
+// timeline (samples actually fed to Vosk) back to the capture clock. Gated
+// audio reaches the decoder with gaps, so every decoded stretch is recorded
+// together with where it came from.
+class DecoderTimeline {
+public:
+    // Records that size decoder samples starting at decoderStart came from the
+    // capture clock at captureStart (-1 if unknown).
+    void addSegment(int64_t decoderStart, int64_t captureStart, int64_t size);
+
+    // Maps a decoder-timeline sample to the capture clock. Returns -1 if unknown.
+    int64_t toCaptureSample(int64_t decoderSample) const;
+
+    // Moves the vowels of a result that lie after the ones already taken into
+    // out, converted to the capture clock. Partial results repeat earlier
+    // words with slightly revised times; those are skipped.
+    void takeNewVowels(std::vector<TimedVowel>&& decoded, std::vector<TimedVowel>& out);
+
+    // Forgets all segments and taken vowels.
+    void reset();
+
+private:
+    // Where a stretch of decoded audio came from on the capture clock.
+    struct Segment {
+        int64_t decoderStart;  // First sample on the decoder's timeline.
+        int64_t captureStart;  // First sample on the capture clock (-1 if unknown).
+        int64_t size;          // Number of samples.
+    };
+
+    std::deque<Segment> segments_; // Recent decoder-to-capture mappings.
+    int64_t lastTimedEnd_ = 0;      // Decoder-timeline end of the last taken vowel.
+
+    static constexpr size_t MAX_SEGMENTS = 256;      // Decoded blocks remembered for timing lookups.
+    static constexpr int64_t TIMING_TOLERANCE = 160; // Samples (10 ms) a revised partial word may move back.
+};
+
+#endif  // DECODER_TIMELINE_H
@@ -0,0 +1,48 @@
+#include "recognizer_pool.h"
+#include <utility>
+
+RecognizerPool::RecognizerPool(std::shared_ptr<VoskModel> model, SpeechRecognizer::Mode mode, size_t maxIdle)
+    : model_(std::move(model)), mode_(mode), maxIdle_(maxIdle), created_(0) {
+}
+
+std::unique_ptr<SpeechRecognizer> RecognizerPool::acquire() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!idle_.empty()) {
+            std::unique_ptr<SpeechRecognizer> recognizer = std::move(idle_.back());
+            idle_.pop_back();
+            return recognizer;
+        }
+        if (!model_) {
+            return nullptr;
+        }
+        created_++;
+    }
+
+    // Build the new recognizer outside the lock, it takes a while
+    auto recognizer = std::make_unique<SpeechRecognizer>(model_, mode_);
+    if (!recognizer->isValid()) {
+        return nullptr;
+    }
+    recognizer->setWordTimes(true);
+    return recognizer;
+}
+
+void RecognizerPool::release(std::unique_ptr<SpeechRecognizer> recognizer) {
+    if (!recognizer) {
+        return;
+    }
+
+    // The next stream must not continue the previous stream's utterance
+    recognizer->reset();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (idle_.size() < maxIdle_) {
+        idle_.push_back(std::move(recognizer));
+    }
+}
+
+size_t RecognizerPool::createdCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return created_;
+}
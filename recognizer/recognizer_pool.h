@@ -0,0 +1,45 @@
+#ifndef RECOGNIZER_POOL_H
+#define RECOGNIZER_POOL_H
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "vosk_recognizer.h"
+
+// The RecognizerPool class hands out SpeechRecognizers that all share one
+// loaded VoskModel. Creating a recognizer builds Vosk's decoding graph state,
+// which is slow, so recognizers of finished streams are reset and kept for
+// the next stream instead of being destroyed.
+class RecognizerPool {
+public:
+    // Parameters:
+    // - model: The shared model; recognizers cannot be created if it is null.
+    // - mode: Decoding mode of every recognizer.
+    // - maxIdle: Released recognizers kept for reuse; extras are destroyed.
+    RecognizerPool(std::shared_ptr<VoskModel> model, SpeechRecognizer::Mode mode, size_t maxIdle = 16);
+
+    // Returns a recognizer with word timestamps enabled, reusing an idle one
+    // if possible. Returns nullptr if no model is loaded or creation failed.
+    std::unique_ptr<SpeechRecognizer> acquire();
+
+    // Takes a recognizer back for reuse.
+    void release(std::unique_ptr<SpeechRecognizer> recognizer);
+
+    // Checks whether the pool has a model to create recognizers from.
+    bool hasModel() const { return model_ != nullptr; }
+
+    // Number of recognizers created so far (not counting reuses).
+    size_t createdCount() const;
+
+private:
+    std::shared_ptr<VoskModel> model_;       // Model shared by every recognizer.
+    SpeechRecognizer::Mode mode_;            // Decoding mode.
+    size_t maxIdle_;                         // Idle recognizers kept.
+
+    mutable std::mutex mutex_;               // Protects idle_ and created_.
+    std::vector<std::unique_ptr<SpeechRecognizer>> idle_; // Reset recognizers ready for reuse.
+    size_t created_;                         // Recognizers created.
+};
+
+#endif  // RECOGNIZER_POOL_H
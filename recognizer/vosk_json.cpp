@@ -0,0 +1,276 @@
+#include "vosk_json.h"
+#include <charconv>
+#include <cstdint>
+
+namespace {
+
+// Forward-only reader over the JSON text.
+class JsonCursor {
+public:
+    explicit JsonCursor(std::string_view text) : text_(text), pos_(0) {}
+
+    void skipWhitespace() {
+        while (pos_ < text_.size() && (text_[pos_] == ' ' || text_[pos_] == '\n' ||
+                                       text_[pos_] == '\r' || text_[pos_] == '\t')) {
+            pos_++;
+        }
+    }
+
+    // Consumes c (after whitespace) if it is next.
+    bool consume(char c) {
+        skipWhitespace();
+        if (pos_ < text_.size() && text_[pos_] == c) {
+            pos_++;
+            return true;
+        }
+        return false;
+    }
+
+    char peek() {
+        skipWhitespace();
+        return pos_ < text_.size() ? text_[pos_] : '\0';
+    }
+
+    // Reads a string and returns a view of its raw contents.
+    bool readString(std::string_view& out, bool& hasEscapes) {
+        if (!consume('"')) {
+            return false;
+        }
+        size_t start = pos_;
+        hasEscapes = false;
+        while (pos_ < text_.size()) {
+            char c = text_[pos_];
+            if (c == '\\') {
+                hasEscapes = true;
+                pos_ += 2; // Skip the escaped character; \uXXXX digits are plain characters
+                continue;
+            }
+            if (c == '"') {
+                out = text_.substr(start, pos_ - start);
+                pos_++;
+                return true;
+            }
+            pos_++;
+        }
+        return false;
+    }
+
+    bool readNumber(double& out) {
+        skipWhitespace();
+        const char* first = text_.data() + pos_;
+        const char* last = text_.data() + text_.size();
+        auto parsed = std::from_chars(first, last, out);
+        if (parsed.ec != std::errc()) {
+            return false;
+        }
+        pos_ += parsed.ptr - first;
+        return true;
+    }
+
+    // Skips any value, nested containers included.
+    bool skipValue(int depth = 0) {
+        if (depth > MAX_DEPTH) {
+            return false;
+        }
+        char c = peek();
+        if (c == '"') {
+            std::string_view ignored;
+            bool escapes;
+            return readString(ignored, escapes);
+        }
+        if (c == '{' || c == '[') {
+            char close = c == '{' ? '}' : ']';
+            pos_++;
+            if (consume(close)) {
+                return true;
+            }
+            do {
+                if (c == '{') {
+                    std::string_view key;
+                    bool escapes;
+                    if (!readString(key, escapes) || !consume(':')) {
+                        return false;
+                    }
+                }
+                if (!skipValue(depth + 1)) {
+                    return false;
+                }
+            } while (consume(','));
+            return consume(close);
+        }
+        if (c == '-' || (c >= '0' && c <= '9')) {
+            double ignored;
+            return readNumber(ignored);
+        }
+        // true, false, null
+        size_t start = pos_;
+        while (pos_ < text_.size() && text_[pos_] >= 'a' && text_[pos_] <= 'z') {
+            pos_++;
+        }
+        return pos_ > start;
+    }
+
+private:
+    std::string_view text_;
+    size_t pos_;
+
+    static constexpr int MAX_DEPTH = 16;
+};
+
+// Parses one {"conf": .., "end": .., "start": .., "word": ".."} object.
+bool readWord(JsonCursor& cursor, VoskJsonWord& word) {
+    if (!cursor.consume('{')) {
+        return false;
+    }
+    if (cursor.consume('}')) {
+        return true;
+    }
+    do {
+        std::string_view key;
+        bool escapes;
+        if (!cursor.readString(key, escapes) || !cursor.consume(':')) {
+            return false;
+        }
+        bool ok;
+        if (key == "word") {
+            ok = cursor.readString(word.word, word.hasEscapes);
+        } else if (key == "start") {
+            ok = cursor.readNumber(word.start);
+        } else if (key == "end") {
+            ok = cursor.readNumber(word.end);
+        } else if (key == "conf") {
+            ok = cursor.readNumber(word.confidence);
+        } else {
+            ok = cursor.skipValue();
+        }
+        if (!ok) {
+            return false;
+        }
+    } while (cursor.consume(','));
+    return cursor.consume('}');
+}
+
+// Parses a word array, storing up to maxWords entries.
+bool readWords(JsonCursor& cursor, VoskJsonResult& result, VoskJsonWord* words, size_t maxWords) {
+    if (!cursor.consume('[')) {
+        return false;
+    }
+    if (cursor.consume(']')) {
+        return true;
+    }
+    do {
+        VoskJsonWord word;
+        if (!readWord(cursor, word)) {
+            return false;
+        }
+        if (result.wordCount < maxWords) {
+            words[result.wordCount++] = word;
+        }
+        result.totalWords++;
+    } while (cursor.consume(','));
+    return cursor.consume(']');
+}
+
+// Appends a code point as UTF-8.
+void appendUtf8(uint32_t codePoint, std::string& out) {
+    if (codePoint < 0x80) {
+        out += static_cast<char>(codePoint);
+    } else if (codePoint < 0x800) {
+        out += static_cast<char>(0xC0 | (codePoint >> 6));
+        out += static_cast<char>(0x80 | (codePoint & 0x3F));
+    } else if (codePoint < 0x10000) {
+        out += static_cast<char>(0xE0 | (codePoint >> 12));
+        out += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (codePoint & 0x3F));
+    } else {
+        out += static_cast<char>(0xF0 | (codePoint >> 18));
+        out += static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F));
+        out += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (codePoint & 0x3F));
+    }
+}
+
+} // namespace
+
+bool parseVoskJson(std::string_view json, VoskJsonResult& result, VoskJsonWord* words, size_t maxWords) {
+    result = VoskJsonResult();
+    if (!words) {
+        maxWords = 0;
+    }
+
+    JsonCursor cursor(json);
+    if (!cursor.consume('{')) {
+        return false;
+    }
+    if (cursor.consume('}')) {
+        return true;
+    }
+
+    do {
+        std::string_view key;
+        bool escapes;
+        if (!cursor.readString(key, escapes) || !cursor.consume(':')) {
+            return false;
+        }
+
+        bool ok;
+        if (key == "text") {
+            ok = cursor.readString(result.text, result.hasEscapes);
+            result.isPartial = false;
+        } else if (key == "partial") {
+            ok = cursor.readString(result.text, result.hasEscapes);
+            result.isPartial = true;
+        } else if (key == "result" || key == "partial_result") {
+            ok = readWords(cursor, result, words, maxWords);
+        } else {
+            ok = cursor.skipValue(); // "alternatives", "spk", ...
+        }
+        if (!ok) {
+            return false;
+        }
+    } while (cursor.consume(','));
+
+    return cursor.consume('}');
+}
+
+void unescapeJsonString(std::string_view raw, std::string& out) {
+    out.clear();
+    out.reserve(raw.size());
+
+    for (size_t i = 0; i < raw.size(); i++) {
+        char c = raw[i];
+        if (c != '\\' || i + 1 >= raw.size()) {
+            out += c;
+            continue;
+        }
+
+        char escaped = raw[++i];
+        switch (escaped) {
+            case 'n': out += '\n'; break;
+            case 't': out += '\t'; break;
+            case 'r': out += '\r'; break;
+            case 'b': out += '\b'; break;
+            case 'f': out += '\f'; break;
+            case 'u': {
+                uint32_t codePoint = 0;
+                if (i + 4 < raw.size() &&
+                    std::from_chars(raw.data() + i + 1, raw.data() + i + 5, codePoint, 16).ec == std::errc()) {
+                    i += 4;
+                    // Combine a UTF-16 surrogate pair
+                    if (codePoint >= 0xD800 && codePoint < 0xDC00 && i + 6 < raw.size() &&
+                        raw[i + 1] == '\\' && raw[i + 2] == 'u') {
+                        uint32_t low = 0;
+                        if (std::from_chars(raw.data() + i + 3, raw.data() + i + 7, low, 16).ec == std::errc() &&
+                            low >= 0xDC00 && low < 0xE000) {
+                            codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (low - 0xDC00);
+                            i += 6;
+                        }
+                    }
+                    appendUtf8(codePoint, out);
+                }
+                break;
+            }
+            default: out += escaped; break; // \" \\ \/
+        }
+    }
+}
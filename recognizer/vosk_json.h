@@ -0,0 +1,42 @@
+#ifndef VOSK_JSON_H
+#define VOSK_JSON_H
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+// One entry of a Vosk "result" or "partial_result" word array. The word is a
+// view into the JSON text and is only valid while that text is.
+struct VoskJsonWord {
+    std::string_view word;   // Raw JSON string contents (still escaped, see hasEscapes).
+    double start = 0.0;      // Start time in seconds.
+    double end = 0.0;        // End time in seconds.
+    double confidence = 1.0; // Word confidence; partial results carry none.
+    bool hasEscapes = false; // True if word contains backslash escapes.
+};
+
+// Fields pulled out of one Vosk JSON result. Views point into the JSON text.
+struct VoskJsonResult {
+    std::string_view text;   // "text" of a final result or "partial" of a partial one.
+    bool isPartial = false;  // True if the text came from a "partial" field.
+    bool hasEscapes = false; // True if text contains backslash escapes.
+    size_t wordCount = 0;    // Words stored in the caller's array.
+    size_t totalWords = 0;   // Words present in the JSON (may exceed wordCount).
+};
+
+// Parses a Vosk result without allocating: a single forward pass over the
+// text that records views of the interesting fields and skips everything
+// else. Words beyond maxWords are counted but not stored.
+// Parameters:
+// - json: The JSON text returned by vosk_recognizer_result/partial_result.
+// - result: Receives the text field and word counts.
+// - words: Array receiving up to maxWords words (may be null if maxWords is 0).
+// - maxWords: Capacity of the words array.
+// Returns:
+// - true if the text was a well-formed JSON object, false otherwise.
+bool parseVoskJson(std::string_view json, VoskJsonResult& result, VoskJsonWord* words, size_t maxWords);
+
+// Decodes the escapes of a raw JSON string into out (\uXXXX included).
+void unescapeJsonString(std::string_view raw, std::string& out);
+
+#endif  // VOSK_JSON_H
@@ -1,46 +1,70 @@
 #include "vosk_recognizer.h"
-#include <iostream>
 #include <algorithm>
 #include <cctype>
 #include <chrono>
 #include <queue>
+#include <utility>
 #include <vector>
-SpeechRecognizer::SpeechRecognizer(const std::string& modelPath)
-    : model_(nullptr), recognizer_(nullptr), valid_(false) {
-    
-    // Set the logging level for Vosk (0 = minimal logs)
-    vosk_set_log_level(-1);
-    
-    // Load the model from the specified path
-    model_ = vosk_model_new(modelPath.c_str());
+#include "../logging/logger.h"
+// Vowels on their own, open syllables and short interjections. Everything
+// else is absorbed by [unk], so the decoder only has to choose between a few
+// dozen words instead of the whole lexicon.
+const char* SpeechRecognizer::VOWEL_GRAMMAR =
+    "[\"а\", \"о\", \"у\", \"и\", \"э\", \"ы\", \"я\", \"е\", \"ё\", \"ю\","
+    " \"да\", \"не\", \"но\", \"ну\", \"на\", \"мы\", \"ты\", \"он\", \"она\", \"они\","
+    " \"ах\", \"ох\", \"ух\", \"эх\", \"ай\", \"ой\", \"эй\", \"ага\", \"угу\", \"ура\","
+    " \"мама\", \"папа\", \"нет\", \"привет\", \"пока\", \"[unk]\"]";
+
+SpeechRecognizer::SpeechRecognizer(const std::string& modelPath, Mode mode)
+    : SpeechRecognizer(loadModel(modelPath), mode) {
+}
+
+SpeechRecognizer::SpeechRecognizer(std::shared_ptr<VoskModel> model, Mode mode)
+    : model_(std::move(model)), recognizer_(nullptr), valid_(false), mode_(mode), wordTimes_(false),
+      acceptedSamples_(0), jsonWords_(MAX_WORDS) {
+    words_.reserve(MAX_WORDS);
+    text_.reserve(TEXT_CAPACITY);
+
     if (!model_) {
-        std::cerr << "Failed to load model Vosk from:" << modelPath << std::endl;
-        std::cerr << "Make sure the model folder exists and contains the necessary files." << std::endl;
         return;
     }
 
-    // Create the recognizer instance
-    recognizer_ = vosk_recognizer_new(model_, SAMPLE_RATE);
+    // Create the recognizer instance, restricted to the vowel grammar if requested
+    if (mode_ == Mode::VowelGrammar) {
+        recognizer_ = vosk_recognizer_new_grm(model_.get(), SAMPLE_RATE, VOWEL_GRAMMAR);
+    } else {
+        recognizer_ = vosk_recognizer_new(model_.get(), SAMPLE_RATE);
+    }
     if (!recognizer_) {
-        std::cerr << "Failed to create Vosk recognizer" << std::endl;
-        vosk_model_free(model_);
-        model_ = nullptr;
+        LOG_ERROR("Failed to create Vosk recognizer");
+        model_.reset();
         return;
     }
 
     valid_ = true;
-    std::cout << "Vosk Recognizer initialized successfully" << std::endl;
+    LOG_INFO("Vosk Recognizer initialized successfully" << (mode_ == Mode::VowelGrammar ? " (vowel grammar)" : ""));
+}
+
+std::shared_ptr<VoskModel> SpeechRecognizer::loadModel(const std::string& modelPath) {
+    // Set the logging level for Vosk (0 = minimal logs)
+    vosk_set_log_level(-1);
+
+    // Load the model from the specified path
+    VoskModel* model = vosk_model_new(modelPath.c_str());
+    if (!model) {
+        LOG_ERROR("Failed to load model Vosk from:" << modelPath);
+        LOG_ERROR("Make sure the model folder exists and contains the necessary files.");
+        return nullptr;
+    }
+    return std::shared_ptr<VoskModel>(model, vosk_model_free);
 }
 
 SpeechRecognizer::~SpeechRecognizer() {
-    // Free the recognizer instance if it exists
+    // Free the recognizer instance if it exists; the model is freed by the
+    // last recognizer holding it
     if (recognizer_) {
         vosk_recognizer_free(recognizer_);
     }
-    // Free the model instance if it exists
-    if (model_) {
-        vosk_model_free(model_);
-    }
 }
 
 bool SpeechRecognizer::isValid() const {
@@ -48,17 +72,42 @@ bool SpeechRecognizer::isValid() const {
     return valid_;
 }
 
+SpeechRecognizer::Mode SpeechRecognizer::mode() const {
+    return mode_;
+}
+
 void SpeechRecognizer::reset() {
     // Reset the recognizer to prepare it for new audio input
+    // Vosk keeps counting samples across a reset, so word times stay on the
+    // same scale as acceptedSamples_
     if (recognizer_) {
         vosk_recognizer_reset(recognizer_);
     }
 }
 
-std::string SpeechRecognizer::recognize(const short* audio, int audioSize) {
+void SpeechRecognizer::setWordTimes(bool enabled) {
+    wordTimes_ = enabled;
+    words_.clear();
+    if (recognizer_) {
+        vosk_recognizer_set_words(recognizer_, enabled ? 1 : 0);
+        vosk_recognizer_set_partial_words(recognizer_, enabled ? 1 : 0);
+    }
+}
+
+const std::vector<WordTiming>& SpeechRecognizer::lastWords() const {
+    return words_;
+}
+
+int64_t SpeechRecognizer::decodedSamples() const {
+    return acceptedSamples_;
+}
+
+const std::string& SpeechRecognizer::recognize(const short* audio, int audioSize) {
+    text_.clear();
+    words_.clear();
     if (!valid_ || !recognizer_) {
-        std::cout << "Recognizer not valid!" << std::endl;
-        return "";
+        LOG_WARN("Recognizer not valid!");
+        return text_;
     }
 
     // Convert the size from the number of samples to the number of bytes
@@ -68,131 +117,136 @@ std::string SpeechRecognizer::recognize(const short* audio, int audioSize) {
     int result = vosk_recognizer_accept_waveform(recognizer_, 
                                                reinterpret_cast<const char*>(audio), 
                                                audioBytes);
-
-    std::string recognizedText;
+    acceptedSamples_ += audioSize;
 
     if (result) {
         // Final result - reset the recognizer for new recognition
         const char* jsonResult = vosk_recognizer_result(recognizer_);
-        recognizedText = parseJsonResult(jsonResult);
-        if (!recognizedText.empty()) {
-            std::cout << "Vosk final result: " << recognizedText << std::endl;
+        parseJsonResult(jsonResult);
+        if (!text_.empty()) {
+            LOG_DEBUG("Vosk final result: " << text_);
             // Reset the recognizer to start new recognition
             vosk_recognizer_reset(recognizer_);
         }
     } else {
         // Partial result - process it only
         const char* jsonPartial = vosk_recognizer_partial_result(recognizer_);
-        recognizedText = parseJsonResult(jsonPartial);
-        if (!recognizedText.empty()) {
-            std::cout << "Vosk partial result: " << recognizedText << std::endl;
+        parseJsonResult(jsonPartial);
+        if (!text_.empty()) {
+            LOG_DEBUG("Vosk partial result: " << text_);
         }
     }
 
-    return recognizedText;
+    return text_;
 }
 
-std::string SpeechRecognizer::parseJsonResult(const char* jsonResult) {
+void SpeechRecognizer::parseJsonResult(const char* jsonResult) {
     if (!jsonResult) {
-        return "";
+        return;
     }
-    
-    std::string json(jsonResult);
-    
-    // Simple JSON parsing to extract the "text" field
-    // Look for the "text": "..." field
-    size_t textPos = json.find("\"text\"");
-    if (textPos == std::string::npos) {
-        return "";
+
+    // Single allocation-free pass; the text and words are views into jsonResult
+    VoskJsonResult parsed;
+    if (!parseVoskJson(jsonResult, parsed, jsonWords_.data(), jsonWords_.size())) {
+        return;
     }
-    
-    size_t colonPos = json.find(":", textPos);
-    if (colonPos == std::string::npos) {
-        return "";
+
+    if (wordTimes_) {
+        for (size_t i = 0; i < parsed.wordCount; i++) {
+            const VoskJsonWord& word = jsonWords_[i];
+            words_.push_back({word.word, word.start, word.end, word.confidence});
+        }
     }
-    
-    size_t startQuote = json.find("\"", colonPos);
-    if (startQuote == std::string::npos) {
-        return "";
+
+    // text_ keeps its capacity, so only a text longer than any before allocates
+    if (parsed.hasEscapes) {
+        unescapeJsonString(parsed.text, text_);
+    } else {
+        text_.assign(parsed.text.data(), parsed.text.size());
     }
-    startQuote++; // Skip the opening quote
-    
-    size_t endQuote = json.find("\"", startQuote);
-    if (endQuote == std::string::npos) {
-        return "";
+}
+
+std::vector<TimedVowel> SpeechRecognizer::extractTimedVowels() {
+    std::vector<TimedVowel> timed;
+
+    for (const auto& word : words_) {
+        std::vector<Vowel> vowels = extractVowels(word.word);
+        if (vowels.empty()) {
+            continue;
+        }
+
+        // Vosk times count from the recognizer's creation, like acceptedSamples_.
+        // Spread the word's vowels evenly over its duration
+        int64_t wordStart = static_cast<int64_t>(word.start * SAMPLE_RATE);
+        int64_t wordEnd = static_cast<int64_t>(word.end * SAMPLE_RATE);
+        double step = static_cast<double>(wordEnd - wordStart) / vowels.size();
+        for (size_t i = 0; i < vowels.size(); i++) {
+            TimedVowel vowel;
+            vowel.vowel = vowels[i];
+            vowel.startSample = wordStart + static_cast<int64_t>(step * i);
+            vowel.endSample = wordStart + static_cast<int64_t>(step * (i + 1));
+            timed.push_back(vowel);
+        }
+    }
+
+    return timed;
+}
+
+// Maps a code point to a vowel. Russian vowels in both cases, and Latin
+// vowels to the closest Russian one.
+static Vowel vowelFromCodePoint(uint32_t codePoint) {
+    switch (codePoint) {
+        case 0x0430: case 0x0410: case 'a': case 'A': return Vowel::A;  // а
+        case 0x044F: case 0x042F: return Vowel::Ya;                     // я
+        case 0x044D: case 0x042D: case 'e': case 'E': return Vowel::E;  // э
+        case 0x0435: case 0x0415: return Vowel::Ye;                     // е
+        case 0x0438: case 0x0418: case 'i': case 'I': return Vowel::I;  // и
+        case 0x044B: case 0x042B: case 'y': case 'Y': return Vowel::Y;  // ы
+        case 0x043E: case 0x041E: case 'o': case 'O': return Vowel::O;  // о
+        case 0x0451: case 0x0401: return Vowel::Yo;                     // ё
+        case 0x0443: case 0x0423: case 'u': case 'U': return Vowel::U;  // у
+        case 0x044E: case 0x042E: return Vowel::Yu;                     // ю
+        default: return Vowel::None;
     }
-    
-    return json.substr(startQuote, endQuote - startQuote);
 }
 
-std::vector<std::string> SpeechRecognizer::extractVowels(const std::string& text) {
-    std::cout << "Extracting vowels from: '" << text << "'" << std::endl;
+std::vector<Vowel> SpeechRecognizer::extractVowels(std::string_view text) {
+    LOG_DEBUG("Extracting vowels from: '" << text << "'");
     
-    std::vector<std::string> vowels;
+    std::vector<Vowel> vowels;
     
-    // Iterate through each character in the text
+    // Decode the UTF-8 text one code point at a time
     for (size_t i = 0; i < text.length(); i++) {
-        std::string currentChar;
+        unsigned char lead = static_cast<unsigned char>(text[i]);
+        uint32_t codePoint = lead;
         
-        // Handle UTF-8 characters (Russian letters occupy 2 bytes)
-        if ((unsigned char)text[i] >= 0xC0) {
-            if (i + 1 < text.length()) {
-                currentChar = text.substr(i, 2);
-                i++; // Skip the second byte of UTF-8
+        // Russian letters occupy 2 bytes; other multi-byte characters are skipped whole
+        if (lead >= 0xC0) {
+            size_t length = lead >= 0xF0 ? 4 : lead >= 0xE0 ? 3 : 2;
+            if (i + length > text.length()) {
+                break;
             }
-        } else {
-            currentChar = text[i];
+            codePoint = length == 2
+                ? ((lead & 0x1Fu) << 6) | (static_cast<unsigned char>(text[i + 1]) & 0x3Fu)
+                : 0;
+            i += length - 1;
         }
         
-        // Check for vowels in both Russian and English alphabets
-        if (currentChar == "а" || currentChar == "А") {
-            vowels.push_back("а");
-        } else if (currentChar == "я" || currentChar == "Я") {
-            vowels.push_back("я");
-        } else if (currentChar == "э" || currentChar == "Э") {
-            vowels.push_back("э");
-        } else if (currentChar == "е" || currentChar == "Е") {
-            vowels.push_back("е");
-        } else if (currentChar == "и" || currentChar == "И") {
-            vowels.push_back("и");
-        } else if (currentChar == "ы" || currentChar == "Ы") {
-            vowels.push_back("ы");
-        } else if (currentChar == "о" || currentChar == "О") {
-            vowels.push_back("о");
-        } else if (currentChar == "ё" || currentChar == "Ё") {
-            vowels.push_back("ё");
-        } else if (currentChar == "у" || currentChar == "У") {
-            vowels.push_back("у");
-        } else if (currentChar == "ю" || currentChar == "Ю") {
-            vowels.push_back("ю");
-        } else if (currentChar == "a" || currentChar == "A") {
-            vowels.push_back("а");
-        } else if (currentChar == "e" || currentChar == "E") {
-            vowels.push_back("э");
-        } else if (currentChar == "i" || currentChar == "I") {
-            vowels.push_back("и");
-        } else if (currentChar == "o" || currentChar == "O") {
-            vowels.push_back("о");
-        } else if (currentChar == "u" || currentChar == "U") {
-            vowels.push_back("у");
-        } else if (currentChar == "y" || currentChar == "Y") {
-            vowels.push_back("ы");
+        Vowel vowel = vowelFromCodePoint(codePoint);
+        if (vowel != Vowel::None) {
+            vowels.push_back(vowel);
         }
     }
     
     if (!vowels.empty()) {
-        std::cout << "Found vowels: ";
-        for (const auto& vowel : vowels) {
-            std::cout << vowel << " ";
-        }
-        std::cout << std::endl;
+        LOG_DEBUG("Found vowels: " << vowelNames(vowels));
     }
     
     return vowels;
 }
 
-std::vector<std::string> SpeechRecognizer::extractNewVowels(const std::string& newText, const std::string& previousText) {
-    std::cout << "Current text: '" << newText << "'" << std::endl;
+std::vector<Vowel> SpeechRecognizer::extractNewVowels(std::string_view newText, std::string_view previousText) {
+    LOG_DEBUG("Current text: '" << newText << "'");
     
     // If the text is empty, return nothing
     if (newText.empty()) {
@@ -201,22 +255,20 @@ std::vector<std::string> SpeechRecognizer::extractNewVowels(const std::string& n
     
     // If the new text is shorter than the previous one or completely different,
     // it means a new recognition session has started - extract all vowels
+    size_t common = std::min(newText.length(), previousText.length());
     if (newText.length() < previousText.length() || 
         previousText.empty() || 
-        newText.substr(0, std::min(newText.length(), previousText.length())) != 
-        previousText.substr(0, std::min(newText.length(), previousText.length()))) {
+        newText.substr(0, common) != previousText.substr(0, common)) {
         
-        std::cout << "New recognition started" << std::endl;
+        LOG_DEBUG("New recognition started");
         return extractVowels(newText);
     }
     
     // If the new text is longer and starts with the previous one,
     // extract vowels only from the new part
-    if (newText.length() > previousText.length() && 
-        newText.substr(0, previousText.length()) == previousText) {
-        
-        std::string newPart = newText.substr(previousText.length());
-        std::cout << "New part: '" << newPart << "'" << std::endl;
+    if (newText.length() > previousText.length()) {
+        std::string_view newPart = newText.substr(previousText.length());
+        LOG_DEBUG("New part: '" << newPart << "'");
         return extractVowels(newPart);
     }
     
@@ -3,9 +3,32 @@
 
 #include <vosk_api.h>
 #include <string>
+#include <string_view>
 #include <queue>
 #include <chrono>
 #include <vector>
+#include <cstdint>
+#include <memory>
+#include "vosk_json.h"
+#include "../audio/vowel.h"
+
+// Timing of one recognized word as reported by Vosk, in seconds from the
+// recognizer's creation; reset() does not rewind that clock, so the times
+// are on the same scale as decodedSamples(). The word points into Vosk's
+// result buffer.
+struct WordTiming {
+    std::string_view word; // The recognized word (valid until the next recognize() call).
+    double start;      // Start time in seconds.
+    double end;        // End time in seconds.
+    double confidence; // Word confidence (1.0 for partial results, which carry none).
+};
+
+// A vowel placed on the decoder's sample timeline.
+struct TimedVowel {
+    Vowel vowel;         // The vowel.
+    int64_t startSample; // First sample of the vowel.
+    int64_t endSample;   // Sample just past the end of the vowel.
+};
 
 // The SpeechRecognizer class provides an interface for speech recognition
 // using the Vosk API. It allows initializing a speech recognition model,
@@ -13,12 +36,30 @@
 // information such as vowels from the recognized text.
 class SpeechRecognizer {
 public:
+    // Decoding modes selectable at construction.
+    enum class Mode {
+        FullVocabulary, // Open-vocabulary decoding with the model's whole lexicon.
+        VowelGrammar    // Decoding restricted to vowel syllables and short common words.
+    };
+
     // Constructor: Initializes the SpeechRecognizer with the specified model path.
     // The model path should point to a valid Vosk speech recognition model.
-    SpeechRecognizer(const std::string& modelPath);
+    // VowelGrammar mode needs a model that supports runtime grammars (the small
+    // models do); the search space is much smaller, so decoding is faster.
+    SpeechRecognizer(const std::string& modelPath, Mode mode = Mode::FullVocabulary);
+
+    // Constructor: Creates a recognizer on a model that is already loaded, so
+    // many recognizers (one per stream) can share one copy of the model.
+    // Vosk allows recognizers on the same model to run on different threads.
+    SpeechRecognizer(std::shared_ptr<VoskModel> model, Mode mode = Mode::FullVocabulary);
+
+    // Loads a Vosk model for sharing between recognizers.
+    // Returns:
+    // - The model, or nullptr if it could not be loaded (the reason is logged).
+    static std::shared_ptr<VoskModel> loadModel(const std::string& modelPath);
 
     // Destructor: Cleans up resources used by the SpeechRecognizer, including
-    // the Vosk model and recognizer instances.
+    // the Vosk recognizer and the model once no other recognizer shares it.
     ~SpeechRecognizer();
 
     // Processes the given audio data and returns the recognized text as a string.
@@ -26,8 +67,30 @@ public:
     // - audio: Pointer to the audio data (16-bit PCM samples).
     // - audioSize: Number of samples in the audio data.
     // Returns:
-    // - A string containing the recognized text.
-    std::string recognize(const short* audio, int audioSize);
+    // - The recognized text, held by the recognizer and overwritten by the
+    //   next call. The buffer is reused, so decoding does not allocate per block.
+    const std::string& recognize(const short* audio, int audioSize);
+
+    // Returns the mode the recognizer was created with.
+    Mode mode() const;
+
+    // Enables or disables word timestamps in Vosk results. When enabled,
+    // lastWords() holds the words of the most recent result.
+    void setWordTimes(bool enabled);
+
+    // Words, with timing, of the result returned by the last recognize() call.
+    // The words are views into Vosk's result and are valid until the next call.
+    const std::vector<WordTiming>& lastWords() const;
+
+    // Total number of samples fed to the decoder since construction.
+    int64_t decodedSamples() const;
+
+    // Places the vowels of lastWords() on the decoder's sample timeline.
+    // Each word's vowels share the word's duration evenly.
+    // Returns:
+    // - A vector of vowels with start and end positions in decoder samples
+    //   (the same scale as decodedSamples()).
+    std::vector<TimedVowel> extractTimedVowels();
 
     // Checks if the SpeechRecognizer is in a valid state.
     // Returns:
@@ -35,27 +98,28 @@ public:
     bool isValid() const;
 
     // Resets the internal state of the recognizer, clearing any ongoing recognition
-    // process and preparing it for new input.
+    // process and preparing it for new input. Word times and decodedSamples()
+    // keep counting from construction.
     void reset();
 
     // Extracts all vowels from the given text.
     // Parameters:
     // - text: The input text from which vowels will be extracted.
     // Returns:
-    // - A vector of strings, each containing a vowel found in the text.
-    std::vector<std::string> extractVowels(const std::string& text);
+    // - The vowels found in the text, in order.
+    std::vector<Vowel> extractVowels(std::string_view text);
 
     // Extracts vowels that are present in the new text but not in the previous text.
     // Parameters:
     // - newText: The new text to analyze.
     // - previousText: The previous text to compare against.
     // Returns:
-    // - A vector of strings containing the new vowels found in the new text.
-    std::vector<std::string> extractNewVowels(const std::string& newText, const std::string& previousText);
+    // - The vowels found in the part of newText that previousText does not cover.
+    std::vector<Vowel> extractNewVowels(std::string_view newText, std::string_view previousText);
 
 private:
-    // Pointer to the Vosk model instance used for speech recognition.
-    VoskModel* model_;
+    // Vosk model used for speech recognition, possibly shared with other recognizers.
+    std::shared_ptr<VoskModel> model_;
 
     // Pointer to the Vosk recognizer instance used for processing audio data.
     VoskRecognizer* recognizer_;
@@ -63,16 +127,43 @@ private:
     // Indicates whether the recognizer is in a valid state.
     bool valid_;
 
-    // Parses the JSON result returned by the Vosk recognizer and extracts
-    // the recognized text.
+    // Decoding mode selected at construction.
+    Mode mode_;
+
+    // Indicates whether Vosk reports word timestamps.
+    bool wordTimes_;
+
+    // Words of the last result, filled when word timestamps are enabled.
+    std::vector<WordTiming> words_;
+
+    // Samples fed to the decoder since construction.
+    int64_t acceptedSamples_;
+
+    // Scratch array the JSON parser stores words in, allocated once.
+    std::vector<VoskJsonWord> jsonWords_;
+
+    // Text of the last result, returned by recognize(); reserved once and reused.
+    std::string text_;
+
+    // Parses the JSON result returned by the Vosk recognizer and stores the
+    // recognized text ("text" of a final result, "partial" of a partial one)
+    // in text_, which the caller has cleared. When word timestamps are enabled
+    // the word array is collected into words_.
     // Parameters:
     // - jsonResult: The JSON string returned by the recognizer.
-    // Returns:
-    // - A string containing the recognized text extracted from the JSON.
-    std::string parseJsonResult(const char* jsonResult);
+    void parseJsonResult(const char* jsonResult);
+
+    // JSON word list used in VowelGrammar mode.
+    static const char* VOWEL_GRAMMAR;
 
     // The sample rate used for audio processing (16 kHz).
     static constexpr int SAMPLE_RATE = 16000;
+
+    // Words kept per result; longer results are truncated.
+    static constexpr size_t MAX_WORDS = 64;
+
+    // Bytes reserved for the result text; a longer text grows the buffer once.
+    static constexpr size_t TEXT_CAPACITY = 1024;
 };
 
 #endif  // VOSK_RECOGNIZER_H
\ No newline at end of file
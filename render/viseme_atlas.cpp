@@ -0,0 +1,145 @@
+#include "viseme_atlas.h"
+#include <SDL2/SDL_image.h>
+#include <algorithm>
+#include <cmath>
+#include "../logging/logger.h"
+
+namespace {
+
+// File name of every shape in an image directory, indexed by VisemeGroup
+constexpr const char* DIRECTORY_FILES[VISEME_GROUP_COUNT] = {
+    "7.png", "1.png", "2.png", "3.png", "4.png", "5.png", "6.png"
+};
+
+bool parseVisemeGroup(const std::string& text, VisemeGroup& group) {
+    for (size_t g = 0; g < VISEME_GROUP_COUNT; g++) {
+        if (text == VISEME_GROUP_IDS[g]) {
+            group = static_cast<VisemeGroup>(g);
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace
+
+VisemeImagePaths visemeImagesInDirectory(const std::string& directory) {
+    VisemeImagePaths paths;
+    for (size_t g = 0; g < VISEME_GROUP_COUNT; g++) {
+        paths.files[g] = directory + "/" + DIRECTORY_FILES[g];
+    }
+    return paths;
+}
+
+bool parseVisemeImageOption(int argc, char* argv[], int& i, VisemeImagePaths& paths) {
+    std::string arg = argv[i];
+    if (arg == "--images" && i + 1 < argc) {
+        paths = visemeImagesInDirectory(argv[++i]);
+    } else if (arg == "--viseme-image" && i + 2 < argc) {
+        VisemeGroup group;
+        if (parseVisemeGroup(argv[i + 1], group)) {
+            paths.files[static_cast<size_t>(group)] = argv[i + 2];
+        } else {
+            LOG_WARN("Unknown viseme group '" << argv[i + 1] << "', ignoring its image");
+        }
+        i += 2;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+VisemeAtlas::VisemeAtlas() : surface_(nullptr), texture_(nullptr), rects_() {
+}
+
+VisemeAtlas::~VisemeAtlas() {
+    if (loader_.joinable()) {
+        loader_.join();
+    }
+    if (surface_) {
+        SDL_FreeSurface(surface_);
+    }
+    if (texture_) {
+        SDL_DestroyTexture(texture_);
+    }
+}
+
+void VisemeAtlas::startLoading(const VisemeImagePaths& paths) {
+    if (loader_.joinable()) {
+        return;
+    }
+    loader_ = std::thread(&VisemeAtlas::load, this, paths);
+}
+
+void VisemeAtlas::load(VisemeImagePaths paths) {
+    // Decode every image and convert it to the atlas format
+    SDL_Surface* images[VISEME_GROUP_COUNT] = {};
+    int cellWidth = 0;
+    int cellHeight = 0;
+    for (size_t g = 0; g < VISEME_GROUP_COUNT && error_.empty(); g++) {
+        SDL_Surface* decoded = IMG_Load(paths.files[g].c_str());
+        if (!decoded) {
+            error_ = "Failed to load " + paths.files[g] + ": " + IMG_GetError();
+            break;
+        }
+        images[g] = SDL_ConvertSurfaceFormat(decoded, SDL_PIXELFORMAT_RGBA32, 0);
+        SDL_FreeSurface(decoded);
+        if (!images[g]) {
+            error_ = "Failed to convert " + paths.files[g] + ": " + SDL_GetError();
+            break;
+        }
+        cellWidth = std::max(cellWidth, images[g]->w);
+        cellHeight = std::max(cellHeight, images[g]->h);
+    }
+
+    // Pack them into a near-square grid, which keeps the texture within
+    // the size limits of small GPUs
+    if (error_.empty()) {
+        int columns = static_cast<int>(std::ceil(std::sqrt(static_cast<double>(VISEME_GROUP_COUNT))));
+        int rows = (static_cast<int>(VISEME_GROUP_COUNT) + columns - 1) / columns;
+        surface_ = SDL_CreateRGBSurfaceWithFormat(0, columns * cellWidth, rows * cellHeight, 32, SDL_PIXELFORMAT_RGBA32);
+        if (!surface_) {
+            error_ = std::string("Failed to create the atlas surface: ") + SDL_GetError();
+        }
+        for (size_t g = 0; g < VISEME_GROUP_COUNT && surface_; g++) {
+            int column = static_cast<int>(g) % columns;
+            int row = static_cast<int>(g) / columns;
+            rects_[g] = SDL_Rect{column * cellWidth, row * cellHeight, images[g]->w, images[g]->h};
+
+            // Copy the pixels as they are, alpha included
+            SDL_SetSurfaceBlendMode(images[g], SDL_BLENDMODE_NONE);
+            SDL_Rect destination = rects_[g];
+            SDL_BlitSurface(images[g], nullptr, surface_, &destination);
+        }
+    }
+
+    for (SDL_Surface* image : images) {
+        if (image) {
+            SDL_FreeSurface(image);
+        }
+    }
+}
+
+bool VisemeAtlas::finishLoading(SDL_Renderer* renderer) {
+    if (!loader_.joinable()) {
+        LOG_ERROR("Viseme images were never requested");
+        return false;
+    }
+    loader_.join();
+
+    if (!error_.empty()) {
+        LOG_ERROR(error_);
+        return false;
+    }
+
+    texture_ = SDL_CreateTextureFromSurface(renderer, surface_);
+    if (!texture_) {
+        LOG_ERROR("Failed to create the viseme atlas texture (" << surface_->w << "x" << surface_->h
+                  << "): " << SDL_GetError());
+        return false;
+    }
+    LOG_INFO("Viseme atlas loaded: " << surface_->w << "x" << surface_->h);
+    SDL_FreeSurface(surface_);
+    surface_ = nullptr;
+    return true;
+}
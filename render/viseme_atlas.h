@@ -0,0 +1,64 @@
+#ifndef VISEME_ATLAS_H
+#define VISEME_ATLAS_H
+
+#include <SDL2/SDL.h>
+#include <string>
+#include <thread>
+#include "../audio/vowel.h"
+
+// Image file of every mouth shape, indexed by VisemeGroup.
+struct VisemeImagePaths {
+    std::string files[VISEME_GROUP_COUNT];
+};
+
+// Returns the classic image set in a directory: 7.png for silence and
+// 1.png to 6.png for the open, mid, spread, central, round and narrow shapes.
+VisemeImagePaths visemeImagesInDirectory(const std::string& directory);
+
+// Parses the image option at argv[i], advancing i past its values:
+//   --images <dir>                      all shapes from a directory (see above)
+//   --viseme-image <group> <file>       one shape, e.g. --viseme-image round o.png
+// Returns false if argv[i] is not an image option.
+bool parseVisemeImageOption(int argc, char* argv[], int& i, VisemeImagePaths& paths);
+
+// The VisemeAtlas class holds every mouth shape in a single texture, so
+// switching shapes only changes the source rectangle of one bound texture.
+//
+// Loading is split in two so it overlaps other startup work (the Vosk
+// model): startLoading() decodes the images and packs them into one surface
+// on a worker thread; finishLoading() waits for it and uploads the result
+// from the render thread, which owns the renderer.
+class VisemeAtlas {
+public:
+    VisemeAtlas();
+
+    // Waits for a running loader and destroys the texture.
+    ~VisemeAtlas();
+
+    VisemeAtlas(const VisemeAtlas&) = delete;
+    VisemeAtlas& operator=(const VisemeAtlas&) = delete;
+
+    // Starts decoding and packing the images on a worker thread.
+    void startLoading(const VisemeImagePaths& paths);
+
+    // Waits for the worker and creates the atlas texture.
+    // Returns true if successful, false otherwise (the reason is logged).
+    bool finishLoading(SDL_Renderer* renderer);
+
+    SDL_Texture* texture() const { return texture_; }
+
+    // Part of the texture showing a mouth shape.
+    const SDL_Rect& rect(VisemeGroup group) const { return rects_[static_cast<size_t>(group)]; }
+
+private:
+    // Worker thread body: fills surface_ and rects_, or error_.
+    void load(VisemeImagePaths paths);
+
+    std::thread loader_;
+    SDL_Surface* surface_;   // Packed images, handed from the worker to finishLoading().
+    std::string error_;      // Why loading failed; empty on success.
+    SDL_Texture* texture_;
+    SDL_Rect rects_[VISEME_GROUP_COUNT];
+};
+
+#endif  // VISEME_ATLAS_H
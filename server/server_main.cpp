@@ -0,0 +1,490 @@
+// Headless multi-stream server: runs the vowel pipeline on many audio streams
+// at once and writes their viseme events instead of drawing them.
+//
+// Usage: dispenser_server [--listen <socket path>] [--model <dir>] [--threads N]
+//                         [--input-rate Hz] [--vowel-grammar] [--lpc]
+//                         [--vowel-table <file>] [--resampler-quality q] [--verbose]
+//                         [--log-level <level>] [--log-rate <lines/s>] [recordings...]
+// Every recording is one stream, processed as fast as possible; its events go
+// to <recording>.visemes. With --listen, every client connecting to the Unix
+// socket is one stream: it sends raw 16-bit mono PCM at --input-rate and
+// receives its events on the same connection. Client sockets are non-blocking:
+// workers queue a stream's events and the I/O thread sends them when the
+// socket can take them, so a slow reader never stalls a worker. The server
+// stops when all recordings are done and, if listening, on SIGINT/SIGTERM.
+//
+// --threads sets the number of pool workers (one per hardware thread by
+// default). Streams are spread over the workers, but each stream runs at most
+// one detection and one decoding task at a time. How throughput scales with
+// the core count has not been measured yet.
+//
+// The detector and recognizer log every result at the debug level, which
+// --verbose turns on; with many streams the rate limit keeps that in check.
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "stream_session.h"
+#include "work_stealing_pool.h"
+#include "../audio/file_audio_source.h"
+#include "../logging/logger.h"
+#include "../recognizer/recognizer_pool.h"
+
+#ifndef _WIN32
+    #include <fcntl.h>
+    #include <poll.h>
+    #include <sys/socket.h>
+    #include <sys/un.h>
+    #include <unistd.h>
+#endif
+
+namespace {
+
+std::atomic<bool> stopRequested(false);
+
+void onSignal(int) {
+    stopRequested.store(true);
+}
+
+// Input samples a stream may have waiting before its reader pauses
+const size_t MAX_PENDING_INPUT = 65536;
+// Samples taken from a recording per read
+const int FILE_CHUNK = 4096;
+// Event bytes a client may have waiting before its stream stops being read
+const size_t MAX_PENDING_OUTPUT = 65536;
+
+// Throughput of the streams that have ended, summed as they are closed so the
+// sessions themselves can be freed
+struct StreamTotals {
+    int streams = 0;
+    uint64_t captured = 0;
+    uint64_t decoded = 0;
+    uint64_t dropped = 0;
+
+    void add(const StreamSession& session) {
+        streams++;
+        captured += session.capturedSamples();
+        decoded += session.decodedSamples();
+        dropped += session.droppedDecodeSamples();
+    }
+};
+
+struct FileStream {
+    std::unique_ptr<FileAudioSource> source;
+    std::shared_ptr<std::ofstream> output;
+    std::shared_ptr<StreamSession> session;
+    bool finished = false;
+};
+
+#ifndef _WIN32
+// Event lines of one client, queued by the pool workers for the I/O thread.
+// The first line queued after the I/O thread took everything writes a byte
+// to the wake pipe, so a poll() waiting on the sockets returns.
+class ClientOutput {
+public:
+    explicit ClientOutput(int wakeFd) : wakeFd_(wakeFd) {}
+
+    void append(const std::string& line) {
+        bool wake;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            wake = lines_.empty();
+            lines_ += line;
+        }
+        if (wake) {
+            char byte = 0;
+            // The pipe is non-blocking; if it is full the I/O thread is already awake
+            ssize_t written = write(wakeFd_, &byte, 1);
+            (void)written;
+        }
+    }
+
+    // Moves the queued lines to the end of out.
+    void takeAll(std::string& out) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        out += lines_;
+        lines_.clear();
+    }
+
+    size_t queuedBytes() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return lines_.size();
+    }
+
+private:
+    mutable std::mutex mutex_;
+    std::string lines_;
+    int wakeFd_;
+};
+
+struct SocketStream {
+    int fd = -1;
+    std::shared_ptr<StreamSession> session;
+    std::shared_ptr<ClientOutput> output;
+    std::string sending;       // Events taken from output, not yet fully sent
+    size_t sent = 0;           // Bytes of sending already sent
+    unsigned char carry = 0;   // First byte of a sample split across reads
+    bool hasCarry = false;
+    bool closed = false;       // The client stopped sending
+    bool broken = false;       // Sending failed; further events are discarded
+
+    size_t pendingOutput() const { return sending.size() - sent + output->queuedBytes(); }
+};
+
+bool setNonBlocking(int fd) {
+    int flags = fcntl(fd, F_GETFL, 0);
+    return flags >= 0 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+int openListener(const std::string& path) {
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        LOG_ERROR("Failed to create socket: " << std::strerror(errno));
+        return -1;
+    }
+
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(address.sun_path)) {
+        LOG_ERROR("Socket path too long: " << path);
+        close(fd);
+        return -1;
+    }
+    std::strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+
+    // A socket file left by a previous run would make bind() fail
+    unlink(path.c_str());
+    if (bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0 || listen(fd, 64) < 0) {
+        LOG_ERROR("Failed to listen on " << path << ": " << std::strerror(errno));
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// Sends as much of the client's queued events as the socket takes without
+// blocking. Returns true if everything queued so far has been sent.
+bool flushOutput(SocketStream& client) {
+    client.output->takeAll(client.sending);
+    if (client.broken) {
+        client.sending.clear();
+        client.sent = 0;
+        return true;
+    }
+    while (client.sent < client.sending.size()) {
+        ssize_t n = send(client.fd, client.sending.data() + client.sent, client.sending.size() - client.sent,
+                         MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            return false;
+        }
+        if (n <= 0) {
+            // The client has gone away; keep decoding what it sent but stop writing
+            LOG_WARN("Stream " << client.session->id() << ": sending events failed: " << std::strerror(errno));
+            client.broken = true;
+            client.sending.clear();
+            client.sent = 0;
+            return true;
+        }
+        client.sent += static_cast<size_t>(n);
+    }
+    client.sending.clear();
+    client.sent = 0;
+    return true;
+}
+#endif
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::string listenPath;
+    std::string modelPath = "model/vosk-model-small-ru-0.22";
+    size_t threadCount = 0;
+    bool vowelGrammar = false;
+    std::string vowelTablePath;
+    StreamConfig config;
+    std::vector<std::string> recordings;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--listen" && i + 1 < argc) {
+            listenPath = argv[++i];
+        } else if (arg == "--model" && i + 1 < argc) {
+            modelPath = argv[++i];
+        } else if (arg == "--threads" && i + 1 < argc) {
+            threadCount = static_cast<size_t>(std::max(0, std::atoi(argv[++i])));
+        } else if (arg == "--input-rate" && i + 1 < argc) {
+            config.inputRate = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--vowel-grammar") {
+            vowelGrammar = true;
+        } else if (arg == "--verbose") {
+            Logger::setLevel(LogLevel::Debug);
+        } else if (parseLogOption(argc, argv, i)) {
+            continue;
+        } else if (arg == "--lpc") {
+            config.formantMethod = FormantMethod::Lpc;
+        } else if (arg == "--vowel-table" && i + 1 < argc) {
+            vowelTablePath = argv[++i];
+        } else if (arg == "--resampler-quality" && i + 1 < argc) {
+            if (!parseResamplerQuality(argv[++i], config.resamplerQuality)) {
+                LOG_WARN("Unknown resampler quality '" << argv[i] << "', using balanced");
+            }
+        } else {
+            recordings.push_back(arg);
+        }
+    }
+
+    if (listenPath.empty() && recordings.empty()) {
+        LOG_ERROR("Nothing to do: give recordings and/or --listen <socket path>");
+        return 1;
+    }
+
+    if (!vowelTablePath.empty() && !config.vowelTable.loadFromFile(vowelTablePath)) {
+        LOG_WARN("Using the built-in vowel profiles");
+    }
+
+    // One model for every stream; each stream gets its own recognizer on it
+    std::shared_ptr<VoskModel> model = SpeechRecognizer::loadModel(modelPath);
+    if (!model) {
+        LOG_WARN("Continuing with direct detection only");
+    }
+    RecognizerPool recognizers(model, vowelGrammar ? SpeechRecognizer::Mode::VowelGrammar
+                                                   : SpeechRecognizer::Mode::FullVocabulary);
+
+    WorkStealingPool pool(threadCount);
+    LOG_INFO("Worker threads: " << pool.threadCount());
+
+    std::signal(SIGINT, onSignal);
+    std::signal(SIGTERM, onSignal);
+
+    int nextId = 0;
+    StreamTotals totals;
+
+    // Recordings, each written to its own event file
+    std::vector<FileStream> files;
+    for (const std::string& path : recordings) {
+        FileStream file;
+        file.source = std::make_unique<FileAudioSource>(path, FileAudioSource::Pacing::AsFastAsPossible);
+        if (!file.source->init()) {
+            LOG_WARN("Skipping " << path);
+            continue;
+        }
+        file.output = std::make_shared<std::ofstream>(path + ".visemes");
+        if (!*file.output) {
+            LOG_WARN("Cannot write " << path << ".visemes, skipping");
+            continue;
+        }
+
+        StreamConfig fileConfig = config;
+        fileConfig.inputRate = file.source->sampleRate();
+        std::shared_ptr<std::ofstream> output = file.output;
+        file.session = std::make_shared<StreamSession>(nextId++, fileConfig, recognizers, pool,
+                                                       [output](const std::string& line) { *output << line; });
+        file.source->start();
+        files.push_back(std::move(file));
+    }
+
+#ifndef _WIN32
+    int listener = -1;
+    if (!listenPath.empty()) {
+        listener = openListener(listenPath);
+        if (listener < 0 && files.empty()) {
+            return 1;
+        }
+        if (listener >= 0) {
+            LOG_INFO("Listening on " << listenPath);
+        }
+    }
+    // Workers wake the I/O thread through this pipe when a client has new events
+    int wakePipe[2] = {-1, -1};
+    if (listener >= 0 && (pipe(wakePipe) < 0 || !setNonBlocking(wakePipe[0]) || !setNonBlocking(wakePipe[1]))) {
+        LOG_ERROR("Failed to create the wake pipe: " << std::strerror(errno));
+        return 1;
+    }
+    const size_t FIRST_CLIENT = 2; // pollFds: listener, wake pipe, then one per client
+    std::vector<SocketStream> sockets;
+    std::vector<pollfd> pollFds;
+    std::vector<short> socketSamples(8192);
+    std::vector<unsigned char> socketBytes(socketSamples.size() * sizeof(short));
+#else
+    if (!listenPath.empty()) {
+        LOG_WARN("Unix socket streams are not supported on this platform");
+        if (files.empty()) {
+            return 1;
+        }
+    }
+    const int listener = -1;
+#endif
+
+    auto start = std::chrono::steady_clock::now();
+
+    while (!stopRequested.load()) {
+        bool progress = false;
+
+        // Feed every recording a chunk, pausing the ones whose stream is behind
+        bool filesActive = false;
+        for (FileStream& file : files) {
+            if (file.finished) {
+                continue;
+            }
+            filesActive = true;
+            if (file.session->pendingSamples() >= MAX_PENDING_INPUT) {
+                continue;
+            }
+            const short* samples = nullptr;
+            int count = file.source->readSpan(samples, FILE_CHUNK);
+            if (count > 0) {
+                file.session->feed(samples, static_cast<size_t>(count));
+                progress = true;
+            } else if (!file.source->isRunning()) {
+                file.session->finish();
+                file.finished = true;
+            }
+        }
+
+#ifndef _WIN32
+        if (listener >= 0) {
+            pollFds.clear();
+            pollFds.push_back({listener, POLLIN, 0});
+            pollFds.push_back({wakePipe[0], POLLIN, 0});
+            for (SocketStream& client : sockets) {
+                bool flushed = flushOutput(client);
+                // Streams that are behind, or whose client is not taking its
+                // events, are not read, which pushes back on the client
+                bool wanted = !client.closed && client.session->pendingSamples() < MAX_PENDING_INPUT &&
+                              client.pendingOutput() < MAX_PENDING_OUTPUT;
+                short events = static_cast<short>((wanted ? POLLIN : 0) | (flushed ? 0 : POLLOUT));
+                // A hung-up socket would keep reporting POLLHUP; leave it out while there is nothing to send
+                pollFds.push_back({events != 0 || !client.closed ? client.fd : -1, events, 0});
+            }
+
+            // Block only when the recordings do not need the loop
+            int timeout = filesActive && !progress ? 1 : filesActive ? 0 : 100;
+            if (poll(pollFds.data(), pollFds.size(), timeout) > 0) {
+                if (pollFds[1].revents & POLLIN) {
+                    char drain[256];
+                    while (read(wakePipe[0], drain, sizeof(drain)) > 0) {
+                    }
+                }
+
+                if (pollFds[0].revents & POLLIN) {
+                    int fd = accept(listener, nullptr, nullptr);
+                    if (fd >= 0 && !setNonBlocking(fd)) {
+                        LOG_WARN("Failed to make a client socket non-blocking: " << std::strerror(errno));
+                        close(fd);
+                    } else if (fd >= 0) {
+                        SocketStream client;
+                        client.fd = fd;
+                        client.output = std::make_shared<ClientOutput>(wakePipe[1]);
+                        std::shared_ptr<ClientOutput> output = client.output;
+                        client.session = std::make_shared<StreamSession>(
+                            nextId++, config, recognizers, pool,
+                            [output](const std::string& line) { output->append(line); });
+                        LOG_INFO("Stream " << client.session->id() << " connected");
+                        sockets.push_back(std::move(client));
+                    }
+                }
+
+                for (size_t i = FIRST_CLIENT; i < pollFds.size(); i++) {
+                    SocketStream& client = sockets[i - FIRST_CLIENT];
+                    if (pollFds[i].revents & POLLOUT) {
+                        flushOutput(client);
+                    }
+                    if (client.closed || !(pollFds[i].revents & (POLLIN | POLLHUP | POLLERR))) {
+                        continue;
+                    }
+
+                    size_t offset = client.hasCarry ? 1 : 0;
+                    socketBytes[0] = client.carry;
+                    ssize_t n = read(client.fd, socketBytes.data() + offset, socketBytes.size() - offset);
+                    if (n <= 0) {
+                        if (n < 0 && (errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK)) {
+                            continue;
+                        }
+                        client.session->finish();
+                        client.closed = true;
+                        continue;
+                    }
+
+                    // Little-endian 16-bit samples; an odd trailing byte waits for the next read
+                    size_t bytes = offset + static_cast<size_t>(n);
+                    size_t count = bytes / 2;
+                    for (size_t s = 0; s < count; s++) {
+                        socketSamples[s] = static_cast<short>(socketBytes[2 * s] | (socketBytes[2 * s + 1] << 8));
+                    }
+                    client.hasCarry = (bytes & 1) != 0;
+                    client.carry = client.hasCarry ? socketBytes[bytes - 1] : 0;
+                    client.session->feed(socketSamples.data(), count);
+                    progress = true;
+                }
+            }
+
+            // Close connections whose events have all been sent
+            for (auto it = sockets.begin(); it != sockets.end();) {
+                if (it->closed && it->session->isDone() && flushOutput(*it)) {
+                    LOG_INFO("Stream " << it->session->id() << " finished, "
+                             << it->session->capturedSamples() / 16000.0 << " s of audio");
+                    totals.add(*it->session);
+                    close(it->fd);
+                    it = sockets.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+        }
+#endif
+
+        if (listener < 0) {
+            if (!filesActive) {
+                break;
+            }
+            if (!progress) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        }
+    }
+
+    // Let the streams finish what they were given
+    for (FileStream& file : files) {
+        file.session->finish();
+    }
+    pool.waitIdle();
+    auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+#ifndef _WIN32
+    // Whatever the clients can take without blocking; the rest is lost
+    for (SocketStream& client : sockets) {
+        flushOutput(client);
+        close(client.fd);
+        totals.add(*client.session);
+    }
+    if (listener >= 0) {
+        close(listener);
+        unlink(listenPath.c_str());
+        close(wakePipe[0]);
+        close(wakePipe[1]);
+    }
+#endif
+
+    for (const FileStream& file : files) {
+        totals.add(*file.session);
+    }
+    double audioSeconds = totals.captured / 16000.0;
+    LOG_INFO("Streams: " << totals.streams << ", audio: " << audioSeconds << " s in "
+             << elapsed << " s (" << (elapsed > 0.0 ? audioSeconds / elapsed : 0.0) << "x real time)");
+    LOG_INFO("Decoded by Vosk: " << totals.decoded / 16000.0 << " s, dropped: " << totals.dropped / 16000.0
+             << " s, recognizers created: " << recognizers.createdCount());
+    LOG_INFO("Tasks run: " << pool.executedTasks() << ", stolen: " << pool.stolenTasks());
+    return 0;
+}
@@ -0,0 +1,216 @@
+#include "stream_session.h"
+#include <algorithm>
+#include <utility>
+
+StreamSession::StreamSession(int id, const StreamConfig& config, RecognizerPool& recognizers,
+                             WorkStealingPool& pool, EventWriter writer)
+    : id_(id), recognizers_(recognizers), pool_(pool), writer_(std::move(writer)),
+      detectScheduled_(false), finished_(false),
+      frontEnd_(config.inputRate, config.resamplerQuality, BLOCK_SIZE),
+      detector_(1024, ANALYSIS_HOP, config.formantMethod, MultirateFrontEnd::ANALYSIS_RATE), lastDetected_(Vowel::None),
+      decodeQueued_(0), decodeScheduled_(false), recognizerRequested_(false),
+      captured_(0), decoded_(0), droppedDecode_(0) {
+    detector_.setVowelTable(config.vowelTable);
+    work_.reserve(DETECT_BATCH);
+    batch_.reserve(DECODE_BATCH);
+}
+
+StreamSession::~StreamSession() {
+    recognizers_.release(std::move(recognizer_));
+}
+
+void StreamSession::feed(const short* samples, size_t count) {
+    if (!samples || count == 0) {
+        return;
+    }
+
+    bool schedule = false;
+    {
+        std::lock_guard<std::mutex> lock(inputMutex_);
+        input_.insert(input_.end(), samples, samples + count);
+        if (!detectScheduled_) {
+            detectScheduled_ = true;
+            schedule = true;
+        }
+    }
+    if (schedule) {
+        auto self = shared_from_this();
+        pool_.submit([self] { self->detect(); });
+    }
+}
+
+void StreamSession::finish() {
+    {
+        std::lock_guard<std::mutex> lock(inputMutex_);
+        finished_ = true;
+    }
+    releaseRecognizerIfDone();
+}
+
+bool StreamSession::isDone() const {
+    {
+        std::lock_guard<std::mutex> lock(inputMutex_);
+        if (!finished_ || detectScheduled_ || !input_.empty()) {
+            return false;
+        }
+    }
+    std::lock_guard<std::mutex> lock(decodeMutex_);
+    return !decodeScheduled_ && decodeQueue_.empty();
+}
+
+size_t StreamSession::pendingSamples() const {
+    std::lock_guard<std::mutex> lock(inputMutex_);
+    return input_.size();
+}
+
+void StreamSession::detect() {
+    // Take at most one batch, leaving the rest for the requeued task
+    {
+        std::lock_guard<std::mutex> lock(inputMutex_);
+        size_t count = std::min(input_.size(), DETECT_BATCH);
+        work_.assign(input_.begin(), input_.begin() + count);
+        input_.erase(input_.begin(), input_.begin() + count);
+    }
+
+    for (size_t offset = 0; offset < work_.size(); offset += BLOCK_SIZE) {
+        processBlock(work_.data() + offset, std::min(BLOCK_SIZE, work_.size() - offset));
+    }
+
+    bool more;
+    {
+        std::lock_guard<std::mutex> lock(inputMutex_);
+        more = !input_.empty();
+        detectScheduled_ = more;
+    }
+    if (more) {
+        auto self = shared_from_this();
+        pool_.submit([self] { self->detect(); });
+    } else {
+        releaseRecognizerIfDone();
+    }
+}
+
+void StreamSession::processBlock(const short* samples, size_t count) {
+    frontEnd_.process(samples, count);
+    uint64_t captured = captured_.fetch_add(frontEnd_.speechSize(), std::memory_order_relaxed) + frontEnd_.speechSize();
+
+    Vowel detected = detector_.process(frontEnd_.analysis(), frontEnd_.analysisSize(), MultirateFrontEnd::ANALYSIS_RATE);
+    if (detected != lastDetected_) {
+        lastDetected_ = detected;
+        writeEvent(std::to_string(captured) + " detector " + (detected == Vowel::None ? "-" : vowelId(detected)) + "\n");
+    }
+
+    if (!recognizers_.hasModel()) {
+        return;
+    }
+
+    // Only speech the direct detector cannot handle goes to Vosk
+    int gated = gate_.process(frontEnd_.speech(), static_cast<int>(frontEnd_.speechSize()),
+                              detector_.lastFrameVoiced(), detected != Vowel::None);
+    if (gated <= 0) {
+        return;
+    }
+
+    bool schedule = false;
+    {
+        std::lock_guard<std::mutex> lock(decodeMutex_);
+        decodeQueue_.push_back({std::vector<short>(gate_.output(), gate_.output() + gated),
+                                static_cast<int64_t>(gate_.outputStartSample())});
+        decodeQueued_ += gated;
+
+        // Drop the oldest audio rather than let the decoder fall ever further behind
+        while (decodeQueued_ > MAX_DECODE_QUEUE && decodeQueue_.size() > 1) {
+            decodeQueued_ -= decodeQueue_.front().samples.size();
+            droppedDecode_.fetch_add(decodeQueue_.front().samples.size(), std::memory_order_relaxed);
+            decodeQueue_.pop_front();
+        }
+
+        if (!decodeScheduled_) {
+            decodeScheduled_ = true;
+            schedule = true;
+        }
+    }
+    if (schedule) {
+        auto self = shared_from_this();
+        pool_.submit([self] { self->decode(); });
+    }
+}
+
+void StreamSession::decode() {
+    if (!recognizerRequested_) {
+        recognizerRequested_ = true;
+        recognizer_ = recognizers_.acquire();
+    }
+
+    // Take as many queued blocks as fit into one batch, remembering where
+    // each one lands on the decoder's timeline
+    batch_.clear();
+    {
+        std::lock_guard<std::mutex> lock(decodeMutex_);
+        int64_t decoderPosition = recognizer_ ? recognizer_->decodedSamples() : 0;
+        while (!decodeQueue_.empty() &&
+               (batch_.empty() || batch_.size() + decodeQueue_.front().samples.size() <= DECODE_BATCH)) {
+            const DecodeBlock& block = decodeQueue_.front();
+            timeline_.addSegment(decoderPosition + static_cast<int64_t>(batch_.size()),
+                                 block.captureSample, static_cast<int64_t>(block.samples.size()));
+            batch_.insert(batch_.end(), block.samples.begin(), block.samples.end());
+            decodeQueued_ -= block.samples.size();
+            decodeQueue_.pop_front();
+        }
+    }
+
+    if (recognizer_ && !batch_.empty()) {
+        const std::string& text = recognizer_->recognize(batch_.data(), static_cast<int>(batch_.size()));
+        decoded_.fetch_add(batch_.size(), std::memory_order_relaxed);
+
+        if (!text.empty() && text != lastText_) {
+            std::vector<TimedVowel> timed;
+            timeline_.takeNewVowels(recognizer_->extractTimedVowels(), timed);
+            for (const TimedVowel& vowel : timed) {
+                writeEvent(std::to_string(vowel.startSample) + " vosk " + vowelId(vowel.vowel) + " " +
+                           std::to_string(vowel.endSample) + "\n");
+            }
+            lastText_ = text;
+        }
+    }
+
+    bool more;
+    {
+        std::lock_guard<std::mutex> lock(decodeMutex_);
+        more = !decodeQueue_.empty();
+        decodeScheduled_ = more;
+    }
+    if (more) {
+        auto self = shared_from_this();
+        pool_.submit([self] { self->decode(); });
+    } else {
+        releaseRecognizerIfDone();
+    }
+}
+
+void StreamSession::releaseRecognizerIfDone() {
+    // With the input ended and nothing queued no decoding task can run again,
+    // so the recognizer goes back to the pool now rather than with the session
+    {
+        std::lock_guard<std::mutex> lock(inputMutex_);
+        if (!finished_ || detectScheduled_ || !input_.empty()) {
+            return;
+        }
+    }
+    std::unique_ptr<SpeechRecognizer> recognizer;
+    {
+        std::lock_guard<std::mutex> lock(decodeMutex_);
+        if (decodeScheduled_ || !decodeQueue_.empty()) {
+            return;
+        }
+        recognizer = std::move(recognizer_);
+    }
+    recognizers_.release(std::move(recognizer));
+}
+
+void StreamSession::writeEvent(const std::string& line) {
+    std::lock_guard<std::mutex> lock(outputMutex_);
+    if (writer_) {
+        writer_(line);
+    }
+}
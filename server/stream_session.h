@@ -0,0 +1,150 @@
+#ifndef STREAM_SESSION_H
+#define STREAM_SESSION_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "work_stealing_pool.h"
+#include "../audio/multirate_front_end.h"
+#include "../audio/voice_activity_gate.h"
+#include "../audio/vowel_detector.h"
+#include "../recognizer/decoder_timeline.h"
+#include "../recognizer/recognizer_pool.h"
+
+// Settings shared by every stream of a server.
+struct StreamConfig {
+    int inputRate = 16000;                                    // Sample rate of the incoming audio.
+    ResamplerQuality resamplerQuality = ResamplerQuality::Balanced;
+    FormantMethod formantMethod = FormantMethod::SpectralPeaks;
+    VowelTable vowelTable;                                    // Vowel profiles for the detector.
+};
+
+// The StreamSession class is the server-side state of one audio stream: the
+// same front end, direct detector, voice gate and Vosk decoding that main()
+// runs for the microphone, driven by tasks on a shared WorkStealingPool.
+//
+// Incoming audio is appended by the I/O thread with feed(). Detection and
+// decoding are separate tasks, so a stream's Vosk decoding never holds up its
+// direct detection; each kind runs at most once at a time per stream, which
+// keeps the per-stream state single-threaded without locking it. One stream
+// therefore keeps at most two workers busy; more threads only help when there
+// are more streams. A task handles one batch and then requeues itself, so
+// long streams do not starve short ones.
+//
+// Viseme events are written as text lines through the writer:
+//   <sample> detector <vowel id or ->       direct detection changed
+//   <start> vosk <vowel id> <end>           vowel placed by Vosk word timing
+// Samples count 16 kHz samples from the start of the stream.
+class StreamSession : public std::enable_shared_from_this<StreamSession> {
+public:
+    using EventWriter = std::function<void(const std::string& line)>;
+
+    // Parameters:
+    // - id: Stream number for logs.
+    // - config: Shared stream settings.
+    // - recognizers: Source of Vosk recognizers; a stream decodes nothing if it has no model.
+    // - pool: Pool that runs the stream's tasks.
+    // - writer: Receives the event lines; called from pool threads, one call at a
+    //   time. It runs on a worker, so it must not block (sockets queue the line
+    //   for the I/O thread).
+    StreamSession(int id, const StreamConfig& config, RecognizerPool& recognizers,
+                  WorkStealingPool& pool, EventWriter writer);
+
+    // Returns the recognizer to the pool if the stream still holds it.
+    ~StreamSession();
+
+    StreamSession(const StreamSession&) = delete;
+    StreamSession& operator=(const StreamSession&) = delete;
+
+    // Appends audio at the input rate and schedules detection. Called by the I/O thread.
+    void feed(const short* samples, size_t count);
+
+    // Marks the end of the input. Audio already fed is still processed, after
+    // which the recognizer goes back to the pool even if the session lives on.
+    void finish();
+
+    // Checks whether the input has ended and every task of the stream has finished.
+    bool isDone() const;
+
+    // Input samples fed but not yet analyzed, for back-pressure on the reader.
+    size_t pendingSamples() const;
+
+    int id() const { return id_; }
+
+    // Counters for throughput reports.
+    uint64_t capturedSamples() const { return captured_.load(std::memory_order_relaxed); }
+    uint64_t decodedSamples() const { return decoded_.load(std::memory_order_relaxed); }
+    uint64_t droppedDecodeSamples() const { return droppedDecode_.load(std::memory_order_relaxed); }
+
+private:
+    // Gated 16 kHz audio waiting for the decoder.
+    struct DecodeBlock {
+        std::vector<short> samples;
+        int64_t captureSample;
+    };
+
+    // Task bodies.
+    void detect();
+    void decode();
+
+    // Runs the front end, detector and gate on one block of input.
+    void processBlock(const short* samples, size_t count);
+
+    // Returns the recognizer to the pool once finish() was called and every
+    // task has finished. Safe to call from any thread, more than once.
+    void releaseRecognizerIfDone();
+
+    // Writes one event line.
+    void writeEvent(const std::string& line);
+
+    int id_;
+    RecognizerPool& recognizers_;
+    WorkStealingPool& pool_;
+    EventWriter writer_;
+
+    // Input handed over by the I/O thread
+    mutable std::mutex inputMutex_;
+    std::vector<short> input_;      // Samples not yet taken by a detection task.
+    bool detectScheduled_;          // A detection task is queued or running.
+    bool finished_;                 // No more input will arrive.
+
+    // Detection state, touched only by the running detection task
+    std::vector<short> work_;       // Batch being analyzed.
+    MultirateFrontEnd frontEnd_;
+    VowelDetector detector_;
+    VoiceActivityGate gate_;
+    Vowel lastDetected_;            // Last direct decision written out.
+
+    // Decoder input handed over by detection tasks
+    mutable std::mutex decodeMutex_;
+    std::deque<DecodeBlock> decodeQueue_;
+    size_t decodeQueued_;           // Samples in decodeQueue_.
+    bool decodeScheduled_;          // A decoding task is queued or running.
+
+    // Decoding state, touched only by the running decoding task
+    std::unique_ptr<SpeechRecognizer> recognizer_;
+    bool recognizerRequested_;      // acquire() was tried, successful or not.
+    DecoderTimeline timeline_;
+    std::vector<short> batch_;
+    std::string lastText_;
+
+    std::mutex outputMutex_;        // Serializes writer_ calls from both task kinds.
+
+    std::atomic<uint64_t> captured_;
+    std::atomic<uint64_t> decoded_;
+    std::atomic<uint64_t> droppedDecode_;
+
+    static constexpr size_t BLOCK_SIZE = 2048;          // Input samples per front-end call.
+    static constexpr size_t DETECT_BATCH = 16384;       // Input samples per detection task.
+    static constexpr size_t DECODE_BATCH = 8192;        // Samples per Vosk call.
+    static constexpr size_t MAX_DECODE_QUEUE = 64000;   // Decoder backlog (4 s) before old audio is dropped.
+    static constexpr int ANALYSIS_HOP = 128;            // Detector hop at the 8 kHz analysis rate.
+};
+
+#endif  // STREAM_SESSION_H
@@ -0,0 +1,130 @@
+#include "work_stealing_pool.h"
+#include <algorithm>
+#include <utility>
+
+namespace {
+
+// Pool and worker index of the calling thread, so tasks submitted from a
+// worker land on its own deque
+thread_local const WorkStealingPool* currentPool = nullptr;
+thread_local size_t currentWorker = 0;
+
+} // namespace
+
+WorkStealingPool::WorkStealingPool(size_t threadCount)
+    : stopping_(false), queued_(0), pending_(0), nextWorker_(0), executed_(0), stolen_(0) {
+    if (threadCount == 0) {
+        threadCount = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+    }
+
+    // All deques exist before any worker starts stealing
+    for (size_t i = 0; i < threadCount; i++) {
+        workers_.push_back(std::make_unique<Worker>());
+    }
+    for (size_t i = 0; i < threadCount; i++) {
+        threads_.emplace_back(&WorkStealingPool::run, this, i);
+    }
+}
+
+WorkStealingPool::~WorkStealingPool() {
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex_);
+        stopping_ = true;
+    }
+    wake_.notify_all();
+    for (auto& thread : threads_) {
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+}
+
+void WorkStealingPool::submit(Task task) {
+    if (!task) {
+        return;
+    }
+
+    size_t index = currentPool == this
+        ? currentWorker
+        : nextWorker_.fetch_add(1, std::memory_order_relaxed) % workers_.size();
+
+    // Count the task before it becomes visible, under the sleep lock, so the
+    // counter never goes negative and a worker that just found every deque
+    // empty cannot miss the wake-up
+    pending_.fetch_add(1, std::memory_order_relaxed);
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex_);
+        queued_.fetch_add(1, std::memory_order_release);
+    }
+    {
+        std::lock_guard<std::mutex> lock(workers_[index]->mutex);
+        workers_[index]->tasks.push_back(std::move(task));
+    }
+    wake_.notify_one();
+}
+
+void WorkStealingPool::waitIdle() {
+    std::unique_lock<std::mutex> lock(sleepMutex_);
+    idle_.wait(lock, [this] { return pending_.load(std::memory_order_acquire) == 0; });
+}
+
+bool WorkStealingPool::popLocal(size_t index, Task& task) {
+    Worker& worker = *workers_[index];
+    std::lock_guard<std::mutex> lock(worker.mutex);
+    if (worker.tasks.empty()) {
+        return false;
+    }
+    task = std::move(worker.tasks.back());
+    worker.tasks.pop_back();
+    return true;
+}
+
+bool WorkStealingPool::steal(size_t index, Task& task) {
+    // Start with the next worker so thieves do not all pile onto worker 0
+    for (size_t offset = 1; offset < workers_.size(); offset++) {
+        Worker& victim = *workers_[(index + offset) % workers_.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+void WorkStealingPool::run(size_t index) {
+    currentPool = this;
+    currentWorker = index;
+
+    while (true) {
+        Task task;
+        bool found = popLocal(index, task);
+        bool stolen = false;
+        if (!found) {
+            found = stolen = steal(index, task);
+        }
+
+        if (!found) {
+            std::unique_lock<std::mutex> lock(sleepMutex_);
+            wake_.wait(lock, [this] { return stopping_ || queued_.load(std::memory_order_acquire) > 0; });
+            if (stopping_ && queued_.load(std::memory_order_acquire) == 0) {
+                return;
+            }
+            continue;
+        }
+
+        queued_.fetch_sub(1, std::memory_order_acq_rel);
+        if (stolen) {
+            stolen_.fetch_add(1, std::memory_order_relaxed);
+        }
+        task();
+        task = nullptr;
+        executed_.fetch_add(1, std::memory_order_relaxed);
+
+        if (pending_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            std::lock_guard<std::mutex> lock(sleepMutex_);
+            idle_.notify_all();
+        }
+    }
+}
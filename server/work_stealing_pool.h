@@ -0,0 +1,81 @@
+#ifndef WORK_STEALING_POOL_H
+#define WORK_STEALING_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// The WorkStealingPool class runs tasks on a fixed set of worker threads.
+// Every worker has its own task deque: tasks submitted from a worker go to
+// the back of that worker's deque and are taken from the back again (the
+// data they touch is still in that core's cache), while idle workers steal
+// from the front of other workers' deques. Tasks submitted from other
+// threads are spread round-robin. Workers with nothing to run or steal sleep
+// until new work is submitted.
+class WorkStealingPool {
+public:
+    using Task = std::function<void()>;
+
+    // Starts the workers.
+    // Parameters:
+    // - threadCount: Number of workers; 0 uses one per hardware thread.
+    explicit WorkStealingPool(size_t threadCount = 0);
+
+    // Destructor: Runs the tasks that are still queued, then stops the workers.
+    ~WorkStealingPool();
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    // Queues a task. Safe to call from any thread, including from a task.
+    void submit(Task task);
+
+    // Waits until every submitted task, including tasks they submitted, has finished.
+    void waitIdle();
+
+    size_t threadCount() const { return threads_.size(); }
+
+    // Counters for monitoring the load balance.
+    uint64_t executedTasks() const { return executed_.load(std::memory_order_relaxed); }
+    uint64_t stolenTasks() const { return stolen_.load(std::memory_order_relaxed); }
+
+private:
+    // A worker's task deque. Owner and thieves take the same small lock; the
+    // lock is held only to move one task in or out.
+    struct Worker {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    // Worker thread body.
+    void run(size_t index);
+
+    // Takes the newest task of the worker's own deque.
+    bool popLocal(size_t index, Task& task);
+
+    // Takes the oldest task of another worker's deque.
+    bool steal(size_t index, Task& task);
+
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::vector<std::thread> threads_;
+
+    std::mutex sleepMutex_;             // Guards sleeping, waking and stopping_.
+    std::condition_variable wake_;      // Signaled when a task is queued or on shutdown.
+    std::condition_variable idle_;      // Signaled when the last pending task finishes.
+    bool stopping_;                     // Set when the workers should exit.
+
+    std::atomic<size_t> queued_;        // Tasks sitting in some deque.
+    std::atomic<size_t> pending_;       // Tasks queued or running.
+    std::atomic<size_t> nextWorker_;    // Round-robin target for outside submissions.
+    std::atomic<uint64_t> executed_;    // Tasks run.
+    std::atomic<uint64_t> stolen_;      // Tasks run by a worker other than the one they were queued on.
+};
+
+#endif  // WORK_STEALING_POOL_H
@@ -0,0 +1,164 @@
+// Checks that the per-block hot paths make no heap allocations once warmed
+// up: global operator new is replaced by a counting version and every
+// allocation made on this thread while they run is counted.
+// - VowelDetector::process() is fed synthetic speech at the application's
+//   analysis settings (8 kHz, 64 ms frames every 16 ms), counting after the
+//   first second. Runs once per formant engine.
+// - SpeechRecognizer::recognize() runs against a fake Vosk API that returns
+//   typical Russian partial and final results with word times, one of them
+//   with escapes, so the JSON parsing and the text buffer are covered.
+// Exits with 1 if anything was allocated.
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <vector>
+#include "../audio/vowel_detector.h"
+#include "../bench/synthetic_vowels.h"
+#include "../recognizer/vosk_recognizer.h"
+
+namespace {
+
+thread_local bool counting = false;
+std::atomic<size_t> allocations{0};
+
+void* allocate(size_t size) {
+    if (counting) {
+        allocations.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (void* memory = std::malloc(size ? size : 1)) {
+        return memory;
+    }
+    throw std::bad_alloc();
+}
+
+const int SAMPLE_RATE = 8000;
+const size_t BLOCK_SIZE = 1024;
+const size_t HOP = 128;
+const size_t WARM_UP = SAMPLE_RATE;      // Samples fed before counting starts
+const size_t MEASURED = 8 * SAMPLE_RATE; // Samples fed while counting
+
+// Results the fake Vosk returns in turn; every fourth block ends an utterance
+const char* const PARTIALS[] = {
+    "{\n  \"partial\" : \"привет\",\n  \"partial_result\" : [{\n      \"conf\" : 1.000000,\n"
+    "      \"end\" : 0.960000,\n      \"start\" : 0.450000,\n      \"word\" : \"привет\"\n    }]\n}",
+    "{\n  \"partial\" : \"привет как дела\",\n  \"partial_result\" : [{\n      \"conf\" : 1.000000,\n"
+    "      \"end\" : 0.960000,\n      \"start\" : 0.450000,\n      \"word\" : \"привет\"\n    }, {\n"
+    "      \"conf\" : 1.000000,\n      \"end\" : 1.230000,\n      \"start\" : 0.990000,\n"
+    "      \"word\" : \"как\"\n    }, {\n      \"conf\" : 1.000000,\n      \"end\" : 1.680000,\n"
+    "      \"start\" : 1.260000,\n      \"word\" : \"дела\"\n    }]\n}",
+    "{\n  \"partial\" : \"привет как дела \\u043c\\u0430\\u043c\\u0430\"\n}",
+};
+const char* const FINAL =
+    "{\n  \"result\" : [{\n      \"conf\" : 0.981234,\n      \"end\" : 0.960000,\n      \"start\" : 0.450000,\n"
+    "      \"word\" : \"привет\"\n    }, {\n      \"conf\" : 0.912345,\n      \"end\" : 2.370000,\n"
+    "      \"start\" : 1.920000,\n      \"word\" : \"мама\"\n    }],\n  \"text\" : \"привет как дела мама\"\n}";
+const int RECOGNIZER_BLOCK = 1600;   // 100 ms at 16 kHz
+const int RECOGNIZER_WARM_UP = 16;   // Blocks before counting starts
+const int RECOGNIZER_MEASURED = 400; // Blocks counted
+
+// State of the fake Vosk recognizer: the number of blocks fed so far
+struct FakeRecognizer {
+    int blocks = 0;
+};
+
+} // namespace
+
+extern "C" {
+
+VoskModel* vosk_model_new(const char*) { return reinterpret_cast<VoskModel*>(new int(0)); }
+void vosk_model_free(VoskModel* model) { delete reinterpret_cast<int*>(model); }
+void vosk_set_log_level(int) {}
+
+VoskRecognizer* vosk_recognizer_new(VoskModel*, float) {
+    return reinterpret_cast<VoskRecognizer*>(new FakeRecognizer());
+}
+
+VoskRecognizer* vosk_recognizer_new_grm(VoskModel* model, float sampleRate, const char*) {
+    return vosk_recognizer_new(model, sampleRate);
+}
+
+void vosk_recognizer_free(VoskRecognizer* recognizer) { delete reinterpret_cast<FakeRecognizer*>(recognizer); }
+void vosk_recognizer_set_words(VoskRecognizer*, int) {}
+void vosk_recognizer_set_partial_words(VoskRecognizer*, int) {}
+void vosk_recognizer_reset(VoskRecognizer*) {}
+
+int vosk_recognizer_accept_waveform(VoskRecognizer* handle, const char*, int) {
+    return ++reinterpret_cast<FakeRecognizer*>(handle)->blocks % 4 == 0;
+}
+
+const char* vosk_recognizer_result(VoskRecognizer*) { return FINAL; }
+
+const char* vosk_recognizer_partial_result(VoskRecognizer* handle) {
+    // Blocks 1-3 of every four are partial results
+    return PARTIALS[reinterpret_cast<FakeRecognizer*>(handle)->blocks % 4 - 1];
+}
+
+} // extern "C"
+
+void* operator new(size_t size) { return allocate(size); }
+void* operator new[](size_t size) { return allocate(size); }
+void operator delete(void* memory) noexcept { std::free(memory); }
+void operator delete[](void* memory) noexcept { std::free(memory); }
+void operator delete(void* memory, size_t) noexcept { std::free(memory); }
+void operator delete[](void* memory, size_t) noexcept { std::free(memory); }
+
+int main() {
+    SynthesisSettings settings;
+    settings.sampleRate = SAMPLE_RATE;
+    std::vector<short> audio(WARM_UP + MEASURED);
+    VowelSynthesizer(settings, 7).generate(audio.data(), audio.size());
+
+    int failures = 0;
+    for (FormantMethod method : {FormantMethod::SpectralPeaks, FormantMethod::Lpc}) {
+        VowelDetector detector(BLOCK_SIZE, HOP, method, SAMPLE_RATE);
+        for (size_t offset = 0; offset < WARM_UP; offset += HOP) {
+            detector.process(audio.data() + offset, HOP, SAMPLE_RATE);
+        }
+
+        uint64_t framesBefore = detector.framesAnalyzed();
+        size_t vowels = 0;
+        allocations.store(0);
+        counting = true;
+        for (size_t offset = WARM_UP; offset < audio.size(); offset += HOP) {
+            vowels += detector.process(audio.data() + offset, HOP, SAMPLE_RATE) != Vowel::None;
+        }
+        counting = false;
+
+        uint64_t frames = detector.framesAnalyzed() - framesBefore;
+        size_t counted = allocations.load();
+        std::printf("%s: %llu frames, %zu with a vowel, %zu allocations\n", formantMethodName(method),
+                    static_cast<unsigned long long>(frames), vowels, counted);
+        if (counted != 0 || frames == 0 || vowels == 0) {
+            std::printf("FAIL %s: expected no allocations over frames that detect vowels\n",
+                        formantMethodName(method));
+            failures++;
+        }
+    }
+
+    SpeechRecognizer recognizer("fake-model", SpeechRecognizer::Mode::FullVocabulary);
+    recognizer.setWordTimes(true);
+    std::vector<short> block(RECOGNIZER_BLOCK, 0);
+    for (int i = 0; i < RECOGNIZER_WARM_UP; i++) {
+        recognizer.recognize(block.data(), RECOGNIZER_BLOCK);
+    }
+
+    size_t textBytes = 0;
+    size_t words = 0;
+    allocations.store(0);
+    counting = true;
+    for (int i = 0; i < RECOGNIZER_MEASURED; i++) {
+        textBytes += recognizer.recognize(block.data(), RECOGNIZER_BLOCK).size();
+        words += recognizer.lastWords().size();
+    }
+    counting = false;
+
+    size_t counted = allocations.load();
+    std::printf("recognize: %d blocks, %zu text bytes, %zu words, %zu allocations\n", RECOGNIZER_MEASURED,
+                textBytes, words, counted);
+    if (counted != 0 || textBytes == 0 || words == 0) {
+        std::printf("FAIL recognize: expected no allocations over blocks with results\n");
+        failures++;
+    }
+    return failures > 0 ? 1 : 0;
+}
@@ -0,0 +1,98 @@
+// Checks FftPlan, FftPlanF and BatchFftPlanF against referenceDft on random
+// signals of every supported size up to 4096, and checks that the batch plan
+// matches FftPlanF bin for bin, including batches that do not fill a tile.
+// Exits with 1 and lists the mismatches if any transform is off.
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <cstdio>
+#include <random>
+#include <vector>
+#include "../audio/fft.h"
+
+namespace {
+
+int failures = 0;
+
+void expect(bool condition, const char* what, size_t size, double error) {
+    if (!condition) {
+        std::printf("FAIL %s, size %zu: error %g\n", what, size, error);
+        failures++;
+    }
+}
+
+// Largest bin difference relative to the largest reference bin
+template<typename T>
+double relativeError(const std::complex<T>* bins, const std::complex<double>* reference, size_t count) {
+    double peak = 0.0;
+    double error = 0.0;
+    for (size_t k = 0; k < count; k++) {
+        peak = std::max(peak, std::abs(reference[k]));
+        std::complex<double> bin(bins[k].real(), bins[k].imag());
+        error = std::max(error, std::abs(bin - reference[k]));
+    }
+    return peak > 0.0 ? error / peak : error;
+}
+
+void testSize(size_t size, std::mt19937& random) {
+    std::uniform_real_distribution<double> sample(-1.0, 1.0);
+    size_t bins = size / 2;
+
+    std::vector<double> input(size);
+    std::vector<float> inputF(size);
+    for (size_t n = 0; n < size; n++) {
+        input[n] = sample(random);
+        inputF[n] = static_cast<float>(input[n]);
+    }
+    std::vector<std::complex<double>> reference(bins);
+    referenceDft(input.data(), size, reference.data());
+
+    FftPlan plan(size);
+    std::vector<std::complex<double>> output(bins);
+    plan.forwardReal(input.data(), output.data());
+    double error = relativeError(output.data(), reference.data(), bins);
+    expect(error < 1e-12, "FftPlan vs referenceDft", size, error);
+
+    FftPlanF planF(size);
+    std::vector<std::complex<float>> outputF(bins);
+    planF.forwardReal(inputF.data(), outputF.data());
+    error = relativeError(outputF.data(), reference.data(), bins);
+    expect(error < 1e-5, "FftPlanF vs referenceDft", size, error);
+
+    // 21 signals: one full tile of 16 and a partial one of 5
+    const size_t batch = 21;
+    std::vector<float> signals(batch * size);
+    for (float& value : signals) {
+        value = static_cast<float>(sample(random));
+    }
+    BatchFftPlanF batchPlan(size, batch);
+    std::vector<float> real(bins * batch);
+    std::vector<float> imag(bins * batch);
+    batchPlan.forwardReal(signals.data(), batch, real.data(), imag.data());
+
+    double batchError = 0.0;
+    for (size_t b = 0; b < batch; b++) {
+        planF.forwardReal(signals.data() + b * size, outputF.data());
+        for (size_t k = 0; k < bins; k++) {
+            batchError = std::max(batchError, static_cast<double>(std::abs(
+                outputF[k] - std::complex<float>(real[k * batch + b], imag[k * batch + b]))));
+        }
+    }
+    // Bit-identical unless the compiler contracts the two differently into FMAs
+    expect(batchError <= 1e-6 * std::sqrt(static_cast<double>(size)), "BatchFftPlanF vs FftPlanF", size, batchError);
+}
+
+} // namespace
+
+int main() {
+    std::mt19937 random(2024);
+    for (size_t size = 4; size <= 4096; size *= 2) {
+        testSize(size, random);
+    }
+    if (failures > 0) {
+        std::printf("%d FFT checks failed\n", failures);
+        return 1;
+    }
+    std::printf("FFT plans match the reference DFT\n");
+    return 0;
+}
@@ -0,0 +1,145 @@
+// Checks that SpeechRecognizer places word times on its decoder timeline
+// across several utterances: the Vosk API is replaced by a scripted fake that
+// ends an utterance every second and, like Vosk, times words from the
+// recognizer's creation (a reset does not rewind that clock). Between two
+// spoken utterances comes a silent one whose final result is empty, and the
+// last utterance follows an explicit reset(), as a recycled recognizer sees.
+// Exits with 1 and lists the mismatches if any vowel is misplaced.
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include "../recognizer/vosk_recognizer.h"
+
+namespace {
+
+const int SAMPLE_RATE = 16000;
+const int BLOCK = 1600; // 100 ms per recognize() call
+
+// One scripted final result: returned when the fed audio reaches endSample
+struct Utterance {
+    int64_t endSample;
+    const char* json;
+};
+
+const Utterance SCRIPT[] = {
+    {16000, "{\"result\" : [{\"conf\" : 1.0, \"end\" : 0.6, \"start\" : 0.2, \"word\" : \"мама\"}],"
+            " \"text\" : \"мама\"}"},
+    {32000, "{\"text\" : \"\"}"},
+    {48000, "{\"result\" : [{\"conf\" : 1.0, \"end\" : 2.6, \"start\" : 2.2, \"word\" : \"папа\"}],"
+            " \"text\" : \"папа\"}"},
+    {64000, "{\"result\" : [{\"conf\" : 1.0, \"end\" : 3.6, \"start\" : 3.4, \"word\" : \"да\"}],"
+            " \"text\" : \"да\"}"},
+};
+
+struct FakeRecognizer {
+    int64_t fed = 0;
+    size_t next = 0;
+    const char* result = "{\"text\" : \"\"}";
+};
+
+int failures = 0;
+
+void expect(bool condition, const char* what, int64_t value, int64_t expected) {
+    if (!condition) {
+        std::printf("FAIL %s: %lld, expected %lld\n", what, static_cast<long long>(value),
+                    static_cast<long long>(expected));
+        failures++;
+    }
+}
+
+void expectVowel(const std::vector<TimedVowel>& vowels, size_t index, Vowel vowel, double start, double end) {
+    if (index >= vowels.size()) {
+        std::printf("FAIL vowel %zu missing\n", index);
+        failures++;
+        return;
+    }
+    expect(vowels[index].vowel == vowel, "vowel", static_cast<int64_t>(vowels[index].vowel),
+           static_cast<int64_t>(vowel));
+    expect(vowels[index].startSample == static_cast<int64_t>(start * SAMPLE_RATE), "vowel start",
+           vowels[index].startSample, static_cast<int64_t>(start * SAMPLE_RATE));
+    expect(vowels[index].endSample == static_cast<int64_t>(end * SAMPLE_RATE), "vowel end",
+           vowels[index].endSample, static_cast<int64_t>(end * SAMPLE_RATE));
+}
+
+} // namespace
+
+extern "C" {
+
+VoskModel* vosk_model_new(const char*) { return reinterpret_cast<VoskModel*>(new int(0)); }
+void vosk_model_free(VoskModel* model) { delete reinterpret_cast<int*>(model); }
+void vosk_set_log_level(int) {}
+
+VoskRecognizer* vosk_recognizer_new(VoskModel*, float) {
+    return reinterpret_cast<VoskRecognizer*>(new FakeRecognizer());
+}
+
+VoskRecognizer* vosk_recognizer_new_grm(VoskModel* model, float sampleRate, const char*) {
+    return vosk_recognizer_new(model, sampleRate);
+}
+
+void vosk_recognizer_free(VoskRecognizer* recognizer) { delete reinterpret_cast<FakeRecognizer*>(recognizer); }
+void vosk_recognizer_set_words(VoskRecognizer*, int) {}
+void vosk_recognizer_set_partial_words(VoskRecognizer*, int) {}
+
+// Like Vosk, a reset only drops the decoder state; the sample clock keeps running
+void vosk_recognizer_reset(VoskRecognizer*) {}
+
+int vosk_recognizer_accept_waveform(VoskRecognizer* handle, const char*, int length) {
+    FakeRecognizer* recognizer = reinterpret_cast<FakeRecognizer*>(handle);
+    recognizer->fed += length / static_cast<int>(sizeof(short));
+    const size_t count = sizeof(SCRIPT) / sizeof(SCRIPT[0]);
+    if (recognizer->next < count && recognizer->fed >= SCRIPT[recognizer->next].endSample) {
+        recognizer->result = SCRIPT[recognizer->next++].json;
+        return 1;
+    }
+    return 0;
+}
+
+const char* vosk_recognizer_result(VoskRecognizer* handle) {
+    return reinterpret_cast<FakeRecognizer*>(handle)->result;
+}
+
+const char* vosk_recognizer_partial_result(VoskRecognizer*) { return "{\"partial\" : \"\"}"; }
+
+} // extern "C"
+
+int main() {
+    SpeechRecognizer recognizer("fake-model", SpeechRecognizer::Mode::FullVocabulary);
+    if (!recognizer.isValid()) {
+        std::printf("FAIL recognizer not created\n");
+        return 1;
+    }
+    recognizer.setWordTimes(true);
+
+    std::vector<short> block(BLOCK, 0);
+    std::vector<TimedVowel> vowels;
+    int finals = 0;
+    for (int64_t position = 0; position < 64000; position += BLOCK) {
+        if (position == 48000) {
+            recognizer.reset();
+        }
+        recognizer.recognize(block.data(), BLOCK);
+        if (!recognizer.lastWords().empty()) {
+            finals++;
+            std::vector<TimedVowel> timed = recognizer.extractTimedVowels();
+            vowels.insert(vowels.end(), timed.begin(), timed.end());
+        }
+    }
+    expect(finals == 3, "results with words", finals, 3);
+    expect(recognizer.decodedSamples() == 64000, "decoded samples", recognizer.decodedSamples(), 64000);
+
+    // Each word's vowels split its duration evenly
+    expectVowel(vowels, 0, Vowel::A, 0.2, 0.4);
+    expectVowel(vowels, 1, Vowel::A, 0.4, 0.6);
+    expectVowel(vowels, 2, Vowel::A, 2.2, 2.4);
+    expectVowel(vowels, 3, Vowel::A, 2.4, 2.6);
+    expectVowel(vowels, 4, Vowel::A, 3.4, 3.6);
+    expect(vowels.size() == 5, "vowel count", static_cast<int64_t>(vowels.size()), 5);
+
+    if (failures > 0) {
+        std::printf("%d timing checks failed\n", failures);
+        return 1;
+    }
+    std::printf("Word times stay on the decoder timeline across utterances\n");
+    return 0;
+}
@@ -0,0 +1,107 @@
+// Checks every SIMD kernel table this CPU supports against the scalar
+// kernels: selectSimdKernels() switches to each level in turn and
+// windowEnergy, magnitude and dotProduct are compared on random data for
+// lengths around the vector widths (0-67), which exercises the remainder
+// loops, and for the frame sizes the detector uses. The data starts one
+// element past an aligned address so unaligned loads are covered too.
+// Exits with 1 and lists the mismatches if any kernel is off.
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <cstdio>
+#include <random>
+#include <vector>
+#include "../audio/simd_kernels.h"
+
+namespace {
+
+int failures = 0;
+
+// Float sums are accumulated in a different order per instruction set
+const float TOLERANCE = 1e-5f;
+
+bool close(float value, float reference, float scale) {
+    return std::fabs(value - reference) <= TOLERANCE * std::max(scale, 1.0f);
+}
+
+void expect(bool condition, const SimdKernels& kernels, const char* kernel, size_t size, float value, float reference) {
+    if (!condition) {
+        std::printf("FAIL %s %s, size %zu: %g, scalar %g\n", kernels.name, kernel, size, value, reference);
+        failures++;
+    }
+}
+
+void testSize(const SimdKernels& kernels, size_t size, std::mt19937& random) {
+    const SimdKernels& scalar = scalarKernels();
+    std::uniform_int_distribution<int> sample(-32768, 32767);
+    std::uniform_real_distribution<float> value(-1.0f, 1.0f);
+
+    std::vector<short> input(size + 1);
+    std::vector<float> window(size + 1), a(size + 1), b(size + 1);
+    std::vector<std::complex<float>> bins(size + 1);
+    for (size_t i = 0; i <= size; i++) {
+        input[i] = static_cast<short>(sample(random));
+        window[i] = value(random);
+        a[i] = value(random);
+        b[i] = value(random);
+        bins[i] = std::complex<float>(value(random) * 1000.0f, value(random) * 1000.0f);
+    }
+
+    std::vector<float> output(size + 1), reference(size + 1);
+    float energy = kernels.windowEnergy(input.data() + 1, window.data() + 1, output.data() + 1, size);
+    float referenceEnergy = scalar.windowEnergy(input.data() + 1, window.data() + 1, reference.data() + 1, size);
+    expect(close(energy, referenceEnergy, referenceEnergy), kernels, "windowEnergy", size, energy, referenceEnergy);
+    for (size_t i = 1; i <= size; i++) {
+        if (!close(output[i], reference[i], std::fabs(reference[i]))) {
+            expect(false, kernels, "windowEnergy output", size, output[i], reference[i]);
+            break;
+        }
+    }
+
+    kernels.magnitude(bins.data() + 1, output.data() + 1, size);
+    scalar.magnitude(bins.data() + 1, reference.data() + 1, size);
+    for (size_t i = 1; i <= size; i++) {
+        if (!close(output[i], reference[i], reference[i])) {
+            expect(false, kernels, "magnitude", size, output[i], reference[i]);
+            break;
+        }
+    }
+
+    // The error of a sum grows with the sum of the magnitudes, not the result
+    float dot = kernels.dotProduct(a.data() + 1, b.data() + 1, size);
+    float referenceDot = scalar.dotProduct(a.data() + 1, b.data() + 1, size);
+    float scale = 0.0f;
+    for (size_t i = 1; i <= size; i++) {
+        scale += std::fabs(a[i] * b[i]);
+    }
+    expect(close(dot, referenceDot, scale), kernels, "dotProduct", size, dot, referenceDot);
+}
+
+} // namespace
+
+int main() {
+    std::mt19937 random(42);
+    int levelsTested = 0;
+    for (SimdLevel level : {SimdLevel::Scalar, SimdLevel::Sse2, SimdLevel::Avx2, SimdLevel::Neon}) {
+        if (!selectSimdKernels(level)) {
+            std::printf("%s: not supported here, skipped\n", simdLevelName(level));
+            continue;
+        }
+        const SimdKernels& kernels = simdKernels();
+        for (size_t size = 0; size < 68; size++) {
+            testSize(kernels, size, random);
+        }
+        for (size_t size : {256, 512, 1024, 2048}) {
+            testSize(kernels, size, random);
+        }
+        std::printf("%s: checked\n", kernels.name);
+        levelsTested++;
+    }
+    selectSimdKernels(detectSimdLevel());
+
+    if (failures > 0) {
+        std::printf("%d kernel checks failed\n", failures);
+        return 1;
+    }
+    return levelsTested > 0 ? 0 : 1;
+}
@@ -0,0 +1,93 @@
+// Checks that a StreamSession hands its recognizer back to the RecognizerPool
+// as soon as its stream has ended, not only when the session is destroyed:
+// several streams of synthetic speech run one after another on a shared pool
+// while every session is kept alive, as the server's bookkeeping may do, and
+// all of them must decode with the one recognizer created for the first.
+// The Vosk API is replaced by a fake that accepts audio and recognizes nothing.
+// Exits with 1 if a stream decoded nothing or a second recognizer was created.
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <memory>
+#include <vector>
+#include "../bench/synthetic_vowels.h"
+#include "../server/stream_session.h"
+
+namespace {
+
+const int SAMPLE_RATE = 16000;
+const size_t STREAMS = 5;
+const size_t STREAM_SAMPLES = 10 * SAMPLE_RATE;
+const size_t CHUNK = 4096;
+
+std::atomic<int> liveRecognizers{0};
+
+} // namespace
+
+extern "C" {
+
+VoskModel* vosk_model_new(const char*) { return reinterpret_cast<VoskModel*>(new int(0)); }
+void vosk_model_free(VoskModel* model) { delete reinterpret_cast<int*>(model); }
+void vosk_set_log_level(int) {}
+
+VoskRecognizer* vosk_recognizer_new(VoskModel*, float) {
+    liveRecognizers++;
+    return reinterpret_cast<VoskRecognizer*>(new int(0));
+}
+
+VoskRecognizer* vosk_recognizer_new_grm(VoskModel* model, float sampleRate, const char*) {
+    return vosk_recognizer_new(model, sampleRate);
+}
+
+void vosk_recognizer_free(VoskRecognizer* recognizer) {
+    liveRecognizers--;
+    delete reinterpret_cast<int*>(recognizer);
+}
+
+void vosk_recognizer_set_words(VoskRecognizer*, int) {}
+void vosk_recognizer_set_partial_words(VoskRecognizer*, int) {}
+void vosk_recognizer_reset(VoskRecognizer*) {}
+int vosk_recognizer_accept_waveform(VoskRecognizer*, const char*, int) { return 0; }
+const char* vosk_recognizer_result(VoskRecognizer*) { return "{\"text\" : \"\"}"; }
+const char* vosk_recognizer_partial_result(VoskRecognizer*) { return "{\"partial\" : \"\"}"; }
+
+} // extern "C"
+
+int main() {
+    SynthesisSettings settings;
+    settings.sampleRate = SAMPLE_RATE;
+
+    RecognizerPool recognizers(SpeechRecognizer::loadModel("fake-model"), SpeechRecognizer::Mode::FullVocabulary);
+    WorkStealingPool pool(2);
+    StreamConfig config;
+    config.inputRate = SAMPLE_RATE;
+
+    int failures = 0;
+    std::vector<std::shared_ptr<StreamSession>> sessions;
+    std::vector<short> audio(STREAM_SAMPLES);
+    for (size_t stream = 0; stream < STREAMS; stream++) {
+        VowelSynthesizer(settings, static_cast<uint32_t>(stream + 1)).generate(audio.data(), audio.size());
+        auto session = std::make_shared<StreamSession>(static_cast<int>(stream), config, recognizers, pool,
+                                                       [](const std::string&) {});
+        sessions.push_back(session);
+        for (size_t offset = 0; offset < audio.size(); offset += CHUNK) {
+            session->feed(audio.data() + offset, std::min(CHUNK, audio.size() - offset));
+        }
+        session->finish();
+        pool.waitIdle();
+
+        if (!session->isDone() || session->decodedSamples() == 0) {
+            std::printf("FAIL stream %zu: done %d, %llu samples decoded\n", stream, session->isDone() ? 1 : 0,
+                        static_cast<unsigned long long>(session->decodedSamples()));
+            failures++;
+        }
+    }
+
+    std::printf("%zu streams, %zu recognizers created, %d alive\n", STREAMS, recognizers.createdCount(),
+                liveRecognizers.load());
+    if (recognizers.createdCount() != 1) {
+        std::printf("FAIL finished streams kept their recognizers\n");
+        failures++;
+    }
+    return failures > 0 ? 1 : 0;
+}